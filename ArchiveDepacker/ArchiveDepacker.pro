@@ -8,3 +8,5 @@ SOURCES+= \
 
 HEADERS+= \
 	../Common/files.hpp \
+
+unix: LIBS+= -lpthread
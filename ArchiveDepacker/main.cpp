@@ -1,7 +1,11 @@
+#include <atomic>
+#include <cctype>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "../Common/files.hpp"
@@ -42,10 +46,167 @@ static void DepackFileInfo( const FileInfoPacked& file_info_packed, FileInfo& ou
 	out_file_info.offset= LittleInt4( out_file_info.offset );
 }
 
+// Case-insensitive matching with "*" and "?" wildcards.
+static bool MatchPattern( const char* const name, const char* const pattern )
+{
+	if( *pattern == '\0' )
+		return *name == '\0';
+
+	if( *pattern == '*' )
+	{
+		for( const char* n= name; ; n++ )
+		{
+			if( MatchPattern( n, pattern + 1 ) )
+				return true;
+			if( *n == '\0' )
+				return false;
+		}
+	}
+
+	if( *name == '\0' )
+		return false;
+
+	if( *pattern == '?' || std::toupper( static_cast<unsigned char>(*pattern) ) == std::toupper( static_cast<unsigned char>(*name) ) )
+		return MatchPattern( name + 1, pattern + 1 );
+
+	return false;
+}
+
+static std::string GetOutFileName( const char* const out_dir, const char* const file_name )
+{
+	std::string out_file_name( out_dir );
+	if( !out_file_name.empty() && out_file_name.back() != '/' )
+		out_file_name+= "/";
+	out_file_name+= file_name;
+	return out_file_name;
+}
+
+// Maps archive into memory and writes files directly from mapping, using several threads.
+static int ExtractParallel(
+	const char* const archive_file_name,
+	const char* const out_dir,
+	const char* const pattern,
+	unsigned int threads_count )
+{
+	const MemoryMappedFile archive( archive_file_name );
+	if( !archive.IsValid() )
+	{
+		std::cout << "Could not read file \"" << archive_file_name << "\"" << std::endl;
+		return -1;
+	}
+
+	const unsigned char* const archive_data= archive.Data();
+	const unsigned int archive_size= archive.Size();
+
+	const unsigned int c_header_size= 4u + sizeof(unsigned short);
+	if( archive_size < c_header_size || std::strncmp( reinterpret_cast<const char*>(archive_data), "CSid", 4u ) != 0 )
+	{
+		std::cout << "File \"" << archive_file_name << "\" is not \"Chasm: The Rift\" archive" << std::endl;
+		return -1;
+	}
+
+	unsigned short files_in_archive_count;
+	std::memcpy( &files_in_archive_count, archive_data + 4u, sizeof(files_in_archive_count) );
+	files_in_archive_count= LittleInt2(files_in_archive_count);
+
+	if( c_header_size + files_in_archive_count * sizeof(FileInfoPacked) > archive_size )
+	{
+		std::cout << "File \"" << archive_file_name << "\" is broken" << std::endl;
+		return -1;
+	}
+
+	std::cout << "Files count: " << files_in_archive_count << std::endl << std::endl;
+
+	std::vector<FileInfo> files_info;
+	files_info.reserve( files_in_archive_count );
+	for( unsigned int i= 0u; i < files_in_archive_count; i++ )
+	{
+		FileInfoPacked file_info_packed;
+		std::memcpy( &file_info_packed, archive_data + c_header_size + i * sizeof(FileInfoPacked), sizeof(FileInfoPacked) );
+		if( file_info_packed.name_length > g_file_name_length )
+			file_info_packed.name_length= g_file_name_length;
+
+		FileInfo file_info;
+		DepackFileInfo( file_info_packed, file_info );
+
+		if( pattern != nullptr && !MatchPattern( file_info.name, pattern ) )
+			continue;
+
+		if( file_info.offset > archive_size || file_info.size > archive_size - file_info.offset )
+		{
+			std::cout << "File \"" << file_info.name << "\" is out of archive bounds" << std::endl;
+			continue;
+		}
+
+		files_info.push_back( file_info );
+	}
+
+	if( threads_count == 0u )
+		threads_count= std::thread::hardware_concurrency();
+	if( threads_count == 0u )
+		threads_count= 1u;
+
+	std::atomic<unsigned int> next_file_index{ 0u };
+	std::atomic<unsigned int> failed_files_count{ 0u };
+	std::mutex output_mutex;
+
+	const auto worker_func=
+	[&]
+	{
+		while(true)
+		{
+			const unsigned int index= next_file_index++;
+			if( index >= files_info.size() )
+				return;
+
+			const FileInfo& file_info= files_info[index];
+			const std::string out_file_name= GetOutFileName( out_dir, file_info.name );
+
+			std::FILE* const file_to_save= std::fopen( out_file_name.c_str(), "wb" );
+			if( file_to_save == nullptr )
+			{
+				failed_files_count++;
+				std::lock_guard<std::mutex> lock( output_mutex );
+				std::cout << "Could not write file \"" << out_file_name << "\"" << std::endl;
+				continue;
+			}
+
+			// Write whole file at once, without copying into stdio buffer.
+			std::setvbuf( file_to_save, nullptr, _IONBF, 0u );
+			const bool written= FileWrite( file_to_save, archive_data + file_info.offset, file_info.size );
+			const bool closed= std::fclose( file_to_save ) == 0;
+
+			std::lock_guard<std::mutex> lock( output_mutex );
+			if( written && closed )
+				std::cout << "Write \"" << file_info.name << "\"" << std::endl;
+			else
+			{
+				failed_files_count++;
+				std::cout << "Could not write file \"" << out_file_name << "\"" << std::endl;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for( unsigned int i= 1u; i < threads_count; i++ )
+		threads.emplace_back( worker_func );
+	worker_func();
+
+	for( std::thread& thread : threads )
+		thread.join();
+
+	std::cout << std::endl << "Written " << ( files_info.size() - failed_files_count ) << " files, using " << threads_count << " threads" << std::endl;
+
+	return failed_files_count == 0u ? 0 : -1;
+}
+
 int main(const int argc, const char* const argv[])
 {
 	const char* archive_file_name= "CSM.BIN";
 	const char* out_dir= "";
+	const char* pattern= nullptr;
+	bool parallel= false;
+	unsigned int threads_count= 0u;
 
 	for( int i= 1; i < argc; i++ )
 	{
@@ -64,8 +225,26 @@ int main(const int argc, const char* const argv[])
 			else
 				std::cout << "Error, expected directory, after -o" << std::endl;
 		}
+		else if( std::strcmp( arg, "-f" ) == 0 )
+		{
+			if( i < argc - 1 )
+				pattern= argv[ i + 1 ];
+			else
+				std::cout << "Error, expected pattern, after -f" << std::endl;
+		}
+		else if( std::strcmp( arg, "-j" ) == 0 )
+		{
+			parallel= true;
+			if( i < argc - 1 )
+				threads_count= std::atoi( argv[ i + 1 ] );
+			else
+				std::cout << "Error, expected threads count, after -j" << std::endl;
+		}
 	}
 
+	if( parallel )
+		return ExtractParallel( archive_file_name, out_dir, pattern, threads_count );
+
 	std::FILE* const file= std::fopen( archive_file_name, "rb" );
 	if( file == nullptr )
 	{
@@ -92,12 +271,16 @@ int main(const int argc, const char* const argv[])
 	FileRead( file, files_info_packed.data(), files_info_packed.size() * sizeof(FileInfoPacked ) );
 
 	std::vector<unsigned char> file_buffer;
+	unsigned int failed_files_count= 0u;
 
 	for( const FileInfoPacked& file_info_packed : files_info_packed )
 	{
 		FileInfo file_info;
 		DepackFileInfo( file_info_packed, file_info );
 
+		if( pattern != nullptr && !MatchPattern( file_info.name, pattern ) )
+			continue;
+
 		file_buffer.resize( file_info.size );
 
 		std::fseek( file, file_info.offset, SEEK_SET );
@@ -105,21 +288,25 @@ int main(const int argc, const char* const argv[])
 
 		std::cout << "Write \"" << file_info.name << "\"" << std::endl;
 
-		std::string out_file_name( out_dir );
-		if( !out_file_name.empty() && out_file_name.back() != '/' )
-			out_file_name+= "/";
-		out_file_name+= file_info.name;
+		const std::string out_file_name= GetOutFileName( out_dir, file_info.name );
 
 		std::FILE* file_to_save= std::fopen( out_file_name.c_str(), "wb" );
 		if( file_to_save == nullptr )
 		{
+			failed_files_count++;
 			std::cout << "Could not write file \"" << out_file_name << "\"" << std::endl;
 			continue;
 		}
 
-		FileWrite( file_to_save, file_buffer.data(), file_buffer.size() );
-		std::fclose( file_to_save );
+		const bool written= FileWrite( file_to_save, file_buffer.data(), file_buffer.size() );
+		if( std::fclose( file_to_save ) != 0 || !written )
+		{
+			failed_files_count++;
+			std::cout << "Could not write file \"" << out_file_name << "\"" << std::endl;
+		}
 	}
 
 	std::fclose( file );
+
+	return failed_files_count == 0u ? 0 : -1;
 }
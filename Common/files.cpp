@@ -1,3 +1,13 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "files.hpp"
 
 namespace ChasmReverse
@@ -17,7 +27,7 @@ void FileRead( std::FILE* const file, void* buffer, const unsigned int size )
 	} while( read_total < size );
 }
 
-void FileWrite( std::FILE* const file, const void* buffer, const unsigned int size )
+bool FileWrite( std::FILE* const file, const void* buffer, const unsigned int size )
 {
 	unsigned int write_total= 0u;
 
@@ -29,7 +39,144 @@ void FileWrite( std::FILE* const file, const void* buffer, const unsigned int si
 
 		write_total+= write;
 	} while( write_total < size );
+
+	return write_total == size;
+}
+
+static void ForEachFileInDirectoryImpl(
+	const std::string& directory_path,
+	const std::string& relative_path,
+	const DirectoryFileFunc& func )
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA find_data;
+	const HANDLE find_handle= ::FindFirstFileA( ( directory_path + relative_path + "*" ).c_str(), &find_data );
+	if( find_handle == INVALID_HANDLE_VALUE )
+		return;
+
+	do
+	{
+		const std::string name= find_data.cFileName;
+		if( name == "." || name == ".." )
+			continue;
+
+		if( ( find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0 )
+			ForEachFileInDirectoryImpl( directory_path, relative_path + name + "/", func );
+		else
+			func( relative_path + name );
+	} while( ::FindNextFileA( find_handle, &find_data ) );
+
+	::FindClose( find_handle );
+#else
+	DIR* const dir= ::opendir( ( directory_path + relative_path ).c_str() );
+	if( dir == nullptr )
+		return;
+
+	while( const dirent* const entry= ::readdir( dir ) )
+	{
+		const std::string name= entry->d_name;
+		if( name == "." || name == ".." )
+			continue;
+
+		struct stat file_stat;
+		if( ::stat( ( directory_path + relative_path + name ).c_str(), &file_stat ) != 0 )
+			continue;
+
+		if( S_ISDIR( file_stat.st_mode ) )
+			ForEachFileInDirectoryImpl( directory_path, relative_path + name + "/", func );
+		else if( S_ISREG( file_stat.st_mode ) )
+			func( relative_path + name );
+	}
+
+	::closedir( dir );
+#endif
+}
+
+void ForEachFileInDirectory( const char* const directory_path, const DirectoryFileFunc& func )
+{
+	std::string path= directory_path;
+	if( !path.empty() && !( path.back() == '/' || path.back() == '\\' ) )
+		path.push_back( '/' );
+
+	ForEachFileInDirectoryImpl( path, "", func );
+}
+
+MemoryMappedFile::MemoryMappedFile( const char* const file_name )
+{
+#ifdef _WIN32
+	const HANDLE file_handle=
+		::CreateFileA( file_name, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( file_handle == INVALID_HANDLE_VALUE )
+		return;
+	file_handle_= file_handle;
+
+	const DWORD file_size= ::GetFileSize( file_handle, nullptr );
+	if( file_size == INVALID_FILE_SIZE || file_size == 0u )
+		return;
+
+	const HANDLE mapping_handle= ::CreateFileMappingA( file_handle, nullptr, PAGE_READONLY, 0u, 0u, nullptr );
+	if( mapping_handle == nullptr )
+		return;
+	mapping_handle_= mapping_handle;
+
+	const void* const data= ::MapViewOfFile( mapping_handle, FILE_MAP_READ, 0u, 0u, 0u );
+	if( data == nullptr )
+		return;
+
+	data_= static_cast<const unsigned char*>(data);
+	size_= file_size;
+#else
+	const int fd= ::open( file_name, O_RDONLY );
+	if( fd == -1 )
+		return;
+
+	struct stat file_stat;
+	if( ::fstat( fd, &file_stat ) != 0 || file_stat.st_size <= 0 )
+	{
+		::close( fd );
+		return;
+	}
+
+	void* const data= ::mmap( nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	// Mapping stays valid after descriptor closing.
+	::close( fd );
+
+	if( data == MAP_FAILED )
+		return;
+
+	data_= static_cast<const unsigned char*>(data);
+	size_= static_cast<unsigned int>(file_stat.st_size);
+#endif
 }
 
+MemoryMappedFile::~MemoryMappedFile()
+{
+#ifdef _WIN32
+	if( data_ != nullptr )
+		::UnmapViewOfFile( data_ );
+	if( mapping_handle_ != nullptr )
+		::CloseHandle( mapping_handle_ );
+	if( file_handle_ != nullptr )
+		::CloseHandle( file_handle_ );
+#else
+	if( data_ != nullptr )
+		::munmap( const_cast<unsigned char*>(data_), size_ );
+#endif
+}
+
+bool MemoryMappedFile::IsValid() const
+{
+	return data_ != nullptr;
+}
+
+const unsigned char* MemoryMappedFile::Data() const
+{
+	return data_;
+}
+
+unsigned int MemoryMappedFile::Size() const
+{
+	return size_;
+}
 
 } // namespace ChasmReverse
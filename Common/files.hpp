@@ -1,10 +1,43 @@
 #pragma once
 #include <cstdio>
+#include <functional>
+#include <string>
 
 namespace ChasmReverse
 {
 
 void FileRead( std::FILE* const file, void* buffer, const unsigned int size );
-void FileWrite( std::FILE* const file, const void* buffer, const unsigned int size );
+// Returns false, if not all data written.
+bool FileWrite( std::FILE* const file, const void* buffer, const unsigned int size );
+
+// Calls function for each regular file in directory and its subdirectories.
+// Function gets path, relative to directory, with "/" as separator.
+typedef std::function< void( const std::string& relative_file_path ) > DirectoryFileFunc;
+void ForEachFileInDirectory( const char* directory_path, const DirectoryFileFunc& func );
+
+// Whole file, mapped into memory for reading.
+// Check IsValid() after construction, mapping may fail.
+class MemoryMappedFile final
+{
+public:
+	explicit MemoryMappedFile( const char* file_name );
+	~MemoryMappedFile();
+
+	MemoryMappedFile( const MemoryMappedFile& )= delete;
+	MemoryMappedFile& operator=( const MemoryMappedFile& )= delete;
+
+	bool IsValid() const;
+	const unsigned char* Data() const;
+	unsigned int Size() const;
+
+private:
+	const unsigned char* data_= nullptr;
+	unsigned int size_= 0u;
+
+#ifdef _WIN32
+	void* file_handle_= nullptr;
+	void* mapping_handle_= nullptr;
+#endif
+};
 
 } // namespace ChasmReverse
@@ -0,0 +1,105 @@
+include(../Common/Common.pri)
+
+# Headless build - no SDL, no OpenGL, no sound.
+DEFINES+= PC_HEADLESS
+
+win32 {
+	# Windows sockets 2 (ws2_32.lib).
+	LIBS+= libws2_32
+}
+else {
+	LIBS+= -lpthread
+}
+
+CONFIG( debug, debug|release ) {
+	DEFINES+= DEBUG
+}
+
+INCLUDEPATH+= ../panzer_ogl_lib
+INCLUDEPATH+= ../PanzerChasm
+
+SOURCES+= \
+	main.cpp \
+
+SOURCES+= \
+	../Common/files.cpp \
+	../PanzerChasm/commands_processor.cpp \
+	../PanzerChasm/connection_info.cpp \
+	../PanzerChasm/game_resources.cpp \
+	../PanzerChasm/images.cpp \
+	../PanzerChasm/log.cpp \
+	../PanzerChasm/map_cache.cpp \
+	../PanzerChasm/map_loader.cpp \
+	../PanzerChasm/math_utils.cpp \
+	../PanzerChasm/messages.cpp \
+	../PanzerChasm/messages_extractor.cpp \
+	../PanzerChasm/messages_sender.cpp \
+	../PanzerChasm/model.cpp \
+	../PanzerChasm/net/net.cpp \
+	../PanzerChasm/obj.cpp \
+	../PanzerChasm/program_arguments.cpp \
+	../PanzerChasm/rand.cpp \
+	../PanzerChasm/save_load_streams.cpp \
+	../PanzerChasm/server/collisions.cpp \
+	../PanzerChasm/server/collision_index.cpp \
+	../PanzerChasm/server/delta_snapshots.cpp \
+	../PanzerChasm/server/map.cpp \
+	../PanzerChasm/server/map_save_load.cpp \
+	../PanzerChasm/server/monster.cpp \
+	../PanzerChasm/server/monster_base.cpp \
+	../PanzerChasm/server/monsters_index.cpp \
+	../PanzerChasm/server/movement_restriction.cpp \
+	../PanzerChasm/server/navigation.cpp \
+	../PanzerChasm/server/player.cpp \
+	../PanzerChasm/server/player_interest.cpp \
+	../PanzerChasm/server/server.cpp \
+	../PanzerChasm/server/tick_profiler.cpp \
+	../PanzerChasm/server/visibility_matrix.cpp \
+	../PanzerChasm/settings.cpp \
+	../PanzerChasm/thread_pool.cpp \
+	../PanzerChasm/time.cpp \
+	../PanzerChasm/vfs.cpp \
+	../panzer_ogl_lib/matrix.cpp \
+
+HEADERS+= \
+	../Common/files.hpp \
+	../PanzerChasm/commands_processor.hpp \
+	../PanzerChasm/connection_info.hpp \
+	../PanzerChasm/game_resources.hpp \
+	../PanzerChasm/images.hpp \
+	../PanzerChasm/log.hpp \
+	../PanzerChasm/map_cache.hpp \
+	../PanzerChasm/map_loader.hpp \
+	../PanzerChasm/math_utils.hpp \
+	../PanzerChasm/messages.hpp \
+	../PanzerChasm/messages_extractor.hpp \
+	../PanzerChasm/messages_extractor.inl \
+	../PanzerChasm/messages_sender.hpp \
+	../PanzerChasm/model.hpp \
+	../PanzerChasm/net/net.hpp \
+	../PanzerChasm/obj.hpp \
+	../PanzerChasm/program_arguments.hpp \
+	../PanzerChasm/rand.hpp \
+	../PanzerChasm/save_load_streams.hpp \
+	../PanzerChasm/server/active_zones.hpp \
+	../PanzerChasm/server/collisions.hpp \
+	../PanzerChasm/server/collision_index.hpp \
+	../PanzerChasm/server/delta_snapshots.hpp \
+	../PanzerChasm/server/map.hpp \
+	../PanzerChasm/server/monster.hpp \
+	../PanzerChasm/server/monster_base.hpp \
+	../PanzerChasm/server/monsters_index.hpp \
+	../PanzerChasm/server/movement_restriction.hpp \
+	../PanzerChasm/server/navigation.hpp \
+	../PanzerChasm/server/player.hpp \
+	../PanzerChasm/server/player_interest.hpp \
+	../PanzerChasm/server/server.hpp \
+	../PanzerChasm/server/tick_profiler.hpp \
+	../PanzerChasm/server/timer_wheel.hpp \
+	../PanzerChasm/server/visibility_matrix.hpp \
+	../PanzerChasm/settings.hpp \
+	../PanzerChasm/shared_settings_keys.hpp \
+	../PanzerChasm/thread_pool.hpp \
+	../PanzerChasm/time.hpp \
+	../PanzerChasm/vfs.hpp \
+	../panzer_ogl_lib/matrix.hpp \
@@ -0,0 +1,157 @@
+// Headless dedicated server.
+// Does not use SDL, OpenGL or sound. Runs server loop with fixed rate and sleeps between loops.
+//
+// Usage:
+// DedicatedServer [--cfg file.cfg] [--csm CSM.BIN] [--addon addon_path] [--map N] [--difficulty 0|1|2] [--coop] [--port N] [--udp-port N]
+// Command line arguments override values from config file.
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <thread>
+
+#include "../PanzerChasm/assert.hpp"
+#include "../PanzerChasm/commands_processor.hpp"
+#include "../PanzerChasm/game_constants.hpp"
+#include "../PanzerChasm/game_resources.hpp"
+#include "../PanzerChasm/log.hpp"
+#include "../PanzerChasm/map_loader.hpp"
+#include "../PanzerChasm/net/net.hpp"
+#include "../PanzerChasm/program_arguments.hpp"
+#include "../PanzerChasm/server/server.hpp"
+#include "../PanzerChasm/settings.hpp"
+#include "../PanzerChasm/shared_settings_keys.hpp"
+#include "../PanzerChasm/vfs.hpp"
+using namespace PanzerChasm;
+
+namespace
+{
+
+volatile std::sig_atomic_t g_quit_requested= 0;
+
+} // namespace
+
+static void QuitSignalHandler( const int signal )
+{
+	PC_UNUSED( signal );
+	g_quit_requested= 1;
+}
+
+static DifficultyType DifficultyNumberToDifficulty( const int n )
+{
+	switch( n )
+	{
+	case 0: return Difficulty::Easy;
+	case 1: return Difficulty::Normal;
+	case 2: return Difficulty::Hard;
+	default: return Difficulty::Normal;
+	};
+}
+
+// Returns command line argument value, if it exists, else value from settings.
+static int GetIntParam(
+	const ProgramArguments& program_arguments, Settings& settings,
+	const char* const param_name, const char* const settings_key, const int default_value )
+{
+	if( const char* const value_str= program_arguments.GetParamValue( param_name ) )
+		return std::atoi( value_str );
+	return settings.GetOrSetInt( settings_key, default_value );
+}
+
+int main( const int argc, const char* const argv[] )
+{
+	// Skip first param - program path.
+	const ProgramArguments program_arguments( argc - 1, argv + 1 );
+
+	const char* cfg_file= "PanzerChasmServer.cfg";
+	if( const char* const overrided_cfg_file= program_arguments.GetParamValue( "cfg" ) )
+		cfg_file= overrided_cfg_file;
+
+	Settings settings( cfg_file );
+	CommandsProcessor commands_processor( settings );
+
+	const unsigned int map_number=
+		static_cast<unsigned int>( std::max( 1, GetIntParam( program_arguments, settings, "map", SettingsKeys::server_map, 1 ) ) );
+	const DifficultyType difficulty=
+		DifficultyNumberToDifficulty( GetIntParam( program_arguments, settings, "difficulty", SettingsKeys::server_difficulty, 1 ) );
+	const GameRules game_rules=
+		program_arguments.HasParam( "coop" ) || settings.GetOrSetBool( SettingsKeys::server_cooperative, false )
+			? GameRules::Cooperative
+			: GameRules::Deathmatch;
+	const uint16_t tcp_port=
+		static_cast<uint16_t>( GetIntParam( program_arguments, settings, "port", SettingsKeys::server_tcp_port, Net::c_default_server_tcp_port ) );
+	const uint16_t udp_base_port=
+		static_cast<uint16_t>( GetIntParam( program_arguments, settings, "udp-port", SettingsKeys::server_udp_base_port, Net::c_default_server_udp_base_port ) );
+
+	const int loops_per_second=
+		std::max( GameConstants::min_server_loops_per_second, std::min(
+			settings.GetOrSetInt( SettingsKeys::server_loops_per_second, 60 ),
+			GameConstants::max_server_loops_per_second ) );
+
+	VfsPtr vfs;
+	{
+		const char* csm_file= "CSM.BIN";
+		if( const char* const overrided_csm_file= program_arguments.GetParamValue( "csm" ) )
+			csm_file= overrided_csm_file;
+
+		const char* const addon_path= program_arguments.GetParamValue( "addon" );
+
+		Log::Info( "Read game archive" );
+		vfs= std::make_shared<Vfs>( csm_file, addon_path );
+	}
+
+	Log::Info( "Loading game resources" );
+	const GameResourcesConstPtr game_resources= LoadGameResources( vfs );
+	const MapLoaderPtr map_loader= std::make_shared<MapLoader>( vfs );
+
+	Net net;
+	const IConnectionsListenerPtr listener= net.CreateServerListener( tcp_port, udp_base_port );
+	if( listener == nullptr )
+	{
+		Log::Warning( "Can not start server: network error." );
+		return -1;
+	}
+
+	Server server(
+		commands_processor,
+		game_resources,
+		map_loader,
+		listener,
+		DrawLoadingCallback() );
+
+	if( !server.ChangeMap( map_number, difficulty, game_rules ) )
+		return -1;
+
+	std::signal( SIGINT, QuitSignalHandler );
+	std::signal( SIGTERM, QuitSignalHandler );
+
+	Log::Info( "Server started on port ", tcp_port, ", ", loops_per_second, " loops per second" );
+
+	const std::chrono::steady_clock::duration loop_duration=
+		std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>( 1.0 / double(loops_per_second) ) );
+
+	std::chrono::steady_clock::time_point next_loop_time= std::chrono::steady_clock::now();
+	while( g_quit_requested == 0 )
+	{
+		server.Loop( false );
+
+		// Nobody shows messages from other threads, just drop them. They are already written into log.
+		Log::FlushDeferredMessages();
+
+		next_loop_time+= loop_duration;
+
+		// Server is too slow. Do not try to catch up here - server makes multiple map ticks for long loops itself.
+		const std::chrono::steady_clock::time_point current_time= std::chrono::steady_clock::now();
+		if( next_loop_time < current_time )
+			next_loop_time= current_time;
+
+		std::this_thread::sleep_until( next_loop_time );
+	}
+
+	Log::Info( "Stopping server" );
+	server.DisconnectAllClients();
+
+	return 0;
+}
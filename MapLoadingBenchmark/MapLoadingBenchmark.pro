@@ -0,0 +1,54 @@
+include(../Common/Common.pri)
+
+# Headless build - benchmark uses only Vfs and MapLoader, so, SDL is not needed.
+DEFINES+= PC_HEADLESS
+
+win32 {
+	LIBS+= libpsapi
+}
+else {
+	LIBS+= -lpthread
+}
+
+INCLUDEPATH+= ../panzer_ogl_lib
+
+SOURCES+= \
+	main.cpp \
+
+SOURCES+= \
+	../Common/files.cpp \
+	../PanzerChasm/game_resources.cpp \
+	../PanzerChasm/images.cpp \
+	../PanzerChasm/log.cpp \
+	../PanzerChasm/map_cache.cpp \
+	../PanzerChasm/map_loader.cpp \
+	../PanzerChasm/math_utils.cpp \
+	../PanzerChasm/model.cpp \
+	../PanzerChasm/obj.cpp \
+	../PanzerChasm/program_arguments.cpp \
+	../PanzerChasm/server/collisions.cpp \
+	../PanzerChasm/server/collision_index.cpp \
+	../PanzerChasm/server/visibility_matrix.cpp \
+	../PanzerChasm/thread_pool.cpp \
+	../PanzerChasm/time.cpp \
+	../PanzerChasm/vfs.cpp \
+	../panzer_ogl_lib/matrix.cpp \
+
+HEADERS+= \
+	../Common/files.hpp \
+	../PanzerChasm/game_resources.hpp \
+	../PanzerChasm/images.hpp \
+	../PanzerChasm/log.hpp \
+	../PanzerChasm/map_cache.hpp \
+	../PanzerChasm/map_loader.hpp \
+	../PanzerChasm/math_utils.hpp \
+	../PanzerChasm/model.hpp \
+	../PanzerChasm/obj.hpp \
+	../PanzerChasm/program_arguments.hpp \
+	../PanzerChasm/server/collisions.hpp \
+	../PanzerChasm/server/collision_index.hpp \
+	../PanzerChasm/server/collision_index.inl \
+	../PanzerChasm/server/visibility_matrix.hpp \
+	../PanzerChasm/thread_pool.hpp \
+	../PanzerChasm/time.hpp \
+	../PanzerChasm/vfs.hpp \
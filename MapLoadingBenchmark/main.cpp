@@ -0,0 +1,302 @@
+// Map loading benchmark.
+// Loads each map several times and measures time of each loading stage, memory allocations and peak memory usage.
+// Results are printed to console and written in JSON format into output file.
+//
+// Usage:
+// MapLoadingBenchmark [--csm CSM.BIN] [--addon addon_path] [--iterations N] [--map N] [--disk-cache] [--output file.json]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../PanzerChasm/log.hpp"
+#include "../PanzerChasm/map_loader.hpp"
+#include "../PanzerChasm/program_arguments.hpp"
+#include "../PanzerChasm/vfs.hpp"
+using namespace PanzerChasm;
+
+namespace
+{
+
+std::atomic<uint64_t> g_allocations_count{ 0u };
+std::atomic<uint64_t> g_allocated_bytes{ 0u };
+
+const unsigned int g_max_map_number= 99u;
+
+struct TimeStats
+{
+	double min_s= 0.0;
+	double max_s= 0.0;
+	double total_s= 0.0;
+	unsigned int count= 0u;
+
+	void Add( const double time_s )
+	{
+		min_s= count == 0u ? time_s : std::min( min_s, time_s );
+		max_s= count == 0u ? time_s : std::max( max_s, time_s );
+		total_s+= time_s;
+		count++;
+	}
+
+	double GetAverage() const
+	{
+		return count == 0u ? 0.0 : total_s / double(count);
+	}
+};
+
+struct StageStats
+{
+	std::string name;
+	TimeStats time;
+};
+
+struct MapStats
+{
+	unsigned int number;
+	TimeStats total_time;
+	std::vector<StageStats> stages; // In order of execution.
+	uint64_t allocations_count= 0u;
+	uint64_t allocated_bytes= 0u;
+};
+
+} // namespace
+
+// Count all allocations for statistics.
+void* operator new( const std::size_t size )
+{
+	g_allocations_count++;
+	g_allocated_bytes+= size;
+
+	if( void* const ptr= std::malloc( size == 0u ? 1u : size ) )
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete( void* const ptr ) noexcept
+{
+	std::free( ptr );
+}
+
+void operator delete( void* const ptr, std::size_t ) noexcept
+{
+	std::free( ptr );
+}
+
+static uint64_t GetPeakMemoryUsageKb()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof(counters) ) )
+		return counters.PeakWorkingSetSize / 1024u;
+	return 0u;
+#else
+	rusage usage;
+	if( getrusage( RUSAGE_SELF, &usage ) != 0 )
+		return 0u;
+	#ifdef __APPLE__
+	return usage.ru_maxrss / 1024u; // In bytes on Mac OS.
+	#else
+	return usage.ru_maxrss; // In kilobytes on Linux.
+	#endif
+#endif
+}
+
+static bool MapExists( const Vfs& vfs, const unsigned int map_number )
+{
+	char map_file_name[ MapData::c_max_file_path_size ];
+	std::snprintf( map_file_name, sizeof(map_file_name), "LEVEL%02u/MAP.%02u", map_number, map_number );
+	return !vfs.ReadFileView( map_file_name ).empty();
+}
+
+static void WriteTimeStats( std::FILE* const f, const TimeStats& stats )
+{
+	std::fprintf(
+		f,
+		"{ \"min_ms\": %.4f, \"avg_ms\": %.4f, \"max_ms\": %.4f }",
+		stats.min_s * 1000.0, stats.GetAverage() * 1000.0, stats.max_s * 1000.0 );
+}
+
+static bool WriteJson(
+	const char* const file_name,
+	const unsigned int iterations,
+	const bool disk_cache,
+	const std::vector<MapStats>& maps_stats,
+	const uint64_t peak_memory_usage_kb )
+{
+	std::FILE* const f= std::fopen( file_name, "w" );
+	if( f == nullptr )
+		return false;
+
+	std::fprintf( f, "{\n" );
+	std::fprintf( f, "\t\"iterations\": %u,\n", iterations );
+	std::fprintf( f, "\t\"disk_cache\": %s,\n", disk_cache ? "true" : "false" );
+	std::fprintf( f, "\t\"peak_rss_kb\": %llu,\n", static_cast<unsigned long long>(peak_memory_usage_kb) );
+	std::fprintf( f, "\t\"maps\":\n\t[\n" );
+
+	for( unsigned int m= 0u; m < maps_stats.size(); m++ )
+	{
+		const MapStats& map_stats= maps_stats[m];
+		const unsigned int count= std::max( map_stats.total_time.count, 1u );
+
+		std::fprintf( f, "\t\t{\n" );
+		std::fprintf( f, "\t\t\t\"number\": %u,\n", map_stats.number );
+		std::fprintf( f, "\t\t\t\"total\": " );
+		WriteTimeStats( f, map_stats.total_time );
+		std::fprintf( f, ",\n" );
+		std::fprintf( f, "\t\t\t\"allocations_per_load\": %llu,\n", static_cast<unsigned long long>( map_stats.allocations_count / count ) );
+		std::fprintf( f, "\t\t\t\"allocated_bytes_per_load\": %llu,\n", static_cast<unsigned long long>( map_stats.allocated_bytes / count ) );
+		std::fprintf( f, "\t\t\t\"stages\":\n\t\t\t{\n" );
+
+		for( unsigned int s= 0u; s < map_stats.stages.size(); s++ )
+		{
+			std::fprintf( f, "\t\t\t\t\"%s\": ", map_stats.stages[s].name.c_str() );
+			WriteTimeStats( f, map_stats.stages[s].time );
+			std::fprintf( f, s + 1u < map_stats.stages.size() ? ",\n" : "\n" );
+		}
+
+		std::fprintf( f, "\t\t\t}\n" );
+		std::fprintf( f, m + 1u < maps_stats.size() ? "\t\t},\n" : "\t\t}\n" );
+	}
+
+	std::fprintf( f, "\t]\n}\n" );
+
+	const bool ok= std::ferror( f ) == 0;
+	std::fclose( f );
+	return ok;
+}
+
+int main( const int argc, const char* const argv[] )
+{
+	// Skip first param - program path.
+	const ProgramArguments program_arguments( argc - 1, argv + 1 );
+
+	const char* csm_file= "CSM.BIN";
+	if( const char* const overrided_csm_file= program_arguments.GetParamValue( "csm" ) )
+		csm_file= overrided_csm_file;
+
+	const char* const addon_path= program_arguments.GetParamValue( "addon" );
+
+	unsigned int iterations= 5u;
+	if( const char* const iterations_str= program_arguments.GetParamValue( "iterations" ) )
+		iterations= std::max( std::atoi( iterations_str ), 1 );
+
+	const char* output_file= "map_loading_benchmark.json";
+	if( const char* const overrided_output_file= program_arguments.GetParamValue( "output" ) )
+		output_file= overrided_output_file;
+
+	const bool disk_cache= program_arguments.HasParam( "disk-cache" );
+
+	const VfsPtr vfs= std::make_shared<Vfs>( csm_file, addon_path );
+
+	std::vector<unsigned int> maps_numbers;
+	if( const char* const map_number_str= program_arguments.GetParamValue( "map" ) )
+		maps_numbers.push_back( static_cast<unsigned int>( std::atoi( map_number_str ) ) );
+	else
+	{
+		// Original maps and addon maps.
+		for( unsigned int m= 1u; m <= g_max_map_number; m++ )
+			if( MapExists( *vfs, m ) )
+				maps_numbers.push_back( m );
+	}
+
+	if( maps_numbers.empty() )
+	{
+		std::cout << "No maps found" << std::endl;
+		return -1;
+	}
+
+	MapStats* current_map_stats= nullptr;
+
+	MapLoader map_loader( vfs );
+	map_loader.SetMemoryCacheEnabled( false );
+	map_loader.SetDiskCacheEnabled( disk_cache );
+	map_loader.SetStageTimeCallback(
+		[&]( const char* const stage_name, const double time_s )
+		{
+			if( current_map_stats == nullptr )
+				return;
+
+			std::vector<StageStats>& stages= current_map_stats->stages;
+			auto it= std::find_if( stages.begin(), stages.end(), [&]( const StageStats& s ) { return s.name == stage_name; } );
+			if( it == stages.end() )
+			{
+				stages.emplace_back();
+				stages.back().name= stage_name;
+				it= stages.end() - 1;
+			}
+			it->time.Add( time_s );
+		} );
+
+	std::vector<MapStats> maps_stats;
+	maps_stats.reserve( maps_numbers.size() );
+
+	for( const unsigned int map_number : maps_numbers )
+	{
+		maps_stats.emplace_back();
+		current_map_stats= &maps_stats.back();
+		current_map_stats->number= map_number;
+
+		for( unsigned int i= 0u; i < iterations; i++ )
+		{
+			const uint64_t allocations_before= g_allocations_count;
+			const uint64_t allocated_bytes_before= g_allocated_bytes;
+			const auto start_time= std::chrono::steady_clock::now();
+
+			const MapDataConstPtr map_data= map_loader.LoadMap( map_number );
+
+			const auto end_time= std::chrono::steady_clock::now();
+			current_map_stats->allocations_count+= g_allocations_count - allocations_before;
+			current_map_stats->allocated_bytes+= g_allocated_bytes - allocated_bytes_before;
+
+			if( map_data == nullptr )
+			{
+				std::cout << "Can not load map " << map_number << std::endl;
+				return -1;
+			}
+
+			current_map_stats->total_time.Add( std::chrono::duration<double>( end_time - start_time ).count() );
+		}
+	}
+	current_map_stats= nullptr;
+
+	const uint64_t peak_memory_usage_kb= GetPeakMemoryUsageKb();
+
+	std::cout << std::endl << "map  avg_ms    min_ms    max_ms    allocs/load" << std::endl;
+	for( const MapStats& map_stats : maps_stats )
+	{
+		char str[128];
+		std::snprintf(
+			str, sizeof(str), "%3u  %8.3f  %8.3f  %8.3f  %llu",
+			map_stats.number,
+			map_stats.total_time.GetAverage() * 1000.0,
+			map_stats.total_time.min_s * 1000.0,
+			map_stats.total_time.max_s * 1000.0,
+			static_cast<unsigned long long>( map_stats.allocations_count / iterations ) );
+		std::cout << str << std::endl;
+	}
+	std::cout << "Peak memory usage: " << peak_memory_usage_kb << "kb" << std::endl;
+
+	if( !WriteJson( output_file, iterations, disk_cache, maps_stats, peak_memory_usage_kb ) )
+	{
+		std::cout << "Can not write \"" << output_file << "\"" << std::endl;
+		return -1;
+	}
+
+	std::cout << "Results written into \"" << output_file << "\"" << std::endl;
+
+	return 0;
+}
@@ -18,6 +18,7 @@ else {
 
 	LIBS+= -lSDL2
 	LIBS+= -lGL
+	LIBS+= -lpthread
 }
 
 CONFIG( debug, debug|release ) {
@@ -68,6 +69,7 @@ SOURCES+= \
 	log.cpp \
 	loopback_buffer.cpp \
 	main.cpp \
+	map_cache.cpp \
 	map_loader.cpp \
 	math_utils.cpp \
 	menu.cpp \
@@ -86,13 +88,20 @@ SOURCES+= \
 	save_load_streams.cpp \
 	server/collisions.cpp \
 	server/collision_index.cpp \
+	server/delta_snapshots.cpp \
 	server/map.cpp \
 	server/map_save_load.cpp \
 	server/monster.cpp \
 	server/monster_base.cpp \
+	server/monsters_index.cpp \
 	server/movement_restriction.cpp \
+	server/navigation.cpp \
 	server/player.cpp \
+	server/player_interest.cpp \
 	server/server.cpp \
+	server/server_thread.cpp \
+	server/tick_profiler.cpp \
+	server/visibility_matrix.cpp \
 	settings.cpp \
 	shared_drawers.cpp \
 	sound/ambient_sound_processor.cpp \
@@ -107,6 +116,7 @@ SOURCES+= \
 	text_drawers_common.cpp \
 	text_drawer_gl.cpp \
 	text_drawer_soft.cpp \
+	thread_pool.cpp \
 	vfs.cpp \
 
 HEADERS+= \
@@ -145,6 +155,7 @@ HEADERS+= \
 	console.hpp \
 	drawers_factory_gl.hpp \
 	drawers_factory_soft.hpp \
+	entities_container.hpp \
 	fwd.hpp \
 	game_constants.hpp \
 	game_resources.hpp \
@@ -157,6 +168,7 @@ HEADERS+= \
 	images.hpp \
 	log.hpp \
 	loopback_buffer.hpp \
+	map_cache.hpp \
 	map_loader.hpp \
 	math_utils.hpp \
 	menu.hpp \
@@ -178,17 +190,27 @@ HEADERS+= \
 	save_load.hpp \
 	save_load_streams.hpp \
 	server/a_code.hpp \
+	server/active_zones.hpp \
 	server/backpack.hpp \
 	server/collisions.hpp \
 	server/collision_index.hpp \
 	server/collision_index.inl \
+	server/delta_snapshots.hpp \
 	server/fwd.hpp \
 	server/map.hpp \
 	server/monster.hpp \
 	server/monster_base.hpp \
+	server/monsters_index.hpp \
+	server/monsters_index.inl \
 	server/movement_restriction.hpp \
+	server/navigation.hpp \
 	server/player.hpp \
+	server/player_interest.hpp \
 	server/server.hpp \
+	server/server_thread.hpp \
+	server/tick_profiler.hpp \
+	server/timer_wheel.hpp \
+	server/visibility_matrix.hpp \
 	settings.hpp \
 	shared_drawers.hpp \
 	shared_settings_keys.hpp \
@@ -206,6 +228,7 @@ HEADERS+= \
 	text_drawers_common.hpp \
 	text_drawer_gl.hpp \
 	text_drawer_soft.hpp \
+	thread_pool.hpp \
 	time.hpp \
 	vfs.hpp \
 
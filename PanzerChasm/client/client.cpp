@@ -362,6 +362,14 @@ void Client::Loop( const InputState& input_state, const bool paused )
 
 			connection_info_->messages_sender.SendUnreliableMessage( message );
 		}
+		if( map_state_ != nullptr )
+		{ // Acknowledge snapshot. Send it each frame, because unreliable messages may be lost.
+			Messages::SnapshotAck message;
+			message.sequence= map_state_->GetLastCompleteSnapshotSequence();
+			message.previous_snapshots_mask= map_state_->GetPreviousCompleteSnapshotsMask();
+			if( message.sequence != 0u )
+				connection_info_->messages_sender.SendUnreliableMessage( message );
+		}
 
 		connection_info_->messages_sender.Flush();
 	}
@@ -375,6 +383,12 @@ void Client::Draw()
 		return;
 	}
 
+	if( server_map_loading_ )
+	{
+		shared_drawers_->menu->DrawLoading( server_map_loading_progress_ );
+		return;
+	}
+
 	if( map_state_ != nullptr )
 	{
 		PC_ASSERT( current_map_data_ != nullptr );
@@ -573,6 +587,8 @@ void Client::operator()( const Messages::MapChange& message )
 {
 	Log::Info( "Changing client map to ", message.map_number );
 
+	server_map_loading_= false;
+
 	const auto show_progress=
 	[&]( const float progress )
 	{
@@ -656,6 +672,19 @@ void Client::operator()( const Messages::TextMessage& message )
 	}
 }
 
+void Client::operator()( const Messages::MapLoadingProgress& message )
+{
+	if( message.progress == 255u )
+	{
+		// Server failed to load map.
+		server_map_loading_= false;
+		return;
+	}
+
+	server_map_loading_= true;
+	server_map_loading_progress_= float(message.progress) / 255.0f;
+}
+
 void Client::StopMap()
 {
 	if( current_map_data_ != nullptr && sound_engine_ != nullptr )
@@ -666,6 +695,7 @@ void Client::StopMap()
 	minimap_state_= nullptr;
 
 	cutscene_player_= nullptr;
+	server_map_loading_= false;
 }
 
 void Client::TrySwitchWeaponOnOutOfAmmo()
@@ -76,6 +76,7 @@ public: // Messages handlers
 	void operator()( const Messages::MonsterLinkedSound& message );
 	void operator()( const Messages::MonsterSound& message );
 	void operator()( const Messages::MapChange& message );
+	void operator()( const Messages::MapLoadingProgress& message );
 	void operator()( const Messages::TextMessage& message );
 
 private:
@@ -124,6 +125,10 @@ private:
 	std::unique_ptr<MinimapState> minimap_state_;
 	std::unique_ptr<LoadedMinimapState> loaded_minimap_state_;
 
+	// Server is loading next map.
+	bool server_map_loading_= false;
+	float server_map_loading_progress_= 0.0f;
+
 	WeaponState weapon_state_;
 	bool shoot_pressed_= false;
 
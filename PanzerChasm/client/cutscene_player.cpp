@@ -69,21 +69,19 @@ CutscenePlayer::CutscenePlayer(
 
 		{ // Load model and animations.
 
-			const Vfs::FileContent model_content= vfs.ReadFile( character.model_file_name );
+			const Vfs::FileView model_content= vfs.ReadFileView( character.model_file_name );
 			if( !model_content.empty() )
 			{
-				std::vector<Vfs::FileContent> animations_content;
+				std::vector<Vfs::FileView> animations_content;
 				// Animations.
 				for( unsigned int a= 0u; a < CutsceneScript::c_max_character_animations; a++ )
 				{
 					if( character.animations_file_name[a][0] == '\0' )
 						continue;
-					animations_content.emplace_back();
-					vfs.ReadFile( character.animations_file_name[a], animations_content.back() );
+					animations_content.push_back( vfs.ReadFileView( character.animations_file_name[a] ) );
 				}
 				// Idle animation.
-				animations_content.emplace_back();
-				vfs.ReadFile( character.idle_animation_file_name, animations_content.back() );
+				animations_content.push_back( vfs.ReadFileView( character.idle_animation_file_name ) );
 
 				LoadModel_o3(
 					model_content,
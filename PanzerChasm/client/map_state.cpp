@@ -425,38 +425,33 @@ void MapState::Tick( const Time current_time )
 	}
 }
 
+unsigned int MapState::GetLastCompleteSnapshotSequence() const
+{
+	return last_complete_snapshot_sequence_;
+}
+
+unsigned int MapState::GetPreviousCompleteSnapshotsMask() const
+{
+	return previous_complete_snapshots_mask_;
+}
+
 void MapState::ProcessMessage( const Messages::MonsterState& message )
 {
 	const auto it= monsters_.find( message.monster_id );
 	if( it == monsters_.end() )
-		return;
+		return; // Maybe reliable "MonsterBirth" is not received yet. Do not count this state, server will resend it.
 
-	if( message.monster_type >= game_resources_->monsters_models.size() )
+	if( !AcceptSnapshotState( message.snapshot_sequence ) )
 		return;
-	const Model& model= game_resources_->monsters_models[ message.monster_type ];
-
-	Monster& monster= it->second;
-
-	MessagePositionToPosition( message.xyz, monster.pos );
-	monster.angle= MessageAngleToAngle( message.angle );
-	monster.monster_id= message.monster_type;
-	monster.body_parts_mask= message.body_parts_mask;
-	monster.is_fully_dead= message.is_fully_dead;
-	monster.is_invisible= message.is_invisible;
-	monster.color= message.color;
 
-	monster.animation= 0u;
-	monster.animation_frame= 0u;
-	if( message.animation < model.animations.size() )
-	{
-		monster.animation= message.animation;
-		if( message.animation_frame < model.animations[ monster.animation ].frame_count )
-			monster.animation_frame= message.animation_frame;
-	}
+	UpdateMonsterState( it->second, message );
 }
 
 void MapState::ProcessMessage( const Messages::WallPosition& message )
 {
+	if( !AcceptSnapshotState( message.snapshot_sequence ) )
+		return;
+
 	if( message.wall_index >= dynamic_walls_.size() )
 		return; // Bad wall index.
 
@@ -470,6 +465,9 @@ void MapState::ProcessMessage( const Messages::WallPosition& message )
 
 void MapState::ProcessMessage( const Messages::ItemState& message )
 {
+	if( !AcceptSnapshotState( message.snapshot_sequence ) )
+		return;
+
 	if( message.item_index >= items_.size() )
 		return; // Bad index
 
@@ -480,6 +478,9 @@ void MapState::ProcessMessage( const Messages::ItemState& message )
 
 void MapState::ProcessMessage( const Messages::StaticModelState& message )
 {
+	if( !AcceptSnapshotState( message.snapshot_sequence ) )
+		return;
+
 	if( message.static_model_index >= static_models_.size() )
 		return;
 
@@ -773,7 +774,7 @@ void MapState::ProcessMessage( const Messages::MonsterBirth& message )
 	if( it == monsters_.end() )
 		it= monsters_.emplace( message.monster_id, Monster() ).first;
 
-	ProcessMessage( message.initial_state );
+	UpdateMonsterState( it->second, message.initial_state );
 }
 
 void MapState::ProcessMessage( const Messages::MonsterDeath& message )
@@ -783,16 +784,15 @@ void MapState::ProcessMessage( const Messages::MonsterDeath& message )
 
 void MapState::ProcessMessage( const Messages::RocketState& message )
 {
+	// Count states of unknown rockets too - unreliable "RocketBirth" may be lost.
+	if( !AcceptSnapshotState( message.snapshot_sequence ) )
+		return;
+
 	const auto it= rockets_.find( message.rocket_id );
 	if( it == rockets_.end() )
 		return;
 
-	Rocket& rocket= it->second;
-
-	MessagePositionToPosition( message.xyz, rocket.pos );
-
-	for( unsigned int j= 0u; j < 2u; j++ )
-		rocket.angle[j]= MessageAngleToAngle( message.angle[j] );
+	UpdateRocketState( it->second, message );
 }
 
 void MapState::ProcessMessage( const Messages::RocketBirth& message )
@@ -807,7 +807,7 @@ void MapState::ProcessMessage( const Messages::RocketBirth& message )
 	inserted_it->second.start_time= last_tick_time_;
 	inserted_it->second.frame= 0u;
 
-	ProcessMessage( static_cast<const Messages::RocketState&>( message ) );
+	UpdateRocketState( inserted_it->second, message );
 }
 
 void MapState::ProcessMessage( const Messages::RocketDeath& message )
@@ -864,6 +864,38 @@ void MapState::ProcessMessage( const Messages::LightSourceDeath& message )
 	light_sources_.erase( message.light_source_id );
 }
 
+void MapState::UpdateMonsterState( Monster& monster, const Messages::MonsterState& message )
+{
+	if( message.monster_type >= game_resources_->monsters_models.size() )
+		return;
+	const Model& model= game_resources_->monsters_models[ message.monster_type ];
+
+	MessagePositionToPosition( message.xyz, monster.pos );
+	monster.angle= MessageAngleToAngle( message.angle );
+	monster.monster_id= message.monster_type;
+	monster.body_parts_mask= message.body_parts_mask;
+	monster.is_fully_dead= message.is_fully_dead;
+	monster.is_invisible= message.is_invisible;
+	monster.color= message.color;
+
+	monster.animation= 0u;
+	monster.animation_frame= 0u;
+	if( message.animation < model.animations.size() )
+	{
+		monster.animation= message.animation;
+		if( message.animation_frame < model.animations[ monster.animation ].frame_count )
+			monster.animation_frame= message.animation_frame;
+	}
+}
+
+void MapState::UpdateRocketState( Rocket& rocket, const Messages::RocketState& message )
+{
+	MessagePositionToPosition( message.xyz, rocket.pos );
+
+	for( unsigned int j= 0u; j < 2u; j++ )
+		rocket.angle[j]= MessageAngleToAngle( message.angle[j] );
+}
+
 void MapState::SpawnLightFlash( const m_Vec2& pos )
 {
 	light_flashes_.emplace_back();
@@ -895,4 +927,46 @@ void MapState::ProcessMessage( const Messages::RotatingLightSourceDeath& message
 	directed_light_sources_.erase( message.light_source_id );
 }
 
+void MapState::ProcessMessage( const Messages::SnapshotBegin& message )
+{
+	// Packets of older snapshot may come after packets of newer snapshot.
+	if( message.sequence <= current_snapshot_sequence_ )
+		return;
+
+	current_snapshot_sequence_= message.sequence;
+	current_snapshot_state_messages_received_= 0u;
+}
+
+void MapState::ProcessMessage( const Messages::SnapshotEnd& message )
+{
+	// Some packets of snapshot may be lost or reordered with packets of other snapshots.
+	if( !( message.sequence == current_snapshot_sequence_ &&
+		message.state_messages_count == current_snapshot_state_messages_received_ &&
+		message.sequence > last_complete_snapshot_sequence_ ) )
+		return;
+
+	// Remember previous complete snapshots - server needs acknowledgement for each of them.
+	const unsigned int shift= message.sequence - last_complete_snapshot_sequence_;
+	if( last_complete_snapshot_sequence_ == 0u || shift > 32u )
+		previous_complete_snapshots_mask_= 0u;
+	else
+		previous_complete_snapshots_mask_=
+			( shift == 32u ? 0u : ( previous_complete_snapshots_mask_ << shift ) ) | ( 1u << ( shift - 1u ) );
+
+	last_complete_snapshot_sequence_= message.sequence;
+}
+
+bool MapState::AcceptSnapshotState( const unsigned int snapshot_sequence )
+{
+	if( snapshot_sequence == 0u )
+		return true; // State outside snapshot.
+
+	// Drop states of older snapshots - they may overwrite newer states. Server will resend them, if needed.
+	if( snapshot_sequence != current_snapshot_sequence_ )
+		return false;
+
+	current_snapshot_state_messages_received_++;
+	return true;
+}
+
 } // namespace PanzerChasm
@@ -1,6 +1,6 @@
 #pragma once
-#include <unordered_map>
 
+#include "../entities_container.hpp"
 #include "../fwd.hpp"
 #include "../messages.hpp"
 #include "../rand.hpp"
@@ -96,7 +96,7 @@ public:
 		unsigned char color;
 	};
 
-	typedef std::unordered_map< EntityId, Monster > MonstersContainer;
+	typedef EntitiesContainer<Monster> MonstersContainer;
 
 	struct Rocket
 	{
@@ -109,7 +109,7 @@ public:
 		unsigned int frame;
 	};
 
-	typedef std::unordered_map< EntityId, Rocket > RocketsContainer;
+	typedef EntitiesContainer<Rocket> RocketsContainer;
 
 	struct DynamicItem
 	{
@@ -121,7 +121,7 @@ public:
 		bool fullbright;
 	};
 
-	typedef std::unordered_map< EntityId, DynamicItem > DynamicItemsContainer;
+	typedef EntitiesContainer<DynamicItem> DynamicItemsContainer;
 
 	struct LightFlash
 	{
@@ -140,7 +140,7 @@ public:
 		float radius;
 	};
 
-	typedef std::unordered_map<EntityId, LightSource> LightSourcesContainer;
+	typedef EntitiesContainer<LightSource> LightSourcesContainer;
 
 	struct DirectedLightSource
 	{
@@ -150,7 +150,7 @@ public:
 		float direction;
 	};
 
-	typedef std::unordered_map<EntityId, DirectedLightSource> DirectedLightSourcesContainer;
+	typedef EntitiesContainer<DirectedLightSource> DirectedLightSourcesContainer;
 
 public:
 	MapState(
@@ -179,6 +179,11 @@ public:
 
 	void Tick( Time current_time );
 
+	// Returns sequence of last snapshot, all state messages of which are received. Zero, if there is no such snapshots.
+	unsigned int GetLastCompleteSnapshotSequence() const;
+	// Bit i is set, if snapshot with sequence "last - 1 - i" is complete too.
+	unsigned int GetPreviousCompleteSnapshotsMask() const;
+
 	void ProcessMessage( const Messages::MonsterState& message );
 	void ProcessMessage( const Messages::WallPosition& message );
 	void ProcessMessage( const Messages::ItemState& message );
@@ -199,6 +204,8 @@ public:
 	void ProcessMessage( const Messages::RotatingLightSourceBirth& message );
 	void ProcessMessage( const Messages::RotatingLightSourceDeath& message );
 	void ProcessMessage( const Messages::DynamicItemDeath& message );
+	void ProcessMessage( const Messages::SnapshotBegin& message );
+	void ProcessMessage( const Messages::SnapshotEnd& message );
 
 private:
 	struct FullscreenBlendEffect
@@ -209,6 +216,12 @@ private:
 	};
 
 private:
+	// Returns false, if state must be dropped. Counts states of current snapshot.
+	bool AcceptSnapshotState( unsigned int snapshot_sequence );
+
+	// Used by state and birth messages. Birth messages are not counted as snapshot state messages.
+	void UpdateMonsterState( Monster& monster, const Messages::MonsterState& message );
+	void UpdateRocketState( Rocket& rocket, const Messages::RocketState& message );
 	void SpawnLightFlash( const m_Vec2& pos );
 
 private:
@@ -234,6 +247,12 @@ private:
 	DirectedLightSourcesContainer directed_light_sources_;
 
 	std::vector<FullscreenBlendEffect> fullscreen_blend_effects_;
+
+	// Server resends states until snapshot with them is acknowledged, so, acknowledge snapshot only if all its states received.
+	unsigned int current_snapshot_sequence_= 0u; // Newest started snapshot.
+	unsigned int current_snapshot_state_messages_received_= 0u;
+	unsigned int last_complete_snapshot_sequence_= 0u;
+	unsigned int previous_complete_snapshots_mask_= 0u;
 };
 
 } // namespace PanzerChasm
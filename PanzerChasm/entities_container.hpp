@@ -0,0 +1,188 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "assert.hpp"
+#include "fwd.hpp"
+
+namespace PanzerChasm
+{
+
+// Associative container for entities with EntityId keys.
+// Elements are stored densely in one array, so, iteration does not chase pointers.
+// Lookup by id is O(1), via sparse table of dense indices. Table is allocated lazily, by pages.
+// Erasing moves last element into place of erased element.
+// Insertion invalidates iterators and references, erasing invalidates iterators and references to last element.
+template<class T>
+class EntitiesContainer final
+{
+public:
+	typedef std::pair< EntityId, T > value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	size_t size() const;
+	bool empty() const;
+	void clear();
+
+	iterator find( EntityId id );
+	const_iterator find( EntityId id ) const;
+
+	// Returns existing element and false, if element with such id already exists.
+	std::pair< iterator, bool > emplace( EntityId id, T value );
+	T& operator[]( EntityId id );
+
+	// Returns iterator to element, placed instead of erased element.
+	iterator erase( iterator it );
+	size_t erase( EntityId id );
+
+private:
+	static constexpr unsigned int c_page_size_log2= 8u;
+	static constexpr unsigned int c_page_size= 1u << c_page_size_log2;
+	static constexpr unsigned int c_pages_count= ( 1u << ( sizeof(EntityId) * 8u ) ) / c_page_size;
+	static constexpr unsigned int c_invalid_index= ~0u;
+
+private:
+	unsigned int GetDenseIndex( EntityId id ) const;
+	void SetDenseIndex( EntityId id, unsigned int index );
+
+private:
+	std::vector<value_type> elements_;
+	std::vector<unsigned int> pages_[ c_pages_count ];
+};
+
+template<class T>
+constexpr unsigned int EntitiesContainer<T>::c_invalid_index;
+
+template<class T>
+typename EntitiesContainer<T>::iterator EntitiesContainer<T>::begin()
+{
+	return elements_.begin();
+}
+
+template<class T>
+typename EntitiesContainer<T>::iterator EntitiesContainer<T>::end()
+{
+	return elements_.end();
+}
+
+template<class T>
+typename EntitiesContainer<T>::const_iterator EntitiesContainer<T>::begin() const
+{
+	return elements_.begin();
+}
+
+template<class T>
+typename EntitiesContainer<T>::const_iterator EntitiesContainer<T>::end() const
+{
+	return elements_.end();
+}
+
+template<class T>
+size_t EntitiesContainer<T>::size() const
+{
+	return elements_.size();
+}
+
+template<class T>
+bool EntitiesContainer<T>::empty() const
+{
+	return elements_.empty();
+}
+
+template<class T>
+void EntitiesContainer<T>::clear()
+{
+	for( const value_type& element : elements_ )
+		SetDenseIndex( element.first, c_invalid_index );
+	elements_.clear();
+}
+
+template<class T>
+typename EntitiesContainer<T>::iterator EntitiesContainer<T>::find( const EntityId id )
+{
+	const unsigned int index= GetDenseIndex( id );
+	return index == c_invalid_index ? elements_.end() : elements_.begin() + index;
+}
+
+template<class T>
+typename EntitiesContainer<T>::const_iterator EntitiesContainer<T>::find( const EntityId id ) const
+{
+	const unsigned int index= GetDenseIndex( id );
+	return index == c_invalid_index ? elements_.end() : elements_.begin() + index;
+}
+
+template<class T>
+std::pair< typename EntitiesContainer<T>::iterator, bool > EntitiesContainer<T>::emplace( const EntityId id, T value )
+{
+	const unsigned int index= GetDenseIndex( id );
+	if( index != c_invalid_index )
+		return std::make_pair( elements_.begin() + index, false );
+
+	SetDenseIndex( id, elements_.size() );
+	elements_.emplace_back( id, std::move(value) );
+	return std::make_pair( elements_.end() - 1, true );
+}
+
+template<class T>
+T& EntitiesContainer<T>::operator[]( const EntityId id )
+{
+	return emplace( id, T() ).first->second;
+}
+
+template<class T>
+typename EntitiesContainer<T>::iterator EntitiesContainer<T>::erase( const iterator it )
+{
+	PC_ASSERT( it >= elements_.begin() && it < elements_.end() );
+
+	const unsigned int index= it - elements_.begin();
+	SetDenseIndex( it->first, c_invalid_index );
+
+	if( index + 1u != elements_.size() )
+	{
+		*it= std::move( elements_.back() );
+		SetDenseIndex( it->first, index );
+	}
+	elements_.pop_back();
+
+	return elements_.begin() + index;
+}
+
+template<class T>
+size_t EntitiesContainer<T>::erase( const EntityId id )
+{
+	const iterator it= find( id );
+	if( it == elements_.end() )
+		return 0u;
+
+	erase( it );
+	return 1u;
+}
+
+template<class T>
+unsigned int EntitiesContainer<T>::GetDenseIndex( const EntityId id ) const
+{
+	const std::vector<unsigned int>& page= pages_[ id >> c_page_size_log2 ];
+	if( page.empty() )
+		return c_invalid_index;
+
+	return page[ id & ( c_page_size - 1u ) ];
+}
+
+template<class T>
+void EntitiesContainer<T>::SetDenseIndex( const EntityId id, const unsigned int index )
+{
+	std::vector<unsigned int>& page= pages_[ id >> c_page_size_log2 ];
+	if( page.empty() )
+		page.resize( c_page_size, c_invalid_index );
+
+	page[ id & ( c_page_size - 1u ) ]= index;
+}
+
+} // namespace PanzerChasm
@@ -50,6 +50,9 @@ class Settings;
 class Vfs;
 typedef std::shared_ptr<Vfs> VfsPtr;
 
+class VisibilityMatrix;
+typedef std::shared_ptr<const VisibilityMatrix> VisibilityMatrixConstPtr;
+
 class SystemWindow;
 
 typedef unsigned short EntityId;
@@ -48,6 +48,10 @@ const float player_max_absolute_speed= 15.0f; // Maximum speed of player.
 
 constexpr float walls_height= 2.0f;
 
+// Limits for "sv_loops_per_second" setting.
+constexpr int min_server_loops_per_second=  20;
+constexpr int max_server_loops_per_second= 200;
+
 constexpr float procedures_speed_scale= 1.0f / 10.0f;
 
 const float animations_frames_per_second= 20.0f;
@@ -1,22 +1,38 @@
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstring>
+#include <deque>
 #include <sstream>
 
 #include "assert.hpp"
 #include "log.hpp"
+#include "thread_pool.hpp"
+#include "time.hpp"
 
 #include "game_resources.hpp"
 
 namespace PanzerChasm
 {
 
+// Input files are not null-terminated, so search only inside file.
+// Returns end of file, if substring not found.
+static const char* FindSubstring( const char* const begin, const char* const end, const char* const str )
+{
+	return std::search( begin, end, str, str + std::strlen(str) );
+}
+
+static const char* FindSubstring( const Vfs::FileView& file, const char* const str )
+{
+	const char* const file_begin= reinterpret_cast<const char*>(file.data());
+	return FindSubstring( file_begin, file_begin + file.size(), str );
+}
+
 static void LoadItemsDescription(
-	const Vfs::FileContent& inf_file,
+	const Vfs::FileView& inf_file,
 	GameResources& game_resources )
 {
-	const char* const items_start=
-		std::strstr( reinterpret_cast<const char*>(inf_file.data()), "[3D_OBJECTS]" );
+	const char* const items_start= FindSubstring( inf_file, "[3D_OBJECTS]" );
 	const char* const items_end= reinterpret_cast<const char*>(inf_file.data()) + inf_file.size() - 1u;
 
 	std::istringstream stream( std::string( items_start, items_end ) );
@@ -59,11 +75,10 @@ static void LoadItemsDescription(
 }
 
 static void LoadMonstersDescription(
-	const Vfs::FileContent& inf_file,
+	const Vfs::FileView& inf_file,
 	GameResources& game_resources )
 {
-	const char* const monsters_start=
-		std::strstr( reinterpret_cast<const char*>(inf_file.data()), "[MONSTERS]" );
+	const char* const monsters_start= FindSubstring( inf_file, "[MONSTERS]" );
 	const char* const monsters_end= reinterpret_cast<const char*>(inf_file.data()) + inf_file.size() - 1u;
 
 	std::istringstream stream( std::string( monsters_start, monsters_end ) );
@@ -105,11 +120,10 @@ static void LoadMonstersDescription(
 }
 
 static void LoadSpriteEffectsDescription(
-	const Vfs::FileContent& inf_file,
+	const Vfs::FileView& inf_file,
 	GameResources& game_resources )
 {
-	const char* const effects_start=
-		std::strstr( reinterpret_cast<const char*>(inf_file.data()), "[BLOWS]" );
+	const char* const effects_start= FindSubstring( inf_file, "[BLOWS]" );
 	const char* const effects_end= reinterpret_cast<const char*>(inf_file.data()) + inf_file.size() - 1u;
 
 	std::istringstream stream( std::string( effects_start, effects_end ) );
@@ -147,11 +161,10 @@ static void LoadSpriteEffectsDescription(
 }
 
 static void LoadBMPObjectsDescription(
-	const Vfs::FileContent& inf_file,
+	const Vfs::FileView& inf_file,
 	GameResources& game_resources )
 {
-	const char* const bmp_start=
-		std::strstr( reinterpret_cast<const char*>(inf_file.data()), "[BMP_OBJECTS]" );
+	const char* const bmp_start= FindSubstring( inf_file, "[BMP_OBJECTS]" );
 	const char* const bmp_end= reinterpret_cast<const char*>(inf_file.data()) + inf_file.size() - 1u;
 
 	std::istringstream stream( std::string( bmp_start, bmp_end ) );
@@ -188,11 +201,10 @@ static void LoadBMPObjectsDescription(
 }
 
 static void LoadWeaponsDescription(
-	const Vfs::FileContent& inf_file,
+	const Vfs::FileView& inf_file,
 	GameResources& game_resources )
 {
-	const char* const weapons_start=
-		std::strstr( reinterpret_cast<const char*>(inf_file.data()), "[WEAPONS]" );
+	const char* const weapons_start= FindSubstring( inf_file, "[WEAPONS]" );
 	const char* const weapons_end= reinterpret_cast<const char*>(inf_file.data()) + inf_file.size() - 1u;
 
 	std::istringstream stream( std::string( weapons_start, weapons_end ) );
@@ -254,11 +266,10 @@ static void LoadWeaponsDescription(
 }
 
 static void LoadRocketsDescription(
-	const Vfs::FileContent& inf_file,
+	const Vfs::FileView& inf_file,
 	GameResources& game_resources )
 {
-	const char* const rockets_start=
-		std::strstr( reinterpret_cast<const char*>(inf_file.data()), "[ROCKETS]" );
+	const char* const rockets_start= FindSubstring( inf_file, "[ROCKETS]" );
 	const char* const rockets_end= reinterpret_cast<const char*>(inf_file.data()) + inf_file.size() - 1u;
 
 	std::istringstream stream( std::string( rockets_start, rockets_end ) );
@@ -325,11 +336,10 @@ static void LoadRocketsDescription(
 }
 
 static void LoadGibsDescription(
-	const Vfs::FileContent& inf_file,
+	const Vfs::FileView& inf_file,
 	GameResources& game_resources )
 {
-	const char* const gibs_start=
-		std::strstr( reinterpret_cast<const char*>(inf_file.data()), "[GIBS]" );
+	const char* const gibs_start= FindSubstring( inf_file, "[GIBS]" );
 	const char* const gibs_end= reinterpret_cast<const char*>(inf_file.data()) + inf_file.size() - 1u;
 
 	std::istringstream stream( std::string( gibs_start, gibs_end ) );
@@ -443,7 +453,7 @@ static void LoadSoundsDescriptionFromFileData(
 }
 
 static void LoadSoundsDescription(
-	const Vfs::FileContent& inf_file,
+	const Vfs::FileView& inf_file,
 	GameResources& game_resources )
 {
 	for( GameResources::SoundDescription& sound : game_resources.sounds )
@@ -452,186 +462,214 @@ static void LoadSoundsDescription(
 		sound.volume= 0u;
 	}
 
-	const char* const start=
-		std::strstr( reinterpret_cast<const char*>(inf_file.data()), "[SOUNDS]" );
-	const char* const end= std::strstr( start, "[SOUNDS_END]" );
+	const char* const file_end= reinterpret_cast<const char*>(inf_file.data()) + inf_file.size();
+	const char* const start= FindSubstring( inf_file, "[SOUNDS]" );
+	const char* const end= FindSubstring( start, file_end, "[SOUNDS_END]" );
 
 	LoadSoundsDescriptionFromFileData( start, end, 0u, game_resources.sounds );
 }
 
-static void LoadItemsModels(
+static void LoadItemModel(
 	const Vfs& vfs,
-	GameResources& game_resources )
+	const GameResources::ItemDescription& item_description,
+	Model& out_model )
 {
-	game_resources.items_models.resize( game_resources.items_description.size() );
-
-	Vfs::FileContent file_content;
-	Vfs::FileContent animation_file_content;
+	char model_file_path[ GameResources::c_max_file_path_size ]= "MODELS/";
+	char animation_file_path[ GameResources::c_max_file_path_size ]= "ANI/";
 
-	for( unsigned int i= 0u; i < game_resources.items_models.size(); i++ )
-	{
-		const GameResources::ItemDescription& item_description= game_resources.items_description[i];
-
-		char model_file_path[ GameResources::c_max_file_path_size ]= "MODELS/";
-		char animation_file_path[ GameResources::c_max_file_path_size ]= "ANI/";
-
-		std::strcat( model_file_path, item_description.model_file_name );
-		std::strcat( animation_file_path, item_description.animation_file_name );
-
-		vfs.ReadFile( model_file_path, file_content );
+	std::strcat( model_file_path, item_description.model_file_name );
+	std::strcat( animation_file_path, item_description.animation_file_name );
 
-		if( item_description.animation_file_name[0u] != '\0' )
-			vfs.ReadFile( animation_file_path, animation_file_content );
-		else
-			animation_file_content.clear();
+	const Vfs::FileView file_content= vfs.ReadFileView( model_file_path );
+	const Vfs::FileView animation_file_content=
+		item_description.animation_file_name[0u] != '\0'
+			? vfs.ReadFileView( animation_file_path )
+			: Vfs::FileView();
 
-		LoadModel_o3( file_content, animation_file_content, game_resources.items_models[i] );
-	}
+	LoadModel_o3( file_content, animation_file_content, out_model );
 }
 
-static void LoadMonstersModels(
+static void LoadMonsterModel(
 	const Vfs& vfs,
-	GameResources& game_resources )
+	const GameResources::MonsterDescription& monster_description,
+	Model& out_model )
 {
-	game_resources.monsters_models.resize( game_resources.monsters_description.size() );
-
-	Vfs::FileContent file_content;
+	char model_file_path[ GameResources::c_max_file_path_size ]= "CARACTER/";
+	std::strcat( model_file_path, monster_description.model_file_name );
 
-	for( unsigned int i= 0u; i < game_resources.monsters_models.size(); i++ )
-	{
-		const GameResources::MonsterDescription& monster_description= game_resources.monsters_description[i];
-
-		char model_file_path[ GameResources::c_max_file_path_size ]= "CARACTER/";
-		std::strcat( model_file_path, monster_description.model_file_name );
-
-		vfs.ReadFile( model_file_path, file_content );
-		LoadModel_car( file_content, game_resources.monsters_models[i] );
-	}
+	LoadModel_car( vfs.ReadFileView( model_file_path ), out_model );
 }
 
-static void LoadEffectsSprites(
+static void LoadEffectSprite(
 	const Vfs& vfs,
-	GameResources& game_resources )
+	const GameResources::SpriteEffectDescription& effect_description,
+	ObjSprite& out_sprite )
 {
-	game_resources.effects_sprites.resize( game_resources.sprites_effects_description.size() );
-
-	Vfs::FileContent file_content;
+	LoadObjSprite( vfs.ReadFileView( effect_description.sprite_file_name ), out_sprite );
+}
 
-	for( unsigned int i= 0u; i < game_resources.effects_sprites.size(); i++ )
-	{
-		vfs.ReadFile( game_resources.sprites_effects_description[i].sprite_file_name, file_content );
-		LoadObjSprite( file_content, game_resources.effects_sprites[i] );
-	}
+static void LoadBMPObjectSprite(
+	const Vfs& vfs,
+	const GameResources::BMPObjectDescription& bmp_object_description,
+	ObjSprite& out_sprite )
+{
+	LoadObjSprite( vfs.ReadFileView( bmp_object_description.sprite_file_name ), out_sprite );
 }
 
-static void LoadBMPObjectsSprites(
+static void LoadWeaponModel(
 	const Vfs& vfs,
-	GameResources& game_resources )
+	const GameResources::WeaponDescription& weapon_description,
+	Model& out_model )
 {
-	game_resources.bmp_objects_sprites.resize( game_resources.bmp_objects_description.size() );
+	char model_file_path[ GameResources::c_max_file_path_size ]= "MODELS/";
+	char animation_file_path[ GameResources::c_max_file_path_size ]= "ANI/WEAPON/";
+	char reloading_animation_file_path[ GameResources::c_max_file_path_size ]= "ANI/WEAPON/";
 
-	Vfs::FileContent file_content;
+	std::strcat( model_file_path, weapon_description.model_file_name );
+	std::strcat( animation_file_path, weapon_description.animation_file_name );
+	std::strcat( reloading_animation_file_path, weapon_description.reloading_animation_file_name );
 
-	for( unsigned int i= 0u; i < game_resources.bmp_objects_sprites.size(); i++ )
+	const Vfs::FileView file_content= vfs.ReadFileView( model_file_path );
+	const Vfs::FileView animation_file_content[2u]=
 	{
-		vfs.ReadFile( game_resources.bmp_objects_description[i].sprite_file_name, file_content );
-		LoadObjSprite( file_content, game_resources.bmp_objects_sprites[i] );
-	}
-}
+		vfs.ReadFileView( animation_file_path ),
+		vfs.ReadFileView( reloading_animation_file_path ),
+	};
 
+	LoadModel_o3( file_content, animation_file_content, 2u, out_model );
+}
 
-static void LoadWeaponsModels(
+static void LoadRocketModel(
 	const Vfs& vfs,
-	GameResources& game_resources )
+	const GameResources::RocketDescription& rocket_description,
+	Model& out_model )
 {
-	game_resources.weapons_models.resize( game_resources.weapons_description.size() );
+	if( rocket_description.model_file_name[0] == '\0' )
+		return;
 
-	Vfs::FileContent file_content;
-	Vfs::FileContent animation_file_content[2u];
+	char model_file_path[ GameResources::c_max_file_path_size ]= "MODELS/";
+	char animation_file_path[ GameResources::c_max_file_path_size ]= "ANI/";
 
-	for( unsigned int i= 0u; i < game_resources.weapons_models.size(); i++ )
-	{
-		const GameResources::WeaponDescription& weapon_description= game_resources.weapons_description[i];
+	std::strcat( model_file_path, rocket_description.model_file_name );
+	std::strcat( animation_file_path, rocket_description.animation_file_name );
 
-		char model_file_path[ GameResources::c_max_file_path_size ]= "MODELS/";
-		char animation_file_path[ GameResources::c_max_file_path_size ]= "ANI/WEAPON/";
-		char reloading_animation_file_path[ GameResources::c_max_file_path_size ]= "ANI/WEAPON/";
+	LoadModel_o3(
+		vfs.ReadFileView( model_file_path ),
+		vfs.ReadFileView( animation_file_path ),
+		out_model );
+}
 
-		std::strcat( model_file_path, weapon_description.model_file_name );
-		std::strcat( animation_file_path, weapon_description.animation_file_name );
-		std::strcat( reloading_animation_file_path, weapon_description.reloading_animation_file_name );
+static void LoadGibModel(
+	const Vfs& vfs,
+	const GameResources::GibDescription& gib_description,
+	Model& out_model )
+{
+	if( gib_description.model_file_name[0] == '\0' )
+		return;
 
-		vfs.ReadFile( model_file_path, file_content );
-		vfs.ReadFile( animation_file_path, animation_file_content[0] );
-		vfs.ReadFile( reloading_animation_file_path, animation_file_content[1] );
+	char model_file_path[ GameResources::c_max_file_path_size ]= "MODELS/";
+	std::strcat( model_file_path, gib_description.model_file_name );
 
-		LoadModel_o3( file_content, animation_file_content, 2u, game_resources.weapons_models[i] );
-	}
+	LoadModel_o3( vfs.ReadFileView( model_file_path ), Vfs::FileView(), out_model );
 }
 
-static void LoadRocketsModels(
-	const Vfs& vfs,
-	GameResources& game_resources )
+namespace
 {
-	game_resources.rockets_models.resize( game_resources.rockets_description.size() );
-
-	Vfs::FileContent file_content;
-	Vfs::FileContent animation_file_content;
 
-	for( unsigned int i= 0u; i < game_resources.rockets_models.size(); i++ )
+// Loads models and sprites in worker threads.
+// Each task writes only own element of output container, which is allocated before tasks start,
+// so result does not depend on tasks execution order.
+// Loading functions may write to Log. Messages from worker threads are deferred until Log flush in main thread.
+class ParallelResourcesLoader final
+{
+public:
+	ParallelResourcesLoader( const Vfs& vfs )
+		: vfs_(vfs)
+	{}
+
+	template<class Description, class Resource>
+	void Load(
+		const char* const resources_name,
+		const std::vector<Description>& descriptions,
+		std::vector<Resource>& out_resources,
+		void (* const load_func)( const Vfs&, const Description&, Resource& ) )
 	{
-		const GameResources::RocketDescription& rocket_description= game_resources.rockets_description[i];
-
-		if( rocket_description.model_file_name[0] == '\0' )
-			continue;
+		out_resources.resize( descriptions.size() );
 
-		char model_file_path[ GameResources::c_max_file_path_size ]= "MODELS/";
-		char animation_file_path[ GameResources::c_max_file_path_size ]= "ANI/";
+		stats_.emplace_back( resources_name, descriptions.size() );
+		Stats& stats= stats_.back();
 
-		std::strcat( model_file_path, rocket_description.model_file_name );
-		std::strcat( animation_file_path, rocket_description.animation_file_name );
+		const Vfs& vfs= vfs_;
+		for( unsigned int i= 0u; i < descriptions.size(); i++ )
+		{
+			const Description& description= descriptions[i];
+			Resource& resource= out_resources[i];
+
+			thread_pool_.AddTask(
+				[&vfs, &description, &resource, &stats, load_func]
+				{
+					const Time start_time= Time::CurrentTime();
+					load_func( vfs, description, resource );
+					stats.total_time+= ( Time::CurrentTime() - start_time ).GetInternalRepresentation();
+				} );
+		}
+	}
 
-		vfs.ReadFile( model_file_path, file_content );
-		vfs.ReadFile( animation_file_path, animation_file_content );
+	void WaitAndReport( const Time loading_start_time )
+	{
+		thread_pool_.WaitAll();
 
-		LoadModel_o3( file_content, animation_file_content, game_resources.rockets_models[i] );
-	}
-}
+		const Time loading_time= Time::CurrentTime() - loading_start_time;
 
-static void LoadGibsModels(
-	const Vfs& vfs,
-	GameResources& game_resources )
-{
-	game_resources.gibs_models.resize( game_resources.gibs_description.size() );
+		int64_t tasks_time= 0;
+		for( const Stats& stats : stats_ )
+		{
+			const int64_t time= stats.total_time;
+			tasks_time+= time;
+			Log::Info( "  ", stats.name, ": ", stats.count, " in ", Time::FromInternalRepresentation( time ).ToSeconds(), " s" );
+		}
 
-	Vfs::FileContent model_file_content;
+		const float tasks_time_s= Time::FromInternalRepresentation( tasks_time ).ToSeconds();
+		const float loading_time_s= loading_time.ToSeconds();
+		Log::Info(
+			"Models and sprites loaded in ", loading_time_s, " s using ", thread_pool_.GetThreadsCount(), " threads. ",
+			"Sum of loading tasks time: ", tasks_time_s, " s, speedup: ",
+			loading_time_s > 0.0f ? tasks_time_s / loading_time_s : 1.0f );
+	}
 
-	for( unsigned int i= 0u; i < game_resources.gibs_models.size(); i++ )
+private:
+	struct Stats
 	{
-		const GameResources::GibDescription& gib_description= game_resources.gibs_description[i];
+		Stats( const char* const in_name, const unsigned int in_count )
+			: name(in_name), count(in_count), total_time(0)
+		{}
 
-		if( gib_description.model_file_name[0] == '\0' )
-			continue;
+		const char* const name;
+		const unsigned int count;
+		std::atomic<int64_t> total_time; // Sum of tasks time, in internal representation of Time.
+	};
 
-		char model_file_path[ GameResources::c_max_file_path_size ]= "MODELS/";
-		std::strcat( model_file_path, gib_description.model_file_name );
+private:
+	const Vfs& vfs_;
+	ThreadPool thread_pool_;
+	std::deque<Stats> stats_; // Deque, because Stats address must not change.
+};
 
-		vfs.ReadFile( model_file_path, model_file_content );
-		LoadModel_o3( model_file_content, Vfs::FileContent(), game_resources.gibs_models[i] );
-	}
-}
+} // namespace
 
 GameResourcesConstPtr LoadGameResources( const VfsPtr& vfs )
 {
 	PC_ASSERT( vfs != nullptr );
 
+	const Time start_time= Time::CurrentTime();
+
 	const GameResourcesPtr result= std::make_shared<GameResources>();
 
 	result->vfs= vfs;
 
 	LoadPalette( *vfs, result->palette );
 
-	const Vfs::FileContent inf_file= vfs->ReadFile( "CHASM.INF" );
+	const Vfs::FileView inf_file= vfs->ReadFileView( "CHASM.INF" );
 
 	if( inf_file.empty() )
 		Log::FatalError( "Can not read CHASM.INF" );
@@ -645,19 +683,26 @@ GameResourcesConstPtr LoadGameResources( const VfsPtr& vfs )
 	LoadGibsDescription( inf_file, *result );
 	LoadSoundsDescription( inf_file, *result );
 
-	LoadItemsModels( *vfs, *result );
-	LoadMonstersModels( *vfs, *result );
-	LoadEffectsSprites( *vfs, *result );
-	LoadBMPObjectsSprites( *vfs, *result );
-	LoadWeaponsModels( *vfs, *result );
-	LoadRocketsModels( *vfs, *result );
-	LoadGibsModels( *vfs, *result );
+	const Time models_loading_start_time= Time::CurrentTime();
+	Log::Info( "Game resources descriptions loaded in ", ( models_loading_start_time - start_time ).ToSeconds(), " s" );
+
+	ParallelResourcesLoader loader( *vfs );
+	loader.Load( "items models", result->items_description, result->items_models, LoadItemModel );
+	loader.Load( "monsters models", result->monsters_description, result->monsters_models, LoadMonsterModel );
+	loader.Load( "effects sprites", result->sprites_effects_description, result->effects_sprites, LoadEffectSprite );
+	loader.Load( "bmp objects sprites", result->bmp_objects_description, result->bmp_objects_sprites, LoadBMPObjectSprite );
+	loader.Load( "weapons models", result->weapons_description, result->weapons_models, LoadWeaponModel );
+	loader.Load( "rockets models", result->rockets_description, result->rockets_models, LoadRocketModel );
+	loader.Load( "gibs models", result->gibs_description, result->gibs_models, LoadGibModel );
+	loader.WaitAndReport( models_loading_start_time );
+
+	Log::Info( "Game resources loaded in ", ( Time::CurrentTime() - start_time ).ToSeconds(), " s" );
 
 	return result;
 }
 
 void LoadSoundsDescriptionFromMapResourcesFile(
-	const Vfs::FileContent& resoure_file,
+	const Vfs::FileView& resoure_file,
 	GameResources::SoundDescription* const out_sounds,
 	const unsigned int max_sound_count )
 {
@@ -667,21 +712,18 @@ void LoadSoundsDescriptionFromMapResourcesFile(
 		out_sounds[s].volume= 0u;
 	}
 
-	// Use std::search instead of std::strstr, because input string is not null-terminated.
-	const char* const file_begin= reinterpret_cast<const char*>(resoure_file.data());
-	const char* const file_end= file_begin + resoure_file.size();
-	const char* const str= "#newsounds";
-	const char* const start= std::search( file_begin, file_end, str, str + std::strlen(str) );
+	const char* const file_end= reinterpret_cast<const char*>(resoure_file.data()) + resoure_file.size();
+	const char* const start= FindSubstring( resoure_file, "#newsounds" );
 	if( start == file_end )
 		return;
 
-	const char* const end= std::strstr( start, "#end" );
+	const char* const end= FindSubstring( start, file_end, "#end" );
 
 	LoadSoundsDescriptionFromFileData( start, end, GameResources::c_max_global_sounds, out_sounds );
 }
 
 void LoadAmbientSoundsDescriptionFromMapResourcesFile(
-	const Vfs::FileContent& resoure_file,
+	const Vfs::FileView& resoure_file,
 	GameResources::SoundDescription* out_sounds,
 	unsigned int max_sound_count )
 {
@@ -691,11 +733,12 @@ void LoadAmbientSoundsDescriptionFromMapResourcesFile(
 		out_sounds[s].volume= 0u;
 	}
 
-	const char* const start= std::strstr( reinterpret_cast<const char*>(resoure_file.data()), "#ambients" );
-	if( start == nullptr )
+	const char* const file_end= reinterpret_cast<const char*>(resoure_file.data()) + resoure_file.size();
+	const char* const start= FindSubstring( resoure_file, "#ambients" );
+	if( start == file_end )
 		return;
 
-	const char* const end= std::strstr( start, "#end" );
+	const char* const end= FindSubstring( start, file_end, "#end" );
 
 	LoadSoundsDescriptionFromFileData( start, end, 0u, out_sounds );
 }
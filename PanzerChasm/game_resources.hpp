@@ -171,12 +171,12 @@ public:
 GameResourcesConstPtr LoadGameResources( const VfsPtr& vfs );
 
 void LoadSoundsDescriptionFromMapResourcesFile(
-	const Vfs::FileContent& resoure_file,
+	const Vfs::FileView& resoure_file,
 	GameResources::SoundDescription* out_sounds,
 	unsigned int max_sound_count );
 
 void LoadAmbientSoundsDescriptionFromMapResourcesFile(
-	const Vfs::FileContent& resoure_file,
+	const Vfs::FileView& resoure_file,
 	GameResources::SoundDescription* out_sounds,
 	unsigned int max_sound_count );
 
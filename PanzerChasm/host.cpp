@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstring>
 
 #include <framebuffer.hpp>
@@ -7,6 +8,7 @@
 
 #include "drawers_factory_gl.hpp"
 #include "drawers_factory_soft.hpp"
+#include "game_constants.hpp"
 #include "game_resources.hpp"
 #include "i_menu_drawer.hpp"
 #include "i_text_drawer.hpp"
@@ -14,6 +16,7 @@
 #include "map_loader.hpp"
 #include "shared_drawers.hpp"
 #include "save_load.hpp"
+#include "shared_settings_keys.hpp"
 #include "sound/sound_engine.hpp"
 
 #include "host.hpp"
@@ -81,6 +84,7 @@ Host::Host( const int argc, const char* const* const argv )
 		commands->emplace( "save", std::bind( &Host::SaveCommand, this, std::placeholders::_1 ) );
 		commands->emplace( "load", std::bind( &Host::LoadCommand, this, std::placeholders::_1 ) );
 		commands->emplace( "vid_restart", std::bind( &Host::VidRestart, this ) );
+		commands->emplace( "rescan_addon", std::bind( &Host::RescanAddonCommand, this ) );
 
 		host_commands_= std::move( commands );
 		commands_processor_.RegisterCommands( host_commands_ );
@@ -146,6 +150,13 @@ Host::~Host()
 
 bool Host::Loop()
 {
+	Log::FlushDeferredMessages();
+
+	// Server works in own thread. Lock it while processing events, because console commands and menu may access server.
+	std::unique_lock<std::mutex> server_lock;
+	if( local_server_thread_ != nullptr )
+		server_lock= local_server_thread_->Lock();
+
 	// Events processing
 	InputState input_state;
 	if( system_window_ != nullptr )
@@ -195,12 +206,28 @@ bool Host::Loop()
 	if( client_ != nullptr && !input_goes_to_console && !input_goes_to_menu && !really_paused )
 		client_->ProcessEvents( events_ );
 
+	if( server_lock.owns_lock() )
+		server_lock.unlock();
+
 	if( sound_engine_ != nullptr )
 		sound_engine_->Tick();
 
 	// Loop operations
 	if( local_server_ != nullptr )
-		local_server_->Loop( really_paused || needs_pause_server );
+	{
+		if( local_server_thread_ == nullptr )
+		{
+			const int loops_per_second=
+				std::max( GameConstants::min_server_loops_per_second, std::min(
+					settings_.GetOrSetInt( SettingsKeys::server_loops_per_second, 60 ),
+					GameConstants::max_server_loops_per_second ) );
+
+			Log::Info( "Start local server thread" );
+			local_server_thread_.reset( new ServerThread( *local_server_, loops_per_second ) );
+		}
+
+		local_server_thread_->SetPaused( really_paused || needs_pause_server );
+	}
 
 	if( client_ != nullptr )
 	{
@@ -481,6 +508,12 @@ void Host::LoadCommand( const CommandsArguments& args )
 	DoLoad( args.front().c_str() );
 }
 
+void Host::RescanAddonCommand()
+{
+	if( vfs_ != nullptr )
+		vfs_->RescanAddon();
+}
+
 void Host::DoVidRestart()
 {
 	// Clear old resources.
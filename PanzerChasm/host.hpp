@@ -9,6 +9,7 @@
 #include "net/net.hpp"
 #include "program_arguments.hpp"
 #include "server/server.hpp"
+#include "server/server_thread.hpp"
 #include "settings.hpp"
 #include "system_event.hpp"
 #include "system_window.hpp"
@@ -64,6 +65,7 @@ private:
 	void RunServerCommand( const CommandsArguments& args );
 	void SaveCommand( const CommandsArguments& args );
 	void LoadCommand( const CommandsArguments& args );
+	void RescanAddonCommand();
 
 	void DoVidRestart();
 
@@ -112,6 +114,7 @@ private:
 	LoopbackBufferPtr loopback_buffer_;
 	std::shared_ptr<ConnectionsListenerProxy> connections_listener_proxy_; // Create it together with server.
 	std::unique_ptr<Server> local_server_;
+	std::unique_ptr<ServerThread> local_server_thread_; // Must be destroyed before server.
 	std::unique_ptr<Client> client_;
 
 	std::string base_window_title_;
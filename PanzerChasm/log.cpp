@@ -1,5 +1,8 @@
+#ifndef PC_HEADLESS
 #include <SDL_messagebox.h>
+#endif
 
+#include "assert.hpp"
 #include "log.hpp"
 
 namespace PanzerChasm
@@ -8,18 +11,42 @@ namespace PanzerChasm
 Log::LogCallback Log::log_callback_;
 std::ofstream Log::log_file_{ "panzer_chasm.log" };
 
+std::mutex Log::mutex_;
+const std::thread::id Log::main_thread_id_= std::this_thread::get_id();
+std::vector< std::pair< std::string, Log::LogLevel > > Log::deferred_messages_;
+
 void Log::SetLogCallback( LogCallback callback )
 {
 	log_callback_= std::move(callback);
 }
 
+void Log::FlushDeferredMessages()
+{
+	std::vector< std::pair< std::string, LogLevel > > messages;
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		messages.swap( deferred_messages_ );
+	}
+
+	if( log_callback_ == nullptr )
+		return;
+
+	for( std::pair< std::string, LogLevel >& message : messages )
+		log_callback_( std::move( message.first ), message.second );
+}
+
 void Log::ShowFatalMessageBox( const std::string& error_message )
 {
+#ifndef PC_HEADLESS
 	SDL_ShowSimpleMessageBox(
 		SDL_MESSAGEBOX_ERROR,
 		"Fatal error",
 		error_message.c_str(),
 		nullptr );
+#else
+	// No windows in headless build. Message is already printed into console and log file.
+	PC_UNUSED( error_message );
+#endif
 }
 
 } // namespace PanzerChasm
@@ -3,13 +3,18 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace PanzerChasm
 {
 
 // Simple logger. You can write messages to it.
-// Not thread-safe.
+// Messages may be written from any thread, but log callback is called only from main thread.
+// Messages from other threads reach callback in FlushDeferredMessages call.
 class Log
 {
 public:
@@ -26,6 +31,9 @@ public:
 
 	static void SetLogCallback( LogCallback callback );
 
+	// Call it from main thread.
+	static void FlushDeferredMessages();
+
 	template<class...Args>
 	static void User(const Args&... args );
 
@@ -53,6 +61,10 @@ private:
 private:
 	static LogCallback log_callback_;
 	static std::ofstream log_file_;
+
+	static std::mutex mutex_;
+	static const std::thread::id main_thread_id_;
+	static std::vector< std::pair< std::string, LogLevel > > deferred_messages_;
 };
 
 template<class...Args>
@@ -80,8 +92,11 @@ void Log::FatalError( const Args&... args )
 	Print( stream, args... );
 	const std::string str= stream.str();
 
-	std::cout << str << std::endl;
-	log_file_ << str << std::endl;
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		std::cout << str << std::endl;
+		log_file_ << str << std::endl;
+	}
 	ShowFatalMessageBox( str );
 
 	std::exit(-1);
@@ -99,10 +114,20 @@ void Log::PrinLine( const LogLevel log_level, const Args&... args )
 {
 	std::ostringstream stream;
 	Print( stream, args... );
-	const std::string str= stream.str();
+	std::string str= stream.str();
+
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+
+		std::cout << str << std::endl;
+		log_file_ << str << std::endl;
 
-	std::cout << str << std::endl;
-	log_file_ << str << std::endl;
+		if( std::this_thread::get_id() != main_thread_id_ )
+		{
+			deferred_messages_.emplace_back( std::move(str), log_level );
+			return;
+		}
+	}
 
 	if( log_callback_ != nullptr )
 		log_callback_( std::move(str), log_level );
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <cstring>
 
 #include "assert.hpp"
@@ -37,7 +38,7 @@ private:
 	Queue& out_reliable_buffer_;
 	Queue& out_unreliable_buffer_;
 
-	bool disconnected_= false;
+	std::atomic<bool> disconnected_{ false };
 };
 
 LoopbackBuffer::Connection::Connection(
@@ -70,18 +71,14 @@ unsigned int LoopbackBuffer::Connection::ReadRealiableData( void* out_data, unsi
 {
 	if( disconnected_ ) return 0u;
 
-	unsigned int result_size= std::min( buffer_size, out_reliable_buffer_.Size() );
-	out_reliable_buffer_.PopBytes( out_data, result_size );
-	return result_size;
+	return out_reliable_buffer_.PopBytes( out_data, buffer_size );
 }
 
 unsigned int LoopbackBuffer::Connection::ReadUnrealiableData( void* out_data, unsigned int buffer_size )
 {
 	if( disconnected_ ) return 0u;
 
-	unsigned int result_size= std::min( buffer_size, out_unreliable_buffer_.Size() );
-	out_unreliable_buffer_.PopBytes( out_data, result_size );
-	return result_size;
+	return out_unreliable_buffer_.PopBytes( out_data, buffer_size );
 }
 
 void LoopbackBuffer::Connection::Disconnect()
@@ -108,27 +105,31 @@ LoopbackBuffer::Queue::~Queue()
 
 unsigned int LoopbackBuffer::Queue::Size() const
 {
+	std::lock_guard<std::mutex> lock( mutex_ );
 	return buffer_.size() - pos_;
 }
 
 void LoopbackBuffer::Queue::Clear()
 {
+	std::lock_guard<std::mutex> lock( mutex_ );
 	buffer_.clear();
 	pos_= 0u;
 }
 
 void LoopbackBuffer::Queue::PushBytes( const void* data, const unsigned int data_size )
 {
+	std::lock_guard<std::mutex> lock( mutex_ );
 	buffer_.insert(
 		buffer_.end(),
 		static_cast<const unsigned char*>(data),
 		static_cast<const unsigned char*>(data) + data_size );
 }
 
-void LoopbackBuffer::Queue::PopBytes( void* out_data, const unsigned int data_size )
+unsigned int LoopbackBuffer::Queue::PopBytes( void* out_data, const unsigned int max_data_size )
 {
-	PC_ASSERT( data_size <= Size() );
+	std::lock_guard<std::mutex> lock( mutex_ );
 
+	const unsigned int data_size= std::min( max_data_size, static_cast<unsigned int>( buffer_.size() - pos_ ) );
 	std::memcpy(
 		out_data,
 		buffer_.data() + pos_,
@@ -137,6 +138,8 @@ void LoopbackBuffer::Queue::PopBytes( void* out_data, const unsigned int data_si
 	pos_+= data_size;
 
 	TryShrink();
+
+	return data_size;
 }
 
 void LoopbackBuffer::Queue::TryShrink()
@@ -148,7 +151,7 @@ void LoopbackBuffer::Queue::TryShrink()
 	if( buffer_.size() < c_min_buffer_size_to_shrink )
 		return;
 
-	if( Size() * c_rate_mult < buffer_.size() )
+	if( ( buffer_.size() - pos_ ) * c_rate_mult < buffer_.size() )
 	{
 		buffer_.erase( buffer_.begin(), buffer_.begin() + pos_ );
 		pos_= 0u;
@@ -166,6 +169,8 @@ LoopbackBuffer::~LoopbackBuffer()
 
 void LoopbackBuffer::RequestConnect()
 {
+	std::lock_guard<std::mutex> lock( state_mutex_ );
+
 	PC_ASSERT( state_ == State::Unconnected );
 
 	client_side_connection_=
@@ -187,6 +192,8 @@ void LoopbackBuffer::RequestConnect()
 
 void LoopbackBuffer::RequestDisconnect()
 {
+	std::lock_guard<std::mutex> lock( state_mutex_ );
+
 	if( client_side_connection_ != nullptr )
 	{
 		client_side_connection_->Disconnect();
@@ -209,11 +216,15 @@ void LoopbackBuffer::RequestDisconnect()
 
 IConnectionPtr LoopbackBuffer::GetClientSideConnection()
 {
+	std::lock_guard<std::mutex> lock( state_mutex_ );
+
 	return client_side_connection_;
 }
 
 IConnectionPtr LoopbackBuffer::GetNewConnection()
 {
+	std::lock_guard<std::mutex> lock( state_mutex_ );
+
 	if( state_ == State::WaitingForConnection )
 	{
 		state_= State::Connected;
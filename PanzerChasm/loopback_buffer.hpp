@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include <vector>
 
 #include "server/i_connections_listener.hpp"
@@ -6,6 +7,8 @@
 namespace PanzerChasm
 {
 
+// Connection between client and server in same process.
+// Thread-safe - client and server sides may work in different threads.
 class LoopbackBuffer final : public IConnectionsListener
 {
 public:
@@ -33,12 +36,14 @@ private:
 		void Clear();
 
 		void PushBytes( const void* data, unsigned int data_size );
-		void PopBytes( void* out_data, unsigned int data_size );
+		// Returns number of readed bytes.
+		unsigned int PopBytes( void* out_data, unsigned int max_data_size );
 
 	private:
 		void TryShrink();
 
 	private:
+		mutable std::mutex mutex_;
 		std::vector<unsigned char> buffer_;
 		unsigned int pos_;
 	};
@@ -51,6 +56,7 @@ private:
 	};
 
 private:
+	std::mutex state_mutex_;
 	State state_= State::Unconnected;
 
 	IConnectionPtr client_side_connection_;
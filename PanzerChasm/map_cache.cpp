@@ -0,0 +1,574 @@
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Include OS-dependend stuff for "mkdir".
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "../Common/files.hpp"
+using namespace ChasmReverse;
+
+#include "assert.hpp"
+#include "log.hpp"
+#include "map_loader.hpp"
+#include "server/visibility_matrix.hpp"
+#include "vfs.hpp"
+
+#include "map_cache.hpp"
+
+#define MAP_CACHE_DIR "cache"
+
+namespace PanzerChasm
+{
+
+namespace
+{
+
+struct MapCacheHeader
+{
+	static constexpr char c_expected_id[8]= "PanChMc"; // PanzerChasmMapCache
+	static constexpr unsigned int c_expected_version= 0x101u; // Change each time, when format or MapData changed.
+
+	char id[8]; // must be equal to c_expected_id
+	unsigned int version;
+	unsigned int layout_hash; // Hash of sizes of raw-stored structures.
+	unsigned int content_size;
+	unsigned int reserved;
+	uint64_t content_hash;
+};
+
+SIZE_ASSERT( MapCacheHeader, 32u );
+
+constexpr char MapCacheHeader::c_expected_id[8];
+
+typedef uint64_t HashType;
+
+// FNV-1a
+HashType CalculateHash( const unsigned char* const data, const unsigned int data_size )
+{
+	HashType hash= 14695981039346656037ull;
+	for( unsigned int i= 0u; i < data_size; i++ )
+	{
+		hash^= data[i];
+		hash*= 1099511628211ull;
+	}
+	return hash;
+}
+
+unsigned int CalculateLayoutHash()
+{
+	const unsigned int sizes[]=
+	{
+		sizeof(void*),
+		sizeof(MapData),
+		sizeof(MapData::Wall),
+		sizeof(MapData::StaticModel),
+		sizeof(MapData::Item),
+		sizeof(MapData::Monster),
+		sizeof(MapData::Light),
+		sizeof(MapData::ModelDescription),
+		sizeof(MapData::Procedure),
+		sizeof(MapData::Procedure::ActionCommand),
+		sizeof(MapData::Link),
+		sizeof(MapData::Teleport),
+		sizeof(Submodel::Vertex),
+		sizeof(Submodel::AnimationVertex),
+		sizeof(Submodel::Animation),
+		sizeof(m_BBox3),
+		sizeof(Model),
+	};
+
+	unsigned int hash= 0u;
+	for( const unsigned int size : sizes )
+		hash= hash * 31u + size;
+	return hash;
+}
+
+class CacheWriter final
+{
+public:
+	explicit CacheWriter( std::vector<unsigned char>& out_buffer )
+		: buffer_(out_buffer)
+	{}
+
+	void WriteBytes( const void* const data, const unsigned int size )
+	{
+		const size_t pos= buffer_.size();
+		buffer_.resize( pos + size );
+		if( size > 0u )
+			std::memcpy( buffer_.data() + pos, data, size );
+	}
+
+	template<class T>
+	void Write( const T& t )
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "Expected trivially copyable type" );
+		WriteBytes( &t, sizeof(T) );
+	}
+
+	template<class T>
+	void WriteVector( const std::vector<T>& v )
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "Expected trivially copyable type" );
+		Write( static_cast<uint32_t>( v.size() ) );
+		WriteBytes( v.data(), v.size() * sizeof(T) );
+	}
+
+	void WriteString( const std::string& str )
+	{
+		Write( static_cast<uint32_t>( str.size() ) );
+		WriteBytes( str.data(), str.size() );
+	}
+
+private:
+	std::vector<unsigned char>& buffer_;
+};
+
+// Reads data with bounds checking.
+// After first error all reads return nothing, so, check IsOk() after reading.
+class CacheReader final
+{
+public:
+	CacheReader( const unsigned char* const data, const unsigned int size )
+		: pos_(data), end_(data + size)
+	{}
+
+	bool IsOk() const
+	{
+		return ok_;
+	}
+
+	bool IsEnd() const
+	{
+		return pos_ == end_;
+	}
+
+	void ReadBytes( void* const out_data, const unsigned int size )
+	{
+		if( !ok_ || size > static_cast<unsigned int>( end_ - pos_ ) )
+		{
+			ok_= false;
+			return;
+		}
+
+		if( size > 0u )
+			std::memcpy( out_data, pos_, size );
+		pos_+= size;
+	}
+
+	template<class T>
+	void Read( T& t )
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "Expected trivially copyable type" );
+		ReadBytes( &t, sizeof(T) );
+	}
+
+	template<class T>
+	void ReadVector( std::vector<T>& v )
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "Expected trivially copyable type" );
+
+		const uint32_t size= ReadSize( sizeof(T) );
+		v.resize( size );
+		ReadBytes( v.data(), size * sizeof(T) );
+	}
+
+	void ReadString( std::string& str )
+	{
+		const uint32_t size= ReadSize( 1u );
+		str.assign( reinterpret_cast<const char*>( pos_ ), size );
+		pos_+= size;
+	}
+
+	// Reads size of container. Returns zero, if container does not fit into rest of data.
+	uint32_t ReadSize( const unsigned int element_size )
+	{
+		uint32_t size= 0u;
+		Read( size );
+		if( !ok_ || uint64_t(size) * uint64_t(element_size) > uint64_t( end_ - pos_ ) )
+		{
+			ok_= false;
+			return 0u;
+		}
+		return size;
+	}
+
+private:
+	const unsigned char* pos_;
+	const unsigned char* const end_;
+	bool ok_= true;
+};
+
+void WriteSubmodel( CacheWriter& writer, const Submodel& submodel )
+{
+	writer.Write( submodel.frame_count );
+	writer.WriteVector( submodel.animations );
+	writer.WriteVector( submodel.vertices );
+	writer.WriteVector( submodel.animations_vertices );
+	writer.WriteVector( submodel.regular_triangles_indeces );
+	writer.WriteVector( submodel.transparent_triangles_indeces );
+	writer.WriteVector( submodel.animations_bboxes );
+
+	writer.Write( static_cast<uint32_t>( submodel.sounds.size() ) );
+	for( const std::vector<unsigned char>& sound : submodel.sounds )
+		writer.WriteVector( sound );
+
+	writer.Write( submodel.z_min );
+	writer.Write( submodel.z_max );
+}
+
+void ReadSubmodel( CacheReader& reader, Submodel& submodel )
+{
+	reader.Read( submodel.frame_count );
+	reader.ReadVector( submodel.animations );
+	reader.ReadVector( submodel.vertices );
+	reader.ReadVector( submodel.animations_vertices );
+	reader.ReadVector( submodel.regular_triangles_indeces );
+	reader.ReadVector( submodel.transparent_triangles_indeces );
+	reader.ReadVector( submodel.animations_bboxes );
+
+	submodel.sounds.resize( reader.ReadSize( sizeof(uint32_t) ) );
+	for( std::vector<unsigned char>& sound : submodel.sounds )
+		reader.ReadVector( sound );
+
+	reader.Read( submodel.z_min );
+	reader.Read( submodel.z_max );
+}
+
+void WriteModel( CacheWriter& writer, const Model& model )
+{
+	WriteSubmodel( writer, model );
+
+	writer.Write( model.texture_size );
+	writer.WriteVector( model.texture_data );
+
+	writer.Write( static_cast<uint32_t>( model.submodels.size() ) );
+	for( const Submodel& submodel : model.submodels )
+		WriteSubmodel( writer, submodel );
+}
+
+void ReadModel( CacheReader& reader, Model& model )
+{
+	ReadSubmodel( reader, model );
+
+	reader.Read( model.texture_size );
+	reader.ReadVector( model.texture_data );
+
+	model.submodels.resize( reader.ReadSize( sizeof(uint32_t) ) );
+	for( Submodel& submodel : model.submodels )
+		ReadSubmodel( reader, submodel );
+}
+
+void WriteProcedure( CacheWriter& writer, const MapData::Procedure& procedure )
+{
+	writer.Write( procedure.start_delay_s );
+	writer.Write( procedure.end_delay_s );
+	writer.Write( procedure.back_wait_s );
+	writer.Write( procedure.speed );
+	writer.Write( procedure.check_go );
+	writer.Write( procedure.check_back );
+	writer.Write( procedure.mortal );
+	writer.Write( procedure.light_remap );
+	writer.Write( procedure.locked );
+	writer.Write( procedure.on_message_number );
+	writer.Write( procedure.first_message_number );
+	writer.Write( procedure.lock_message_number );
+	writer.Write( procedure.sfx_id );
+	writer.WriteVector( procedure.linked_switches );
+	writer.WriteVector( procedure.sfx_pos );
+	writer.Write( procedure.red_key_required );
+	writer.Write( procedure.green_key_required );
+	writer.Write( procedure.blue_key_required );
+	writer.WriteVector( procedure.action_commands );
+}
+
+void ReadProcedure( CacheReader& reader, MapData::Procedure& procedure )
+{
+	reader.Read( procedure.start_delay_s );
+	reader.Read( procedure.end_delay_s );
+	reader.Read( procedure.back_wait_s );
+	reader.Read( procedure.speed );
+	reader.Read( procedure.check_go );
+	reader.Read( procedure.check_back );
+	reader.Read( procedure.mortal );
+	reader.Read( procedure.light_remap );
+	reader.Read( procedure.locked );
+	reader.Read( procedure.on_message_number );
+	reader.Read( procedure.first_message_number );
+	reader.Read( procedure.lock_message_number );
+	reader.Read( procedure.sfx_id );
+	reader.ReadVector( procedure.linked_switches );
+	reader.ReadVector( procedure.sfx_pos );
+	reader.Read( procedure.red_key_required );
+	reader.Read( procedure.green_key_required );
+	reader.Read( procedure.blue_key_required );
+	reader.ReadVector( procedure.action_commands );
+}
+
+void WriteMessage( CacheWriter& writer, const MapData::Message& message )
+{
+	writer.Write( message.delay_s );
+
+	writer.Write( static_cast<uint32_t>( message.texts.size() ) );
+	for( const MapData::Message::Text& text : message.texts )
+	{
+		writer.Write( text.x );
+		writer.Write( text.y );
+		writer.WriteString( text.data );
+	}
+}
+
+void ReadMessage( CacheReader& reader, MapData::Message& message )
+{
+	reader.Read( message.delay_s );
+
+	message.texts.resize( reader.ReadSize( sizeof(uint32_t) ) );
+	for( MapData::Message::Text& text : message.texts )
+	{
+		reader.Read( text.x );
+		reader.Read( text.y );
+		reader.ReadString( text.data );
+	}
+}
+
+void WriteMapData( CacheWriter& writer, const MapData& map_data )
+{
+	writer.Write( map_data.number );
+
+	writer.WriteVector( map_data.static_walls );
+	writer.WriteVector( map_data.dynamic_walls );
+	writer.WriteVector( map_data.static_models );
+	writer.WriteVector( map_data.items );
+	writer.WriteVector( map_data.monsters );
+	writer.WriteVector( map_data.lights );
+
+	writer.WriteVector( map_data.models_description );
+	writer.Write( static_cast<uint32_t>( map_data.models.size() ) );
+	for( const Model& model : map_data.models )
+		WriteModel( writer, model );
+
+	writer.WriteVector( map_data.stopani_commands );
+
+	writer.Write( static_cast<uint32_t>( map_data.messages.size() ) );
+	for( const MapData::Message& message : map_data.messages )
+		WriteMessage( writer, message );
+
+	writer.Write( static_cast<uint32_t>( map_data.procedures.size() ) );
+	for( const MapData::Procedure& procedure : map_data.procedures )
+		WriteProcedure( writer, procedure );
+
+	writer.WriteVector( map_data.links );
+	writer.WriteVector( map_data.teleports );
+
+	PC_ASSERT( map_data.visibility_matrix != nullptr );
+	writer.WriteVector( map_data.visibility_matrix->GetBits() );
+
+	writer.Write( map_data.map_name );
+	writer.Write( map_data.sky_texture_name );
+	writer.Write( map_data.map_sounds );
+	writer.Write( map_data.ambients );
+	writer.Write( map_data.map_index );
+	writer.Write( map_data.walls_textures );
+	writer.Write( map_data.floor_textures );
+	writer.Write( map_data.ceiling_textures );
+	writer.Write( map_data.ambient_lightmap );
+	writer.Write( map_data.ambient_sounds_map );
+	writer.Write( map_data.lightmap );
+	writer.Write( map_data.floor_textures_data );
+}
+
+void ReadMapData( CacheReader& reader, MapData& map_data )
+{
+	reader.Read( map_data.number );
+
+	reader.ReadVector( map_data.static_walls );
+	reader.ReadVector( map_data.dynamic_walls );
+	reader.ReadVector( map_data.static_models );
+	reader.ReadVector( map_data.items );
+	reader.ReadVector( map_data.monsters );
+	reader.ReadVector( map_data.lights );
+
+	reader.ReadVector( map_data.models_description );
+	map_data.models.resize( reader.ReadSize( sizeof(uint32_t) ) );
+	for( Model& model : map_data.models )
+		ReadModel( reader, model );
+
+	reader.ReadVector( map_data.stopani_commands );
+
+	map_data.messages.resize( reader.ReadSize( sizeof(uint32_t) ) );
+	for( MapData::Message& message : map_data.messages )
+		ReadMessage( reader, message );
+
+	map_data.procedures.resize( reader.ReadSize( sizeof(uint32_t) ) );
+	for( MapData::Procedure& procedure : map_data.procedures )
+		ReadProcedure( reader, procedure );
+
+	reader.ReadVector( map_data.links );
+	reader.ReadVector( map_data.teleports );
+
+	std::vector<VisibilityMatrix::RowBits> visibility_matrix_bits;
+	reader.ReadVector( visibility_matrix_bits );
+	if( visibility_matrix_bits.size() == VisibilityMatrix::c_bits_size )
+		map_data.visibility_matrix= std::make_shared<VisibilityMatrix>( std::move( visibility_matrix_bits ) );
+
+	reader.Read( map_data.map_name );
+	reader.Read( map_data.sky_texture_name );
+	reader.Read( map_data.map_sounds );
+	reader.Read( map_data.ambients );
+	reader.Read( map_data.map_index );
+	reader.Read( map_data.walls_textures );
+	reader.Read( map_data.floor_textures );
+	reader.Read( map_data.ceiling_textures );
+	reader.Read( map_data.ambient_lightmap );
+	reader.Read( map_data.ambient_sounds_map );
+	reader.Read( map_data.lightmap );
+	reader.Read( map_data.floor_textures_data );
+}
+
+} // namespace
+
+bool LoadMapFromCache(
+	const char* const cache_file_name,
+	const Vfs& vfs,
+	MapData& out_map_data )
+{
+	const MemoryMappedFile cache_file( cache_file_name );
+	if( !cache_file.IsValid() )
+		return false;
+
+	if( cache_file.Size() < sizeof(MapCacheHeader) )
+	{
+		Log::Warning( "Map cache file \"", cache_file_name, "\" is broken - it is too small" );
+		return false;
+	}
+
+	MapCacheHeader header;
+	std::memcpy( &header, cache_file.Data(), sizeof(MapCacheHeader) );
+
+	if( std::memcmp( header.id, MapCacheHeader::c_expected_id, sizeof(header.id) ) != 0 ||
+		header.version != MapCacheHeader::c_expected_version ||
+		header.layout_hash != CalculateLayoutHash() ||
+		header.content_size != cache_file.Size() - sizeof(MapCacheHeader) )
+	{
+		Log::Info( "Map cache file \"", cache_file_name, "\" has different format" );
+		return false;
+	}
+
+	if( header.content_hash != CalculateHash( cache_file.Data() + sizeof(MapCacheHeader), header.content_size ) )
+	{
+		Log::Warning( "Map cache file \"", cache_file_name, "\" is broken - content hash is different from actual content hash" );
+		return false;
+	}
+
+	CacheReader reader( cache_file.Data() + sizeof(MapCacheHeader), header.content_size );
+
+	// Validate sources.
+	const uint32_t source_files_count= reader.ReadSize( sizeof(uint32_t) );
+	for( unsigned int i= 0u; i < source_files_count && reader.IsOk(); i++ )
+	{
+		std::string file_path;
+		uint32_t file_size;
+		HashType file_hash;
+		reader.ReadString( file_path );
+		reader.Read( file_size );
+		reader.Read( file_hash );
+		if( !reader.IsOk() )
+			break;
+
+		const Vfs::FileView file= vfs.ReadFileView( file_path.c_str() );
+		if( file.size() != file_size ||
+			CalculateHash( file.data(), file.size() ) != file_hash )
+		{
+			Log::Info( "Map cache file \"", cache_file_name, "\" is outdated" );
+			return false;
+		}
+	}
+
+	ReadMapData( reader, out_map_data );
+
+	if( !reader.IsOk() || !reader.IsEnd() || out_map_data.visibility_matrix == nullptr )
+	{
+		Log::Warning( "Map cache file \"", cache_file_name, "\" is broken" );
+		return false;
+	}
+
+	return true;
+}
+
+bool SaveMapToCache(
+	const char* const cache_file_name,
+	const Vfs& vfs,
+	const MapCacheSourceFiles& source_files,
+	const MapData& map_data )
+{
+	std::vector<unsigned char> content;
+	CacheWriter writer( content );
+
+	writer.Write( static_cast<uint32_t>( source_files.size() ) );
+	for( const std::string& file_path : source_files )
+	{
+		const Vfs::FileView file= vfs.ReadFileView( file_path.c_str() );
+
+		writer.WriteString( file_path );
+		writer.Write( static_cast<uint32_t>( file.size() ) );
+		writer.Write( CalculateHash( file.data(), file.size() ) );
+	}
+
+	WriteMapData( writer, map_data );
+
+	MapCacheHeader header;
+	std::memcpy( header.id, MapCacheHeader::c_expected_id, sizeof(header.id) );
+	header.version= MapCacheHeader::c_expected_version;
+	header.layout_hash= CalculateLayoutHash();
+	header.content_size= content.size();
+	header.reserved= 0u;
+	header.content_hash= CalculateHash( content.data(), content.size() );
+
+	// Write to temporary file and rename it, to prevent reading of partially-written cache.
+	const std::string temp_file_name= std::string( cache_file_name ) + ".tmp";
+
+	std::FILE* const f= std::fopen( temp_file_name.c_str(), "wb" );
+	if( f == nullptr )
+	{
+		Log::Warning( "Can not write map cache \"", cache_file_name, "\"" );
+		return false;
+	}
+
+	FileWrite( f, &header, sizeof(MapCacheHeader) );
+	FileWrite( f, content.data(), content.size() );
+	std::fclose(f);
+
+	std::remove( cache_file_name );
+	if( std::rename( temp_file_name.c_str(), cache_file_name ) != 0 )
+	{
+		Log::Warning( "Can not write map cache \"", cache_file_name, "\"" );
+		std::remove( temp_file_name.c_str() );
+		return false;
+	}
+
+	return true;
+}
+
+void GetMapCacheFileName(
+	const unsigned int map_number,
+	char* const out_file_name,
+	const unsigned int out_file_name_max_length )
+{
+	std::snprintf( out_file_name, out_file_name_max_length, MAP_CACHE_DIR"/map_%02u.pcm", map_number );
+}
+
+void CreateMapCacheDir()
+{
+#ifdef _WIN32
+	_mkdir( MAP_CACHE_DIR );
+#else
+	mkdir( MAP_CACHE_DIR, 0777 );
+#endif
+}
+
+} // namespace PanzerChasm
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "fwd.hpp"
+
+namespace PanzerChasm
+{
+
+// Binary cache of fully built maps.
+// Cache file is memory-mapped and validated by hashes of all source files of map
+// (map, resources, floors, process files, models, animations).
+// So, loading of cached map is validation and copying of data blocks, instead of
+// text parsing and models decoding.
+//
+// Cache file contains raw structures, so, it is valid only for same build.
+
+typedef std::vector<std::string> MapCacheSourceFiles;
+
+// Returns true, if cache exists, is not broken and is not outdated.
+bool LoadMapFromCache(
+	const char* cache_file_name,
+	const Vfs& vfs,
+	MapData& out_map_data );
+
+// Returns true, if all ok.
+bool SaveMapToCache(
+	const char* cache_file_name,
+	const Vfs& vfs,
+	const MapCacheSourceFiles& source_files,
+	const MapData& map_data );
+
+void GetMapCacheFileName(
+	unsigned int map_number,
+	char* out_file_name,
+	unsigned int out_file_name_max_length );
+
+void CreateMapCacheDir();
+
+} // namespace PanzerChasm
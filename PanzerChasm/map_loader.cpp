@@ -1,9 +1,12 @@
 #include <cctype>
+#include <chrono>
 #include <cstring>
 
 #include "assert.hpp"
 #include "log.hpp"
+#include "map_cache.hpp"
 #include "math_utils.hpp"
+#include "server/visibility_matrix.hpp"
 
 #include "map_loader.hpp"
 
@@ -74,15 +77,17 @@ static bool StringEquals( const char* const s0, const char* const s1 )
 	return std::tolower( s0[i] ) == std::tolower( s1[i] );
 }
 
-// Case-unsensitive substring search
-static const char* GetSubstring( const char* const search_where, const char* const search_what )
+// Case-unsensitive substring search.
+// Files content is not null-terminated, so search only inside [search_where_begin; search_where_end).
+// Returns nullptr, if substring not found.
+static const char* GetSubstring( const char* const search_where_begin, const char* const search_where_end, const char* const search_what )
 {
-	const char* str= search_where;
-	while( *str != '\0' )
+	const char* str= search_where_begin;
+	while( str < search_where_end && *str != '\0' )
 	{
 		unsigned int i= 0u;
 
-		while( str[i] != '\0' && search_what[i] != '\0' &&
+		while( str + i < search_where_end && str[i] != '\0' && search_what[i] != '\0' &&
 				std::tolower( str[i] ) == std::tolower( search_what [i] ) )
 			i++;
 
@@ -95,6 +100,16 @@ static const char* GetSubstring( const char* const search_where, const char* con
 	return nullptr;
 }
 
+static const char* GetFileTextBegin( const Vfs::FileView& file )
+{
+	return reinterpret_cast<const char*>( file.data() );
+}
+
+static const char* GetFileTextEnd( const Vfs::FileView& file )
+{
+	return reinterpret_cast<const char*>( file.data() ) + file.size();
+}
+
 static decltype(MapData::Link::type) LinkTypeFromString( const char* const str )
 {
 	if( StringEquals( str, "link" ) )
@@ -164,10 +179,83 @@ static unsigned char ConvertMapLight( const unsigned char map_light )
 	return 255u - map_light * 6u;
 }
 
+template<class T>
+static size_t GetVectorSize( const std::vector<T>& v )
+{
+	return v.capacity() * sizeof(T);
+}
+
+static size_t GetSubmodelDynamicSize( const Submodel& submodel )
+{
+	size_t result=
+		GetVectorSize( submodel.animations ) +
+		GetVectorSize( submodel.vertices ) +
+		GetVectorSize( submodel.animations_vertices ) +
+		GetVectorSize( submodel.regular_triangles_indeces ) +
+		GetVectorSize( submodel.transparent_triangles_indeces ) +
+		GetVectorSize( submodel.animations_bboxes ) +
+		GetVectorSize( submodel.sounds );
+
+	for( const std::vector<unsigned char>& sound : submodel.sounds )
+		result+= GetVectorSize( sound );
+
+	return result;
+}
+
+// Approximate size of map data in memory.
+static size_t CalculateMapDataSize( const MapData& map_data )
+{
+	size_t result=
+		sizeof(MapData) +
+		GetVectorSize( map_data.static_walls ) +
+		GetVectorSize( map_data.dynamic_walls ) +
+		GetVectorSize( map_data.static_models ) +
+		GetVectorSize( map_data.items ) +
+		GetVectorSize( map_data.monsters ) +
+		GetVectorSize( map_data.lights ) +
+		GetVectorSize( map_data.models_description ) +
+		GetVectorSize( map_data.models ) +
+		GetVectorSize( map_data.stopani_commands ) +
+		GetVectorSize( map_data.messages ) +
+		GetVectorSize( map_data.procedures ) +
+		GetVectorSize( map_data.links ) +
+		GetVectorSize( map_data.teleports );
+
+	if( map_data.visibility_matrix != nullptr )
+		result+= GetVectorSize( map_data.visibility_matrix->GetBits() );
+
+	for( const MapData::Message& message : map_data.messages )
+	{
+		result+= GetVectorSize( message.texts );
+		for( const MapData::Message::Text& text : message.texts )
+			result+= text.data.capacity();
+	}
+
+	for( const MapData::Procedure& procedure : map_data.procedures )
+		result+=
+			GetVectorSize( procedure.linked_switches ) +
+			GetVectorSize( procedure.sfx_pos ) +
+			GetVectorSize( procedure.action_commands );
+
+	for( const Model& model : map_data.models )
+	{
+		result+=
+			GetSubmodelDynamicSize( model ) +
+			GetVectorSize( model.texture_data ) +
+			GetVectorSize( model.submodels );
+
+		for( const Submodel& submodel : model.submodels )
+			result+= GetSubmodelDynamicSize( submodel );
+	}
+
+	return result;
+}
+
 } // namespace
 
 MapLoader::MapLoader( const VfsPtr& vfs )
 	: vfs_(vfs)
+	, prefetch_thread_(1u)
 {}
 
 MapLoader::~MapLoader()
@@ -178,11 +266,131 @@ MapDataConstPtr MapLoader::LoadMap( const unsigned int map_number )
 	if( map_number >= 100 )
 		return nullptr;
 
-	if( last_loaded_map_ != nullptr && last_loaded_map_->number == map_number )
-		return last_loaded_map_;
+	if( const MapDataConstPtr cached_map= FindCachedMap( map_number ) )
+		return cached_map;
+
+	// Wait here for prefetch finish, if prefetch is in progress.
+	std::lock_guard<std::mutex> load_lock( load_mutex_ );
+
+	if( const MapDataConstPtr cached_map= FindCachedMap( map_number ) )
+		return cached_map;
+
+	const MapDataConstPtr result= LoadMapImpl( map_number );
+	if( result != nullptr )
+		AddMapToCache( result );
+
+	return result;
+}
+
+void MapLoader::PrefetchMap( const unsigned int map_number )
+{
+	if( map_number == 0u || map_number >= 100 || !memory_cache_enabled_ )
+		return;
+
+	{
+		std::lock_guard<std::mutex> cache_lock( cache_mutex_ );
+
+		if( prefetching_map_number_ != 0u )
+			return;
+
+		for( const CachedMap& cached_map : cached_maps_ )
+			if( cached_map.map_data->number == map_number )
+				return;
+
+		prefetching_map_number_= map_number;
+	}
+
+	prefetch_thread_.AddTask(
+		[this, map_number]
+		{
+			{
+				std::lock_guard<std::mutex> load_lock( load_mutex_ );
+
+				if( FindCachedMap( map_number ) == nullptr )
+				{
+					Log::Info( "Prefetching map ", map_number );
+
+					const MapDataConstPtr map_data= LoadMapImpl( map_number );
+					if( map_data != nullptr )
+						AddMapToCache( map_data );
+				}
+			}
+
+			std::lock_guard<std::mutex> cache_lock( cache_mutex_ );
+			prefetching_map_number_= 0u;
+		} );
+}
+
+void MapLoader::SetStageTimeCallback( StageTimeCallback callback )
+{
+	stage_time_callback_= std::move(callback);
+}
+
+void MapLoader::SetMemoryCacheEnabled( const bool enabled )
+{
+	memory_cache_enabled_= enabled;
+}
+
+void MapLoader::SetDiskCacheEnabled( const bool enabled )
+{
+	disk_cache_enabled_= enabled;
+}
+
+MapDataConstPtr MapLoader::FindCachedMap( const unsigned int map_number )
+{
+	if( !memory_cache_enabled_ )
+		return nullptr;
+
+	std::lock_guard<std::mutex> cache_lock( cache_mutex_ );
+
+	for( auto it= cached_maps_.begin(); it != cached_maps_.end(); ++it )
+	{
+		if( it->map_data->number == map_number )
+		{
+			// Move to front, as most recently used.
+			cached_maps_.splice( cached_maps_.begin(), cached_maps_, it );
+			return cached_maps_.front().map_data;
+		}
+	}
+
+	return nullptr;
+}
+
+void MapLoader::AddMapToCache( const MapDataConstPtr& map_data )
+{
+	if( !memory_cache_enabled_ )
+		return;
+
+	const size_t map_data_size= CalculateMapDataSize( *map_data );
 
+	std::lock_guard<std::mutex> cache_lock( cache_mutex_ );
+
+	cached_maps_.push_front( CachedMap{ map_data, map_data_size } );
+	cached_maps_size_+= map_data_size;
+
+	while( cached_maps_.size() > 1u && cached_maps_size_ > c_cache_memory_budget )
+	{
+		cached_maps_size_-= cached_maps_.back().size;
+		cached_maps_.pop_back();
+	}
+}
+
+MapDataConstPtr MapLoader::LoadMapImpl( const unsigned int map_number )
+{
 	Log::Info( "Loading map ", map_number );
 
+	auto stage_start_time= std::chrono::steady_clock::now();
+	const auto stage_end=
+	[&]( const char* const stage_name )
+	{
+		if( stage_time_callback_ == nullptr )
+			return;
+
+		const auto current_time= std::chrono::steady_clock::now();
+		stage_time_callback_( stage_name, std::chrono::duration<double>( current_time - stage_start_time ).count() );
+		stage_start_time= current_time;
+	};
+
 	char level_path[ MapData::c_max_file_path_size ];
 	char map_file_name[ MapData::c_max_file_path_size ];
 	char resource_file_name[ MapData::c_max_file_path_size ];
@@ -195,10 +403,27 @@ MapDataConstPtr MapLoader::LoadMap( const unsigned int map_number )
 	std::snprintf( floors_file_name, sizeof(floors_file_name), "%sFLOORS.%02u", level_path, map_number );
 	std::snprintf( process_file_name, sizeof(process_file_name), "%sPROCESS.%02u", level_path, map_number );
 
-	const Vfs::FileContent map_file_content= vfs_->ReadFile( map_file_name );
-	const Vfs::FileContent resource_file_content= vfs_->ReadFile( resource_file_name );
-	const Vfs::FileContent floors_file_content= vfs_->ReadFile( floors_file_name );
-	const Vfs::FileContent process_file_content= vfs_->ReadFile( process_file_name );
+	char cache_file_name[ MapData::c_max_file_path_size ];
+	GetMapCacheFileName( map_number, cache_file_name, sizeof(cache_file_name) );
+
+	if( disk_cache_enabled_ )
+	{
+		const MapDataPtr cached_map= std::make_shared<MapData>();
+		const bool loaded= LoadMapFromCache( cache_file_name, *vfs_, *cached_map ) && cached_map->number == map_number;
+		stage_end( "LoadMapFromCache" );
+
+		if( loaded )
+		{
+			Log::Info( "Map ", map_number, " loaded from cache" );
+			return cached_map;
+		}
+	}
+
+	const Vfs::FileView map_file_content= vfs_->ReadFileView( map_file_name );
+	const Vfs::FileView resource_file_content= vfs_->ReadFileView( resource_file_name );
+	const Vfs::FileView floors_file_content= vfs_->ReadFileView( floors_file_name );
+	const Vfs::FileView process_file_content= vfs_->ReadFileView( process_file_name );
+	stage_end( "ReadFiles" );
 
 	if( map_file_content.empty() ||
 		resource_file_content.empty() ||
@@ -216,21 +441,27 @@ MapDataConstPtr MapLoader::LoadMap( const unsigned int map_number )
 	MapDataPtr result= std::make_shared<MapData>();
 
 	LoadLevelScripts( process_file_content, *result );
+	stage_end( "LoadLevelScripts" );
 
 	DynamicWallsMask dynamic_walls_mask;
 	MarkDynamicWalls( *result, dynamic_walls_mask );
+	stage_end( "MarkDynamicWalls" );
 
 	for( MapData::IndexElement & el : result->map_index )
 		el.type= MapData::IndexElement::None;
 
 	// Scan map file
 	LoadLightmap( map_file_content, *result );
+	stage_end( "LoadLightmap" );
 	const unsigned char* const walls_lightmaps_data= GetWallsLightmapData( map_file_content );
 	LoadWalls( map_file_content, *result, dynamic_walls_mask, walls_lightmaps_data );
+	stage_end( "LoadWalls" );
 	LoadFloorsAndCeilings( map_file_content,*result );
 	LoadAmbientLight( map_file_content,*result );
 	LoadAmbientSoundsMap( map_file_content,*result );
+	stage_end( "LoadFloorsCeilingsAndAmbient" );
 	LoadMonstersAndLights( map_file_content, *result );
+	stage_end( "LoadMonstersAndLights" );
 
 	// Scan resource file
 	LoadMapName( resource_file_content, result->map_name );
@@ -239,15 +470,29 @@ MapDataConstPtr MapLoader::LoadMap( const unsigned int map_number )
 	LoadWallsTexturesDescription( resource_file_content, *result );
 	LoadSoundsDescriptionFromMapResourcesFile( resource_file_content, result->map_sounds, MapData::c_max_map_sounds );
 	LoadAmbientSoundsDescriptionFromMapResourcesFile( resource_file_content, result->ambients, MapData::c_max_map_ambients );
+	stage_end( "LoadResourceFile" );
 
 	// Scan floors file
 	LoadFloorsTexturesData( floors_file_content, *result );
+	stage_end( "LoadFloorsTexturesData" );
 
-	LoadModels( *result );
+	MapCacheSourceFiles source_files{ map_file_name, resource_file_name, floors_file_name, process_file_name };
+	LoadModels( *result, source_files );
+	stage_end( "LoadModels" );
 
-	// Cache result and return it.
 	result->number= map_number;
-	last_loaded_map_= result;
+
+	// Needs walls, textures and models, so, calculate it after all other map data.
+	result->visibility_matrix= std::make_shared<VisibilityMatrix>( result );
+	stage_end( "BuildVisibilityMatrix" );
+
+	if( disk_cache_enabled_ )
+	{
+		CreateMapCacheDir();
+		SaveMapToCache( cache_file_name, *vfs_, source_files, *result );
+		stage_end( "SaveMapToCache" );
+	}
+
 	return result;
 }
 
@@ -284,7 +529,7 @@ MapLoader::MapInfo MapLoader::GetPrevMapInfo( unsigned int map_number )
 	return result;
 }
 
-void MapLoader::LoadLightmap( const Vfs::FileContent& map_file, MapData& map_data )
+void MapLoader::LoadLightmap( const Vfs::FileView& map_file, MapData& map_data )
 {
 	const unsigned int c_lightmap_data_offset= 0x01u;
 
@@ -299,14 +544,14 @@ void MapLoader::LoadLightmap( const Vfs::FileContent& map_file, MapData& map_dat
 	}
 }
 
-const unsigned char* MapLoader::GetWallsLightmapData( const Vfs::FileContent& map_file )
+const unsigned char* MapLoader::GetWallsLightmapData( const Vfs::FileView& map_file )
 {
 	const unsigned int c_walls_lightmap_data_offset= 0x01u + MapData::c_lightmap_size * MapData::c_lightmap_size;
 	return map_file.data() + c_walls_lightmap_data_offset;
 }
 
 void MapLoader::LoadWalls(
-	const Vfs::FileContent& map_file,
+	const Vfs::FileView& map_file,
 	MapData& map_data,
 	const DynamicWallsMask& dynamic_walls_mask,
 	const unsigned char* walls_lightmap_data )
@@ -402,7 +647,7 @@ void MapLoader::LoadWalls(
 	} // for xy
 }
 
-void MapLoader::LoadFloorsAndCeilings( const Vfs::FileContent& map_file, MapData& map_data )
+void MapLoader::LoadFloorsAndCeilings( const Vfs::FileView& map_file, MapData& map_data )
 {
 	const unsigned int c_offset= 0x23001u;
 
@@ -425,7 +670,7 @@ void MapLoader::LoadFloorsAndCeilings( const Vfs::FileContent& map_file, MapData
 	}
 }
 
-void MapLoader::LoadAmbientLight( const Vfs::FileContent& map_file, MapData& map_data )
+void MapLoader::LoadAmbientLight( const Vfs::FileView& map_file, MapData& map_data )
 {
 	const unsigned int c_ambient_lightmap_offset= 0x23001u + MapData::c_map_size * MapData::c_map_size * 2u;
 
@@ -439,7 +684,7 @@ void MapLoader::LoadAmbientLight( const Vfs::FileContent& map_file, MapData& map
 	}
 }
 
-void MapLoader::LoadAmbientSoundsMap( const Vfs::FileContent& map_file, MapData& map_data )
+void MapLoader::LoadAmbientSoundsMap( const Vfs::FileView& map_file, MapData& map_data )
 {
 	const unsigned int c_offset= 0x23001u + MapData::c_map_size * MapData::c_map_size * 3u;
 
@@ -449,7 +694,7 @@ void MapLoader::LoadAmbientSoundsMap( const Vfs::FileContent& map_file, MapData&
 		map_data.ambient_sounds_map[ x + y * MapData::c_map_size ]= in_data[ x * MapData::c_map_size + y ];
 }
 
-void MapLoader::LoadMonstersAndLights( const Vfs::FileContent& map_file, MapData& map_data )
+void MapLoader::LoadMonstersAndLights( const Vfs::FileView& map_file, MapData& map_data )
 {
 	const unsigned int c_lights_count_offset= 0x27001u;
 	const unsigned int c_lights_offset= 0x27003u;
@@ -498,19 +743,23 @@ void MapLoader::LoadMonstersAndLights( const Vfs::FileContent& map_file, MapData
 	}
 }
 
-void MapLoader::LoadMapName( const Vfs::FileContent& resource_file, char* const out_map_name )
+void MapLoader::LoadMapName( const Vfs::FileView& resource_file, char* const out_map_name )
 {
 	out_map_name[0]= '\0';
 
-	const char* s= GetSubstring( reinterpret_cast<const char*>( resource_file.data() ), "#name" );
+	const char* const end= GetFileTextEnd( resource_file );
+	const char* s= GetSubstring( GetFileTextBegin( resource_file ), end, "#name" );
+	if( s == nullptr )
+		return;
 	s+= std::strlen( "#name" );
 
 	// Skip '=' and spaces before '='
-	while( std::isspace(*s) ) s++;
+	while( s < end && std::isspace(*s) ) s++;
 	s++;
 
 	char* dst= out_map_name;
 	while(
+		s < end &&
 		*s != '\0' &&
 		! ( *s == '\n' || *s == '\r' ) &&
 		dst < out_map_name + MapData::c_max_map_name_size - 1u )
@@ -521,22 +770,26 @@ void MapLoader::LoadMapName( const Vfs::FileContent& resource_file, char* const
 
 }
 
-void MapLoader::LoadSkyTextureName( const Vfs::FileContent& resource_file, MapData& map_data )
+void MapLoader::LoadSkyTextureName( const Vfs::FileView& resource_file, MapData& map_data )
 {
 	map_data.sky_texture_name[0]= '\0';
 
-	const char* s= GetSubstring( reinterpret_cast<const char*>( resource_file.data() ), "#sky" );
+	const char* const end= GetFileTextEnd( resource_file );
+	const char* s= GetSubstring( GetFileTextBegin( resource_file ), end, "#sky" );
+	if( s == nullptr )
+		return;
 	s+= std::strlen( "#sky" );
 
-	while( std::isspace(*s) ) s++;
+	while( s < end && std::isspace(*s) ) s++;
 
 	// =
 	s++;
 
-	while( std::isspace(*s) )s++;
+	while( s < end && std::isspace(*s) )s++;
 
 	char* dst= map_data.sky_texture_name;
 	while(
+		s < end &&
 		*s != '\0' &&
 		!std::isspace( *s ) &&
 		dst < map_data.sky_texture_name + sizeof(map_data.sky_texture_name) - 1u )
@@ -546,14 +799,19 @@ void MapLoader::LoadSkyTextureName( const Vfs::FileContent& resource_file, MapDa
 	*dst= '\0';
 }
 
-void MapLoader::LoadModelsDescription( const Vfs::FileContent& resource_file, MapData& map_data )
+void MapLoader::LoadModelsDescription( const Vfs::FileView& resource_file, MapData& map_data )
 {
-	const char* start= GetSubstring( reinterpret_cast<const char*>( resource_file.data() ), "#newobjects" );
+	const char* const file_end= GetFileTextEnd( resource_file );
+	const char* start= GetSubstring( GetFileTextBegin( resource_file ), file_end, "#newobjects" );
+	if( start == nullptr )
+		return;
 
-	while( *start != '\n' ) start++;
+	while( start < file_end && *start != '\n' ) start++;
 	start++;
 
-	const char* const end= GetSubstring( start, "#end" );
+	const char* end= GetSubstring( start, file_end, "#end" );
+	if( end == nullptr )
+		end= file_end;
 
 	std::istringstream stream( std::string( start, end ) );
 
@@ -593,7 +851,7 @@ void MapLoader::LoadModelsDescription( const Vfs::FileContent& resource_file, Ma
 	}
 }
 
-void MapLoader::LoadWallsTexturesDescription( const Vfs::FileContent& resource_file, MapData& map_data )
+void MapLoader::LoadWallsTexturesDescription( const Vfs::FileView& resource_file, MapData& map_data )
 {
 	for( MapData::WallTextureDescription& tex: map_data.walls_textures )
 	{
@@ -601,9 +859,15 @@ void MapLoader::LoadWallsTexturesDescription( const Vfs::FileContent& resource_f
 		tex.gso[0]= tex.gso[1]= tex.gso[2]= false;
 	}
 
-	const char* start= GetSubstring( reinterpret_cast<const char*>( resource_file.data() ), "#GFX" );
+	const char* const file_end= GetFileTextEnd( resource_file );
+	const char* start= GetSubstring( GetFileTextBegin( resource_file ), file_end, "#GFX" );
+	if( start == nullptr )
+		return;
 	start+= std::strlen( "#GFX" );
-	const char* const end= GetSubstring( start, "#end" );
+
+	const char* end= GetSubstring( start, file_end, "#end" );
+	if( end == nullptr )
+		end= file_end;
 
 	std::istringstream stream( std::string( start, end ) );
 
@@ -653,7 +917,7 @@ void MapLoader::LoadWallsTexturesDescription( const Vfs::FileContent& resource_f
 	}
 }
 
-void MapLoader::LoadFloorsTexturesData( const Vfs::FileContent& floors_file, MapData& map_data )
+void MapLoader::LoadFloorsTexturesData( const Vfs::FileView& floors_file, MapData& map_data )
 {
 	for( unsigned int t= 0u; t < MapData::c_floors_textures_count; t++ )
 	{
@@ -668,10 +932,10 @@ void MapLoader::LoadFloorsTexturesData( const Vfs::FileContent& floors_file, Map
 }
 
 
-void MapLoader::LoadLevelScripts( const Vfs::FileContent& process_file, MapData& map_data )
+void MapLoader::LoadLevelScripts( const Vfs::FileView& process_file, MapData& map_data )
 {
-	const char* const start= reinterpret_cast<const char*>( process_file.data() );
-	const char* const end= start + process_file.size();
+	const char* const start= GetFileTextBegin( process_file );
+	const char* const end= GetFileTextEnd( process_file );
 
 	std::istringstream stream( std::string( start, end ) );
 
@@ -982,23 +1246,22 @@ void MapLoader::MarkDynamicWalls( const MapData& map_data, DynamicWallsMask& out
 	} // for procedures
 }
 
-void MapLoader::LoadModels( MapData& map_data )
+void MapLoader::LoadModels( MapData& map_data, MapCacheSourceFiles& out_source_files )
 {
 	Log::Info( "Loading map models" );
 
 	map_data.models.resize( map_data.models_description.size() );
 
-	Vfs::FileContent file_content;
-	Vfs::FileContent animation_file_content;
-
 	for( unsigned int m= 0u; m < map_data.models.size(); m++ )
 	{
 		const MapData::ModelDescription& model_description= map_data.models_description[m];
 
 		char model_file_path[ MapData::c_max_file_path_size ];
 		std::snprintf( model_file_path, sizeof(model_file_path), "%s%s", models_path_, model_description.file_name );
-		vfs_->ReadFile( model_file_path, file_content );
+		const Vfs::FileView file_content= vfs_->ReadFileView( model_file_path );
+		out_source_files.emplace_back( model_file_path );
 
+		Vfs::FileView animation_file_content;
 		if( model_description.animation_file_name[0u] != '\0' )
 		{
 			// TODO - know, why some models animations file names have % prefix.
@@ -1008,10 +1271,9 @@ void MapLoader::LoadModels( MapData& map_data )
 
 			char animation_file_path[ MapData::c_max_file_path_size ];
 			std::snprintf( animation_file_path, sizeof(animation_file_path), "%s%s", animations_path_, file_name );
-			vfs_->ReadFile( animation_file_path, animation_file_content );
+			animation_file_content= vfs_->ReadFileView( animation_file_path );
+			out_source_files.emplace_back( animation_file_path );
 		}
-		else
-			animation_file_content.clear();
 
 		LoadModel_o3( file_content, animation_file_content, map_data.models[m] );
 	} // for models
@@ -1025,7 +1287,7 @@ bool MapLoader::GetMapInfoImpl( const unsigned int map_number, MapInfo& out_map_
 	std::snprintf( level_path, sizeof(level_path), "LEVEL%02u/", map_number );
 	std::snprintf( resource_file_name, sizeof(resource_file_name), "%sRESOURCE.%02u", level_path, map_number );
 
-	const Vfs::FileContent resource_file_content= vfs_->ReadFile( resource_file_name );
+	const Vfs::FileView resource_file_content= vfs_->ReadFileView( resource_file_name );
 
 	if( resource_file_content.empty() )
 		return false;
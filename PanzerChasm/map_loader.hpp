@@ -1,5 +1,8 @@
 #pragma once
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <sstream>
 
 #include <vec.hpp>
@@ -7,12 +10,15 @@
 #include "assert.hpp"
 #include "fwd.hpp"
 #include "game_resources.hpp"
+#include "map_cache.hpp"
 #include "model.hpp"
+#include "thread_pool.hpp"
 #include "vfs.hpp"
 
 namespace PanzerChasm
 {
 
+// If you change this structure, update map cache serialization code and map cache version.
 struct MapData
 {
 public:
@@ -268,6 +274,8 @@ public:
 	std::vector<Link> links;
 	std::vector<Teleport> teleports;
 
+	VisibilityMatrixConstPtr visibility_matrix; // Static walls visibility. Calculated once and stored in map cache.
+
 	char map_name[ c_max_map_name_size ];
 	char sky_texture_name[ c_max_file_path_size ];
 
@@ -297,8 +305,13 @@ public:
 	explicit MapLoader( const VfsPtr& vfs );
 	~MapLoader();
 
+	// Thread-safe.
 	MapDataConstPtr LoadMap( unsigned int map_number );
 
+	// Starts map loading in background thread and returns immediately.
+	// Next LoadMap call for this map returns prefetched map, or waits until prefetch is finished.
+	void PrefetchMap( unsigned int map_number );
+
 	struct MapInfo
 	{
 		unsigned int number;
@@ -308,26 +321,48 @@ public:
 	MapInfo GetNextMapInfo( unsigned int map_number );
 	MapInfo GetPrevMapInfo( unsigned int map_number );
 
+	// Settings for performance measurements. Call them before first map loading.
+	typedef std::function< void( const char* stage_name, double time_s ) > StageTimeCallback;
+	void SetStageTimeCallback( StageTimeCallback callback );
+	void SetMemoryCacheEnabled( bool enabled );
+	void SetDiskCacheEnabled( bool enabled );
+
 private:
 	typedef std::array< bool, MapData::c_map_size * MapData::c_map_size > DynamicWallsMask;
 
+	struct CachedMap
+	{
+		MapDataConstPtr map_data;
+		size_t size;
+	};
+
+	// Maps, which together take more memory, than this value, are evicted from cache.
+	// Most recently used map stays in cache anyway.
+	static constexpr size_t c_cache_memory_budget= 64u * 1024u * 1024u;
+
 private:
-	void LoadLightmap( const Vfs::FileContent& map_file, MapData& map_data );
-	const unsigned char* GetWallsLightmapData( const Vfs::FileContent& map_file );
-	void LoadWalls( const Vfs::FileContent& map_file, MapData& map_data, const DynamicWallsMask& dynamic_walls_mask, const unsigned char* walls_lightmap_data );
-	void LoadFloorsAndCeilings( const Vfs::FileContent& map_file, MapData& map_data );
-	void LoadAmbientLight( const Vfs::FileContent& map_file, MapData& map_data );
-	void LoadAmbientSoundsMap( const Vfs::FileContent& map_file, MapData& map_data );
-	void LoadMonstersAndLights( const Vfs::FileContent& map_file, MapData& map_data );
+	// Requires locked load_mutex_.
+	MapDataConstPtr LoadMapImpl( unsigned int map_number );
+
+	MapDataConstPtr FindCachedMap( unsigned int map_number );
+	void AddMapToCache( const MapDataConstPtr& map_data );
+
+	void LoadLightmap( const Vfs::FileView& map_file, MapData& map_data );
+	const unsigned char* GetWallsLightmapData( const Vfs::FileView& map_file );
+	void LoadWalls( const Vfs::FileView& map_file, MapData& map_data, const DynamicWallsMask& dynamic_walls_mask, const unsigned char* walls_lightmap_data );
+	void LoadFloorsAndCeilings( const Vfs::FileView& map_file, MapData& map_data );
+	void LoadAmbientLight( const Vfs::FileView& map_file, MapData& map_data );
+	void LoadAmbientSoundsMap( const Vfs::FileView& map_file, MapData& map_data );
+	void LoadMonstersAndLights( const Vfs::FileView& map_file, MapData& map_data );
 
-	void LoadMapName( const Vfs::FileContent& resource_file, char* out_map_name );
-	void LoadSkyTextureName( const Vfs::FileContent& resource_file, MapData& map_data );
-	void LoadModelsDescription( const Vfs::FileContent& resource_file, MapData& map_data );
-	void LoadWallsTexturesDescription( const Vfs::FileContent& resource_file, MapData& map_data );
+	void LoadMapName( const Vfs::FileView& resource_file, char* out_map_name );
+	void LoadSkyTextureName( const Vfs::FileView& resource_file, MapData& map_data );
+	void LoadModelsDescription( const Vfs::FileView& resource_file, MapData& map_data );
+	void LoadWallsTexturesDescription( const Vfs::FileView& resource_file, MapData& map_data );
 
-	void LoadFloorsTexturesData( const Vfs::FileContent& floors_file, MapData& map_data );
+	void LoadFloorsTexturesData( const Vfs::FileView& floors_file, MapData& map_data );
 
-	void LoadLevelScripts( const Vfs::FileContent& process_file, MapData& map_data );
+	void LoadLevelScripts( const Vfs::FileView& process_file, MapData& map_data );
 
 	void LoadMessage( unsigned int message_number, std::istringstream& stream, MapData& map_data );
 	void LoadProcedure( unsigned int procedure_number, std::istringstream& stream, MapData& map_data );
@@ -336,7 +371,7 @@ private:
 
 	void MarkDynamicWalls( const MapData& map_data, DynamicWallsMask& out_dynamic_walls );
 
-	void LoadModels( MapData& map_data );
+	void LoadModels( MapData& map_data, MapCacheSourceFiles& out_source_files );
 
 	// Returns false, if failed to load map.
 	bool GetMapInfoImpl( unsigned int map_number, MapInfo& out_map_info );
@@ -344,11 +379,24 @@ private:
 private:
 	const VfsPtr vfs_;
 
-	MapDataConstPtr last_loaded_map_;
+	// Only one map is loading at time. Also this mutex guards loading temp data.
+	std::mutex load_mutex_;
+
+	std::mutex cache_mutex_;
+	std::list<CachedMap> cached_maps_; // Most recently used maps first.
+	size_t cached_maps_size_= 0u;
+	unsigned int prefetching_map_number_= 0u; // Zero, if there is no prefetch.
+
+	StageTimeCallback stage_time_callback_;
+	bool memory_cache_enabled_= true;
+	bool disk_cache_enabled_= true;
 
 	char textures_path_[ MapData::c_max_file_name_size ];
 	char models_path_[ MapData::c_max_file_name_size ];
 	char animations_path_[ MapData::c_max_file_name_size ];
+
+	// Must be destroyed before other members, because prefetch task uses them.
+	ThreadPool prefetch_thread_;
 };
 
 } // namespace PanzerChasm
@@ -24,7 +24,7 @@ enum class MessageId : unsigned char
 namespace Messages
 {
 
-constexpr unsigned int c_protocol_version= 104u; // Increment each time, when protocol changed.
+constexpr unsigned int c_protocol_version= 109u; // Increment each time, when protocol changed.
 
 typedef short CoordType;
 typedef unsigned short AngleType;
@@ -71,6 +71,7 @@ struct MonsterState : public MessageBase
 	bool is_fully_dead : 1;
 	bool is_invisible : 1;
 	unsigned char color : 4; // For players only.
+	unsigned int snapshot_sequence; // See "SnapshotBegin".
 };
 
 struct WallPosition : public MessageBase
@@ -81,6 +82,7 @@ struct WallPosition : public MessageBase
 	CoordType vertices_xy[2][2];
 	short z;
 	unsigned char texture_id;
+	unsigned int snapshot_sequence; // See "SnapshotBegin".
 };
 
 struct PlayerSpawn : public MessageBase
@@ -142,6 +144,7 @@ struct ItemState : public MessageBase
 	unsigned short item_index;
 	CoordType z;
 	bool picked;
+	unsigned int snapshot_sequence; // See "SnapshotBegin".
 };
 
 struct StaticModelState : public MessageBase
@@ -159,6 +162,7 @@ struct StaticModelState : public MessageBase
 	bool animation_playing;
 
 	unsigned char model_id;
+	unsigned int snapshot_sequence; // See "SnapshotBegin".
 };
 
 struct SpriteEffectBirth : public MessageBase
@@ -226,6 +230,7 @@ struct RocketState : public MessageBase
 	EntityId rocket_id;
 	CoordType xyz[3];
 	AngleType angle[2];
+	unsigned int snapshot_sequence; // See "SnapshotBegin".
 };
 
 struct RocketBirth : public RocketState
@@ -301,6 +306,26 @@ struct RotatingLightSourceDeath : public MessageBase
 	EntityId light_source_id;
 };
 
+// Starts snapshot - group of entities state messages ( WallPosition, StaticModelState, ItemState, MonsterState, RocketState ).
+// Snapshot contains only states, not received by client yet.
+// State messages of snapshot have sequence of snapshot, because packets of different snapshots may be reordered.
+// States outside snapshots ( in birth messages ) have zero sequence.
+struct SnapshotBegin : public MessageBase
+{
+	DEFINE_MESSAGE_CONSTRUCTOR(SnapshotBegin)
+
+	unsigned int sequence;
+};
+
+// Ends snapshot. Client acknowledges snapshot, if it received all snapshot state messages.
+struct SnapshotEnd : public MessageBase
+{
+	DEFINE_MESSAGE_CONSTRUCTOR(SnapshotEnd)
+
+	unsigned int sequence;
+	unsigned int state_messages_count;
+};
+
 struct MapChange : public MessageBase
 {
 	DEFINE_MESSAGE_CONSTRUCTOR(MapChange)
@@ -309,6 +334,14 @@ struct MapChange : public MessageBase
 	bool need_play_cutscene;
 };
 
+// Server sends it, while next map is loading. After successful loading server sends "MapChange".
+struct MapLoadingProgress : public MessageBase
+{
+	DEFINE_MESSAGE_CONSTRUCTOR(MapLoadingProgress)
+
+	unsigned char progress; // 255 - loading failed, map is not changed.
+};
+
 struct MonsterBirth : public MessageBase
 {
 	DEFINE_MESSAGE_CONSTRUCTOR(MonsterBirth)
@@ -353,6 +386,17 @@ struct PlayerMove : public MessageBase
 	unsigned char color : 4;
 };
 
+// Client to server. Sequence of last fully received snapshot and mask of other recently received snapshots.
+// Server may send low-priority states not in each snapshot, so, all received snapshots must be acknowledged.
+struct SnapshotAck : public MessageBase
+{
+	DEFINE_MESSAGE_CONSTRUCTOR(SnapshotAck)
+
+	unsigned int sequence;
+	// Bit i is set, if snapshot with sequence "sequence - 1 - i" is fully received too.
+	unsigned int previous_snapshots_mask;
+};
+
 // Client to server. Transmited, when client renamed.
 struct PlayerName : public MessageBase
 {
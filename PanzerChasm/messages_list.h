@@ -32,9 +32,12 @@ MESSAGE_FUNC(LightSourceBirth)
 MESSAGE_FUNC(LightSourceDeath)
 MESSAGE_FUNC(RotatingLightSourceBirth)
 MESSAGE_FUNC(RotatingLightSourceDeath)
+MESSAGE_FUNC(SnapshotBegin)
+MESSAGE_FUNC(SnapshotEnd)
 
 // Reliable server to client
 MESSAGE_FUNC(MapChange)
+MESSAGE_FUNC(MapLoadingProgress)
 MESSAGE_FUNC(MonsterBirth)
 MESSAGE_FUNC(MonsterDeath)
 MESSAGE_FUNC(TextMessage)
@@ -42,6 +45,7 @@ MESSAGE_FUNC(DynamicTextMessage)
 
 // Unrealiable client to server
 MESSAGE_FUNC(PlayerMove)
+MESSAGE_FUNC(SnapshotAck)
 
 // Reliable client to server
 MESSAGE_FUNC(PlayerName)
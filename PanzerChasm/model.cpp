@@ -106,7 +106,7 @@ static unsigned char GroupIdToGroupsMask( const unsigned char group_id )
 	return group_id == 0 ? 64u : group_id;
 }
 
-void LoadModel_o3( const Vfs::FileContent& model_file, const Vfs::FileContent& animation_file, Model& out_model )
+void LoadModel_o3( const Vfs::FileView& model_file, const Vfs::FileView& animation_file, Model& out_model )
 {
 	ClearModel( out_model );
 
@@ -241,8 +241,8 @@ void LoadModel_o3( const Vfs::FileContent& model_file, const Vfs::FileContent& a
 }
 
 void LoadModel_o3(
-	const Vfs::FileContent& model_file,
-	const Vfs::FileContent* const animation_files, const unsigned int animation_files_count,
+	const Vfs::FileView& model_file,
+	const Vfs::FileView* const animation_files, const unsigned int animation_files_count,
 	Model& out_model )
 {
 	constexpr unsigned int c_max_animations= 32;
@@ -282,13 +282,13 @@ void LoadModel_o3(
 		ptr+= animation_data_size;
 	}
 
-	LoadModel_o3( model_file, combined_animations, out_model );
+	LoadModel_o3( model_file, Vfs::FileView( combined_animations ), out_model );
 
 	out_model.animations.resize( animation_files_count );
 	std::memcpy( out_model.animations.data(), animations, sizeof(Model::Animation) * animation_files_count );
 }
 
-void LoadModel_car( const Vfs::FileContent& model_file, Model& out_model )
+void LoadModel_car( const Vfs::FileView& model_file, Model& out_model )
 {
 	ClearModel( out_model );
 
@@ -68,12 +68,12 @@ struct Model final : public Submodel
 	std::vector<Submodel> submodels;
 };
 
-void LoadModel_o3( const Vfs::FileContent& model_file, const Vfs::FileContent& animation_file, Model& out_model );
+void LoadModel_o3( const Vfs::FileView& model_file, const Vfs::FileView& animation_file, Model& out_model );
 void LoadModel_o3(
-	const Vfs::FileContent& model_file,
-	const Vfs::FileContent* animation_files, unsigned int animation_files_count,
+	const Vfs::FileView& model_file,
+	const Vfs::FileView* animation_files, unsigned int animation_files_count,
 	Model& out_model );
 
-void LoadModel_car( const Vfs::FileContent& model_file, Model& out_model );
+void LoadModel_car( const Vfs::FileView& model_file, Model& out_model );
 
 } // namespace ChasmReverse
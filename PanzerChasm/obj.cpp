@@ -16,7 +16,7 @@ struct FrameHeader
 
 SIZE_ASSERT( FrameHeader, 6 );
 
-void LoadObjSprite( const Vfs::FileContent& obj_file, ObjSprite& out_sprite )
+void LoadObjSprite( const Vfs::FileView& obj_file, ObjSprite& out_sprite )
 {
 	unsigned short frame_count;
 	std::memcpy( &frame_count, obj_file.data(), sizeof(frame_count) );
@@ -14,6 +14,6 @@ struct ObjSprite final
 	std::vector<unsigned char> data;
 };
 
-void LoadObjSprite( const Vfs::FileContent& obj_file, ObjSprite& out_sprite );
+void LoadObjSprite( const Vfs::FileView& obj_file, ObjSprite& out_sprite );
 
 } // namespace PanzerChasm
@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../assert.hpp"
+#include "../map_loader.hpp"
+
+namespace PanzerChasm
+{
+
+// Sparse map field, built from rectangular zones - list of zones and bit mask of active cells.
+// Value of active cell is value of last activated zone, containing this cell.
+// Deactivation makes all cells of rectangle inactive, even if they are covered by other zones.
+// So, result is same, as if zones are written into full field and deactivation clears cells.
+template<class T>
+class ActiveZones final
+{
+public:
+	ActiveZones();
+
+	// Rectangle borders are inclusive. Parts of rectangle outside map are ignored.
+	void Activate( unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, const T& value );
+	void Deactivate( unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1 );
+
+	// Returns true, if there are no active cells.
+	bool Empty() const;
+
+	// Returns nullptr for inactive cells and for cells outside map.
+	const T* Get( int x, int y ) const;
+
+private:
+	typedef uint64_t RowBits;
+	static_assert( sizeof(RowBits) * 8u == MapData::c_map_size, "Row must contain bit for each cell of map row" );
+
+	struct Zone
+	{
+		// Inclusive borders.
+		unsigned char x0, y0, x1, y1;
+		T value;
+
+		bool IsInside( unsigned int in_x0, unsigned int in_y0, unsigned int in_x1, unsigned int in_y1 ) const
+		{
+			return x0 >= in_x0 && y0 >= in_y0 && x1 <= in_x1 && y1 <= in_y1;
+		}
+	};
+
+private:
+	// Returns false, if rectangle is outside map.
+	static bool ClampRect( unsigned int& x0, unsigned int& y0, unsigned int& x1, unsigned int& y1 );
+	// Removes zones, fully covered by rectangle.
+	void RemoveCoveredZones( unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1 );
+	void SetCellsActive( unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, bool active );
+
+private:
+	std::vector<Zone> zones_; // In activation order.
+	bool empty_= true;
+	RowBits active_cells_[ MapData::c_map_size ];
+};
+
+template<class T>
+ActiveZones<T>::ActiveZones()
+{
+	std::fill( active_cells_, active_cells_ + MapData::c_map_size, RowBits(0u) );
+}
+
+template<class T>
+void ActiveZones<T>::Activate( unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, const T& value )
+{
+	if( !ClampRect( x0, y0, x1, y1 ) )
+		return;
+
+	// New zone overrides values of fully covered zones.
+	RemoveCoveredZones( x0, y0, x1, y1 );
+
+	Zone zone;
+	zone.x0= static_cast<unsigned char>(x0);
+	zone.y0= static_cast<unsigned char>(y0);
+	zone.x1= static_cast<unsigned char>(x1);
+	zone.y1= static_cast<unsigned char>(y1);
+	zone.value= value;
+	zones_.push_back( zone );
+
+	SetCellsActive( x0, y0, x1, y1, true );
+}
+
+template<class T>
+void ActiveZones<T>::Deactivate( unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1 )
+{
+	if( !ClampRect( x0, y0, x1, y1 ) )
+		return;
+
+	// All cells of covered zones become inactive. Cells, activated later, are covered by later zones.
+	RemoveCoveredZones( x0, y0, x1, y1 );
+	SetCellsActive( x0, y0, x1, y1, false );
+}
+
+template<class T>
+bool ActiveZones<T>::Empty() const
+{
+	return empty_;
+}
+
+template<class T>
+const T* ActiveZones<T>::Get( const int x, const int y ) const
+{
+	if( x < 0 || x >= int(MapData::c_map_size) || y < 0 || y >= int(MapData::c_map_size) )
+		return nullptr;
+
+	if( ( active_cells_[y] & ( RowBits(1u) << x ) ) == 0u )
+		return nullptr;
+
+	for( auto it= zones_.rbegin(); it != zones_.rend(); ++it )
+	{
+		if( x >= int(it->x0) && x <= int(it->x1) && y >= int(it->y0) && y <= int(it->y1) )
+			return &it->value;
+	}
+
+	PC_ASSERT(false); // Active cell must be covered by zone.
+	return nullptr;
+}
+
+template<class T>
+bool ActiveZones<T>::ClampRect( unsigned int& x0, unsigned int& y0, unsigned int& x1, unsigned int& y1 )
+{
+	x1= std::min( x1, MapData::c_map_size - 1u );
+	y1= std::min( y1, MapData::c_map_size - 1u );
+	return x0 <= x1 && y0 <= y1;
+}
+
+template<class T>
+void ActiveZones<T>::RemoveCoveredZones( const unsigned int x0, const unsigned int y0, const unsigned int x1, const unsigned int y1 )
+{
+	zones_.erase(
+		std::remove_if(
+			zones_.begin(), zones_.end(),
+			[&]( const Zone& zone ) { return zone.IsInside( x0, y0, x1, y1 ); } ),
+		zones_.end() );
+}
+
+template<class T>
+void ActiveZones<T>::SetCellsActive( const unsigned int x0, const unsigned int y0, const unsigned int x1, const unsigned int y1, const bool active )
+{
+	const unsigned int width= x1 - x0 + 1u;
+	const RowBits row_mask=
+		width >= MapData::c_map_size
+			? ~RowBits(0u)
+			: ( ( RowBits(1u) << width ) - 1u ) << x0;
+
+	for( unsigned int y= y0; y <= y1; y++ )
+	{
+		if( active )
+			active_cells_[y]|= row_mask;
+		else
+			active_cells_[y]&= ~row_mask;
+	}
+
+	empty_= true;
+	for( const RowBits row : active_cells_ )
+	{
+		if( row != 0u )
+		{
+			empty_= false;
+			break;
+		}
+	}
+
+	if( empty_ )
+		zones_.clear();
+}
+
+} // namespace PanzerChasm
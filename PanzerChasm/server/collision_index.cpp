@@ -5,130 +5,201 @@
 namespace PanzerChasm
 {
 
-CollisionIndex::CollisionIndex( const MapDataConstPtr& map_data )
+// Calls func( x, y ) for each cell, intersected by wall.
+template<class Func>
+static void ProcessWallCells( const m_Vec2* const vert_pos, const Func& func )
 {
-	PC_ASSERT( map_data != nullptr );
-
-	for( unsigned short& i : index_field_ )
-		i= IndexElement::c_dummy_next;
-
-	for( const MapData::Wall& wall : map_data->static_walls )
+	if( vert_pos[0] == vert_pos[1] )
 	{
-		if( wall.vert_pos[0] == wall.vert_pos[1] )
-			continue;
+		const int x= static_cast<int>( std::floor( vert_pos[0].x ) );
+		const int y= static_cast<int>( std::floor( vert_pos[0].y ) );
+		if( x >= 0 && x < int(MapData::c_map_size) &&
+			y >= 0 && y < int(MapData::c_map_size) )
+			func( x, y );
+		return;
+	}
 
-		MapData::IndexElement wall_index_element;
-		wall_index_element.type= MapData::IndexElement::StaticWall;
-		wall_index_element.index= &wall - map_data->static_walls.data();
-
-		const m_Vec2 dir= wall.vert_pos[1] - wall.vert_pos[0];
-		if( std::abs( dir.x ) >= std::abs( dir.y ) )
+	const m_Vec2 dir= vert_pos[1] - vert_pos[0];
+	if( std::abs( dir.x ) >= std::abs( dir.y ) )
+	{
+		// X Major
+		m_Vec2 v[2];
+		if( dir.x > 0.0f )
 		{
-			// X Major
-			m_Vec2 v[2];
-			if( dir.x > 0.0f )
-			{
-				v[0]= wall.vert_pos[0];
-				v[1]= wall.vert_pos[1];
-			}
-			else
-			{
-				v[0]= wall.vert_pos[1];
-				v[1]= wall.vert_pos[0];
-			}
+			v[0]= vert_pos[0];
+			v[1]= vert_pos[1];
+		}
+		else
+		{
+			v[0]= vert_pos[1];
+			v[1]= vert_pos[0];
+		}
 
-			const float dy_dx= ( v[1].y - v[0].y ) / ( v[1].x - v[0].x );
+		const float dy_dx= ( v[1].y - v[0].y ) / ( v[1].x - v[0].x );
 
-			const int start_x= std::max( static_cast<int>( std::floor( v[0].x ) ), 0 );
-			const int   end_x= std::min( static_cast<int>( std::floor( v[1].x ) ), int(MapData::c_map_size - 1u) );
+		const int start_x= std::max( static_cast<int>( std::floor( v[0].x ) ), 0 );
+		const int   end_x= std::min( static_cast<int>( std::floor( v[1].x ) ), int(MapData::c_map_size - 1u) );
 
-			for( int x= start_x; x <= end_x; x++ )
-			{
-				const float cell_x_start= std::max( float(x  ), v[0].x );
-				const float cell_x_end  = std::min( float(x+1), v[1].x );
+		for( int x= start_x; x <= end_x; x++ )
+		{
+			const float cell_x_start= std::max( float(x  ), v[0].x );
+			const float cell_x_end  = std::min( float(x+1), v[1].x );
 
-				float cell_y_start= v[0].y + dy_dx * ( cell_x_start - v[0].x );
-				float cell_y_end  = v[0].y + dy_dx * ( cell_x_end   - v[0].x );
-				if( cell_y_start > cell_y_end ) std::swap( cell_y_start, cell_y_end );
+			float cell_y_start= v[0].y + dy_dx * ( cell_x_start - v[0].x );
+			float cell_y_end  = v[0].y + dy_dx * ( cell_x_end   - v[0].x );
+			if( cell_y_start > cell_y_end ) std::swap( cell_y_start, cell_y_end );
 
-				const int cell_y_start_i= std::max( static_cast<int>( std::floor( cell_y_start ) ), 0 );
-				const int cell_y_end_i  = std::min( static_cast<int>( std::floor( cell_y_end   ) ), int(MapData::c_map_size - 1u) );
-				for( int y= cell_y_start_i; y <= cell_y_end_i; y++ )
-					AddElementToIndex( x, y, wall_index_element );
-			}
+			const int cell_y_start_i= std::max( static_cast<int>( std::floor( cell_y_start ) ), 0 );
+			const int cell_y_end_i  = std::min( static_cast<int>( std::floor( cell_y_end   ) ), int(MapData::c_map_size - 1u) );
+			for( int y= cell_y_start_i; y <= cell_y_end_i; y++ )
+				func( x, y );
+		}
+	}
+	else
+	{
+		// Y Major
+		m_Vec2 v[2];
+		if( dir.y > 0.0f )
+		{
+			v[0]= vert_pos[0];
+			v[1]= vert_pos[1];
 		}
 		else
 		{
-			// Y Major
-			m_Vec2 v[2];
-			if( dir.y > 0.0f )
-			{
-				v[0]= wall.vert_pos[0];
-				v[1]= wall.vert_pos[1];
-			}
-			else
-			{
-				v[0]= wall.vert_pos[1];
-				v[1]= wall.vert_pos[0];
-			}
+			v[0]= vert_pos[1];
+			v[1]= vert_pos[0];
+		}
 
-			const float dx_dy= ( v[1].x - v[0].x ) / ( v[1].y - v[0].y );
+		const float dx_dy= ( v[1].x - v[0].x ) / ( v[1].y - v[0].y );
 
-			const int start_y= std::max( static_cast<int>( std::floor( v[0].y ) ), 0 );
-			const int   end_y= std::min( static_cast<int>( std::floor( v[1].y ) ), int(MapData::c_map_size - 1u) );
+		const int start_y= std::max( static_cast<int>( std::floor( v[0].y ) ), 0 );
+		const int   end_y= std::min( static_cast<int>( std::floor( v[1].y ) ), int(MapData::c_map_size - 1u) );
 
-			for( int y= start_y; y <= end_y; y++ )
-			{
-				const float cell_y_start= std::max( float(y  ), v[0].y );
-				const float cell_y_end  = std::min( float(y+1), v[1].y );
+		for( int y= start_y; y <= end_y; y++ )
+		{
+			const float cell_y_start= std::max( float(y  ), v[0].y );
+			const float cell_y_end  = std::min( float(y+1), v[1].y );
 
-				float cell_x_start= v[0].x + dx_dy * ( cell_y_start - v[0].y );
-				float cell_x_end  = v[0].x + dx_dy * ( cell_y_end   - v[0].y );
-				if( cell_x_start > cell_x_end ) std::swap( cell_x_start, cell_x_end );
+			float cell_x_start= v[0].x + dx_dy * ( cell_y_start - v[0].y );
+			float cell_x_end  = v[0].x + dx_dy * ( cell_y_end   - v[0].y );
+			if( cell_x_start > cell_x_end ) std::swap( cell_x_start, cell_x_end );
 
-				const int cell_x_start_i= std::max( static_cast<int>( std::floor( cell_x_start ) ), 0 );
-				const int cell_x_end_i  = std::min( static_cast<int>( std::floor( cell_x_end   ) ), int(MapData::c_map_size - 1u) );
-				for( int x= cell_x_start_i; x <= cell_x_end_i; x++ )
-					AddElementToIndex( x, y, wall_index_element );
-			}
+			const int cell_x_start_i= std::max( static_cast<int>( std::floor( cell_x_start ) ), 0 );
+			const int cell_x_end_i  = std::min( static_cast<int>( std::floor( cell_x_end   ) ), int(MapData::c_map_size - 1u) );
+			for( int x= cell_x_start_i; x <= cell_x_end_i; x++ )
+				func( x, y );
 		}
-	} // for static walls
+	}
+}
 
-	const auto add_model_to_dynamics_list=
-	[&]( const MapData::StaticModel& model )
-	{
-		dynamic_models_indeces_.emplace_back( &model - map_data->static_models.data() );
-	};
+// Calls func( x, y ) for each cell, intersected by model bounding square.
+template<class Func>
+static void ProcessModelCells( const m_Vec2& pos, const float radius, const Func& func )
+{
+	const int x_start= std::max( static_cast<int>( std::floor( pos.x - radius ) ), 0 );
+	const int x_end  = std::min( static_cast<int>( std::floor( pos.x + radius ) ), int(MapData::c_map_size - 1u) );
+	const int y_start= std::max( static_cast<int>( std::floor( pos.y - radius ) ), 0 );
+	const int y_end  = std::min( static_cast<int>( std::floor( pos.y + radius ) ), int(MapData::c_map_size - 1u) );
 
-	for( const MapData::StaticModel& model : map_data->static_models )
+	// TODO - use circle, not quad.
+	for( int y= y_start; y <= y_end; y++ )
+	for( int x= x_start; x <= x_end; x++ )
+		func( x, y );
+}
+
+static unsigned short GetCellIndex( const int x, const int y )
+{
+	return static_cast<unsigned short>( x + y * int(MapData::c_map_size) );
+}
+
+CollisionIndex::CollisionIndex( const MapDataConstPtr& map_data )
+	: static_walls_count_( static_cast<unsigned int>( map_data->static_walls.size() ) )
+	, total_elements_count_(
+		static_cast<unsigned int>(
+			map_data->static_walls.size() + map_data->dynamic_walls.size() + map_data->static_models.size() ) )
+{
+	PC_ASSERT( map_data != nullptr );
+
+	for( unsigned short& i : index_field_ )
+		i= IndexElement::c_dummy_next;
+
+	for( const MapData::Wall& wall : map_data->static_walls )
 	{
-		if( model.is_dynamic ||
-			model.model_id >= map_data->models_description.size() )
-		{
-			add_model_to_dynamics_list( model );
+		if( wall.vert_pos[0] == wall.vert_pos[1] )
 			continue;
-		}
 
-		const MapData::ModelDescription& description= map_data->models_description[ model.model_id ];
-		if( description.blow_effect != 0 ) // Breakable - do not add to index.
-		{
-			add_model_to_dynamics_list( model );
-			continue;
-		}
+		MapData::IndexElement wall_index_element;
+		wall_index_element.type= MapData::IndexElement::StaticWall;
+		wall_index_element.index= &wall - map_data->static_walls.data();
+
+		ProcessWallCells(
+			wall.vert_pos,
+			[&]( const int x, const int y )
+			{
+				AddElementToIndex( x, y, wall_index_element );
+			} );
+	} // for static walls
+
+	// Dynamic walls. Place them into mutable index, using initial position.
+	dynamic_walls_cells_.resize( map_data->dynamic_walls.size() );
+	for( unsigned int w= 0u; w < map_data->dynamic_walls.size(); w++ )
+	{
+		DynamicElementCells& wall_cells= dynamic_walls_cells_[w];
+		wall_cells.pos[0]= map_data->dynamic_walls[w].vert_pos[0];
+		wall_cells.pos[1]= map_data->dynamic_walls[w].vert_pos[1];
+		wall_cells.radius= 0.0f;
 
+		MapData::IndexElement wall_index_element;
+		wall_index_element.type= MapData::IndexElement::DynamicWall;
+		wall_index_element.index= w;
+
+		ProcessWallCells(
+			wall_cells.pos,
+			[&]( const int x, const int y )
+			{
+				wall_cells.cells.push_back( GetCellIndex( x, y ) );
+				dynamic_index_field_[ GetCellIndex( x, y ) ].push_back( wall_index_element );
+			} );
+	}
+
+	dynamic_models_cells_.resize( map_data->static_models.size() );
+	model_is_dynamic_.resize( map_data->static_models.size(), false );
+	for( const MapData::StaticModel& model : map_data->static_models )
+	{
 		MapData::IndexElement model_index_element;
 		model_index_element.type= MapData::IndexElement::StaticModel;
 		model_index_element.index= &model - map_data->static_models.data();
 
-		const int x_start= std::max( static_cast<int>( std::floor( model.pos.x - description.radius ) ), 0 );
-		const int x_end  = std::min( static_cast<int>( std::floor( model.pos.x + description.radius ) ), int(MapData::c_map_size - 1u) );
-		const int y_start= std::max( static_cast<int>( std::floor( model.pos.y - description.radius ) ), 0 );
-		const int y_end  = std::min( static_cast<int>( std::floor( model.pos.y + description.radius ) ), int(MapData::c_map_size - 1u) );
+		const MapData::ModelDescription* const description=
+			model.model_id < map_data->models_description.size()
+				? &map_data->models_description[ model.model_id ]
+				: nullptr;
+
+		// Place dynamic and breakable models into mutable index.
+		if( model.is_dynamic || description == nullptr || description->blow_effect != 0 )
+		{
+			model_is_dynamic_[ model_index_element.index ]= true;
+
+			DynamicElementCells& model_cells= dynamic_models_cells_[ model_index_element.index ];
+			model_cells.pos[0]= model_cells.pos[1]= model.pos;
+			model_cells.radius= description == nullptr ? 0.0f : description->radius;
 
-		// TODO - use circle, not quad.
-		for( int y= y_start; y <= y_end; y++ )
-		for( int x= x_start; x <= x_end; x++ )
-			AddElementToIndex( x, y, model_index_element );
+			ProcessModelCells(
+				model_cells.pos[0], model_cells.radius,
+				[&]( const int x, const int y )
+				{
+					model_cells.cells.push_back( GetCellIndex( x, y ) );
+					dynamic_index_field_[ GetCellIndex( x, y ) ].push_back( model_index_element );
+				} );
+			continue;
+		}
+
+		ProcessModelCells(
+			model.pos, description->radius,
+			[&]( const int x, const int y )
+			{
+				AddElementToIndex( x, y, model_index_element );
+			} );
 	} // for models
 }
 
@@ -153,4 +224,88 @@ void CollisionIndex::AddElementToIndex( unsigned int x, unsigned int y, const Ma
 	index_field_[ x + y * MapData::c_map_size ]= index_elements_.size() - 1u;
 }
 
+void CollisionIndex::UpdateDynamicWall( const unsigned int wall_index, const m_Vec2& vert_pos0, const m_Vec2& vert_pos1 )
+{
+	PC_ASSERT( wall_index < dynamic_walls_cells_.size() );
+	DynamicElementCells& wall_cells= dynamic_walls_cells_[ wall_index ];
+
+	if( wall_cells.pos[0] == vert_pos0 && wall_cells.pos[1] == vert_pos1 )
+		return;
+	wall_cells.pos[0]= vert_pos0;
+	wall_cells.pos[1]= vert_pos1;
+
+	dynamic_cells_temp_.clear();
+	ProcessWallCells(
+		wall_cells.pos,
+		[&]( const int x, const int y )
+		{
+			dynamic_cells_temp_.push_back( GetCellIndex( x, y ) );
+		} );
+
+	MapData::IndexElement wall_index_element;
+	wall_index_element.type= MapData::IndexElement::DynamicWall;
+	wall_index_element.index= wall_index;
+	UpdateDynamicElementCells( wall_index_element, wall_cells );
+}
+
+void CollisionIndex::UpdateDynamicModel( const unsigned int model_index, const m_Vec2& pos, const float radius )
+{
+	PC_ASSERT( model_index < dynamic_models_cells_.size() );
+	if( !model_is_dynamic_[ model_index ] )
+		return;
+
+	DynamicElementCells& model_cells= dynamic_models_cells_[ model_index ];
+	if( model_cells.pos[0] == pos && model_cells.radius == radius )
+		return;
+	model_cells.pos[0]= model_cells.pos[1]= pos;
+	model_cells.radius= radius;
+
+	dynamic_cells_temp_.clear();
+	ProcessModelCells(
+		pos, radius,
+		[&]( const int x, const int y )
+		{
+			dynamic_cells_temp_.push_back( GetCellIndex( x, y ) );
+		} );
+
+	MapData::IndexElement model_index_element;
+	model_index_element.type= MapData::IndexElement::StaticModel;
+	model_index_element.index= model_index;
+	UpdateDynamicElementCells( model_index_element, model_cells );
+}
+
+CollisionIndex::RayCastVisitedSet& CollisionIndex::GetRayCastVisitedSet()
+{
+	// Use separate set for each thread, because ray casts may be performed in parallel.
+	static thread_local RayCastVisitedSet visited_set;
+	return visited_set;
+}
+
+void CollisionIndex::UpdateDynamicElementCells( const MapData::IndexElement& element, DynamicElementCells& element_cells )
+{
+	// Small movements usually does not change cells.
+	if( dynamic_cells_temp_ == element_cells.cells )
+		return;
+
+	for( const unsigned short cell : element_cells.cells )
+	{
+		DynamicCell& cell_elements= dynamic_index_field_[ cell ];
+		for( unsigned int i= 0u; i < cell_elements.size(); i++ )
+		{
+			if( cell_elements[i].type == element.type && cell_elements[i].index == element.index )
+			{
+				if( i != cell_elements.size() - 1u )
+					cell_elements[i]= cell_elements.back();
+				cell_elements.pop_back();
+				break;
+			}
+		}
+	}
+
+	for( const unsigned short cell : dynamic_cells_temp_ )
+		dynamic_index_field_[ cell ].push_back( element );
+
+	element_cells.cells.swap( dynamic_cells_temp_ );
+}
+
 } // namespace PanzerChasm
@@ -7,29 +7,69 @@ namespace PanzerChasm
 
 // Class for collisions calculations optimization.
 // It can fast fetch only potential-collidable objects.
-// Supported only "static walls" and "models" from map data.
-// Dynamic walls not supported.
+// Static walls and static models are placed in immutable index.
+// Dynamic walls and dynamic models ( movable, breakable ) are placed in mutable index.
+// Mutable index initialized with initial objects positions and must be updated, when objects move.
 class CollisionIndex final
 {
 public:
 	explicit CollisionIndex( const MapDataConstPtr& map_data );
 	~CollisionIndex();
 
+	// Places element into new cells, if cells, covered by element, changed.
+	void UpdateDynamicWall( unsigned int wall_index, const m_Vec2& vert_pos0, const m_Vec2& vert_pos1 );
+	// Does nothing for models from immutable index.
+	void UpdateDynamicModel( unsigned int model_index, const m_Vec2& pos, float radius );
+
 	template<class Func>
 	void ProcessElementsInRadius(
 		const m_Vec2& pos, float radius,
 		const Func& func ) const;
 
 	// Func must return true, if need abort.
+	// Elements are fetched in order of cells along ray, each element is fetched only once.
+	// If "nearest_hit_distance" is not null, ray cast stops, when all cells nearer, than this distance, are processed.
+	// Caller can update value of "nearest_hit_distance" inside func.
+	// Thread-safe.
 	template<class Func>
 	void RayCast(
 		const m_Vec3& pos, const m_Vec3& dir_normalized,
 		const Func& func,
-		float max_cast_distance= Constants::max_float ) const;
+		float max_cast_distance= Constants::max_float,
+		const float* nearest_hit_distance= nullptr ) const;
+
+private:
+	// Cells, covered by dynamic element.
+	struct DynamicElementCells
+	{
+		// Geometry for which cells calculated. Wall vertices or model position.
+		m_Vec2 pos[2];
+		float radius;
+
+		std::vector<unsigned short> cells;
+	};
+
+	typedef std::vector<MapData::IndexElement> DynamicCell;
+
+	// Visited elements marks for ray casting. Element is visited, if it has mark of current ray cast.
+	struct RayCastVisitedSet
+	{
+		std::vector<unsigned int> generations;
+		unsigned int current_generation= 0u;
+	};
 
 private:
 	void AddElementToIndex( unsigned int x, unsigned int y, const MapData::IndexElement& element );
 
+	// Returns unique number of element in range [0; total_elements_count_).
+	unsigned int GetElementNumber( const MapData::IndexElement& element ) const;
+
+	// Returns set for current thread.
+	static RayCastVisitedSet& GetRayCastVisitedSet();
+
+	// Moves element from old cells to cells from "dynamic_cells_temp_", if cells changed.
+	void UpdateDynamicElementCells( const MapData::IndexElement& element, DynamicElementCells& element_cells );
+
 private:
 	struct IndexElement
 	{
@@ -45,14 +85,23 @@ private:
 	static constexpr float c_fetch_distance_eps_= 0.1f;
 
 private:
+	unsigned int static_walls_count_;
+	unsigned int total_elements_count_;
+
 	// Linked lists data.
 	std::vector<IndexElement> index_elements_;
 
-	// Indeces of models, which can`t be placed in index - dynamic, breakable, etc.
-	std::vector<unsigned short> dynamic_models_indeces_;
-
 	// Linked lists heads.
 	unsigned short index_field_[ MapData::c_map_size * MapData::c_map_size ];
+
+	std::vector<DynamicElementCells> dynamic_walls_cells_;
+	// For all models, but used only for dynamic models.
+	std::vector<DynamicElementCells> dynamic_models_cells_;
+	std::vector<bool> model_is_dynamic_;
+
+	std::vector<unsigned short> dynamic_cells_temp_;
+
+	DynamicCell dynamic_index_field_[ MapData::c_map_size * MapData::c_map_size ];
 };
 
 } // namespace PanzerChasm
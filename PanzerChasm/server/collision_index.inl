@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+
 #include "../game_constants.hpp"
 #include "collisions.hpp"
 
@@ -31,15 +33,9 @@ void CollisionIndex::ProcessElementsInRadius(
 			func( element.index_element );
 			i= element.next;
 		}
-	}
 
-	// Process dynamic models without any optimizations
-	for( const unsigned short dynamic_model_index : dynamic_models_indeces_ )
-	{
-		MapData::IndexElement element;
-		element.type= MapData::IndexElement::StaticModel;
-		element.index= dynamic_model_index;
-		func( element );
+		for( const MapData::IndexElement& element : dynamic_index_field_[ x + y * int(MapData::c_map_size) ] )
+			func( element );
 	}
 }
 
@@ -47,11 +43,14 @@ template<class Func>
 void CollisionIndex::RayCast(
 	const m_Vec3& pos, const m_Vec3& dir_normalized,
 	const Func& func,
-	const float max_cast_distance ) const
+	const float max_cast_distance,
+	const float* const nearest_hit_distance ) const
 {
+	const float dir_xy_length= dir_normalized.xy().Length();
+
 	float end_distance_xy=
 		std::min(
-			max_cast_distance * dir_normalized.xy().Length(),
+			max_cast_distance * dir_xy_length,
 			float( MapData::c_map_size * 2u ) );
 
 	if( pos.z >= 0.0f && pos.z <= GameConstants::walls_height )
@@ -80,79 +79,138 @@ void CollisionIndex::RayCast(
 		// TODO
 	}
 
-	m_Vec2 dir_xy= dir_normalized.xy();
-	dir_xy.Normalize();
+	// Elements may be placed in many cells. Visit each element only once per ray cast.
+	RayCastVisitedSet& visited_set= GetRayCastVisitedSet();
+	if( visited_set.generations.size() < total_elements_count_ )
+		visited_set.generations.resize( total_elements_count_, 0u );
+	visited_set.current_generation++;
+	if( visited_set.current_generation == 0u )
+	{
+		std::fill( visited_set.generations.begin(), visited_set.generations.end(), 0u );
+		visited_set.current_generation= 1u;
+	}
+
+	// Returns true, if need abort.
+	const auto process_element=
+	[&]( const MapData::IndexElement& element ) -> bool
+	{
+		unsigned int& generation= visited_set.generations[ GetElementNumber( element ) ];
+		if( generation == visited_set.current_generation )
+			return false;
+		generation= visited_set.current_generation;
 
-	int prev_x= std::numeric_limits<int>::max();
-	int prev_y= std::numeric_limits<int>::max();
+		return func( element );
+	};
 
-	const unsigned int max_distance_xy_i= static_cast<unsigned int>( std::ceil( end_distance_xy ) );
-	for( unsigned int i= 0u; i <= max_distance_xy_i; i++ )
+	// Returns true, if need abort.
+	const auto process_cell=
+	[&]( const int x, const int y ) -> bool
 	{
-		const m_Vec2 sample_pos= pos.xy() + dir_xy * float(i);
-		const int x= static_cast<int>( std::floor( sample_pos.x ) );
-		const int y= static_cast<int>( std::floor( sample_pos.y ) );
+		if( x < 0 || x >= int(MapData::c_map_size) ||
+			y < 0 || y >= int(MapData::c_map_size) )
+			return false;
 
-		if( x == prev_x && y == prev_y )
+		unsigned short index= index_field_[ x + y * int(MapData::c_map_size) ];
+		while( index != IndexElement::c_dummy_next )
 		{
-			// Nothing to do - already checked.
+			PC_ASSERT( index <= index_elements_.size() );
+			const IndexElement& element= index_elements_[index];
+
+			if( process_element( element.index_element ) )
+				return true;
+
+			index= element.next;
 		}
-		else if( x != prev_x && y != prev_y && i != 0u )
+
+		for( const MapData::IndexElement& element : dynamic_index_field_[ x + y * int(MapData::c_map_size) ] )
+			if( process_element( element ) )
+				return true;
+
+		return false;
+	};
+
+	// Exact grid traversal. See "A Fast Voxel Traversal Algorithm for Ray Tracing", Amanatides, Woo.
+	int x= static_cast<int>( std::floor( pos.x ) );
+	int y= static_cast<int>( std::floor( pos.y ) );
+
+	if( dir_xy_length <= 0.0f )
+	{
+		// Vertical ray - check only start cell.
+		process_cell( x, y );
+		return;
+	}
+
+	const m_Vec2 dir_xy= dir_normalized.xy() / dir_xy_length;
+
+	const int step_x= dir_xy.x > 0.0f ? 1 : -1;
+	const int step_y= dir_xy.y > 0.0f ? 1 : -1;
+
+	// Distance along ray for crossing of one cell.
+	const float t_delta_x= dir_xy.x != 0.0f ? std::abs( 1.0f / dir_xy.x ) : Constants::max_float;
+	const float t_delta_y= dir_xy.y != 0.0f ? std::abs( 1.0f / dir_xy.y ) : Constants::max_float;
+
+	// Distance along ray to next cell border.
+	float t_max_x=
+		dir_xy.x > 0.0f ? ( float(x + 1) - pos.x ) * t_delta_x :
+		dir_xy.x < 0.0f ? ( pos.x - float(x) ) * t_delta_x :
+		Constants::max_float;
+	float t_max_y=
+		dir_xy.y > 0.0f ? ( float(y + 1) - pos.y ) * t_delta_y :
+		dir_xy.y < 0.0f ? ( pos.y - float(y) ) * t_delta_y :
+		Constants::max_float;
+
+	while(true)
+	{
+		if( process_cell( x, y ) )
+			return;
+
+		const float cell_exit_distance= std::min( t_max_x, t_max_y );
+		if( cell_exit_distance >= end_distance_xy )
+			break;
+
+		// All elements, nearer, than found hit, are already processed.
+		if( nearest_hit_distance != nullptr &&
+			*nearest_hit_distance * dir_xy_length <= cell_exit_distance )
+			break;
+
+		if( t_max_x < t_max_y )
 		{
-			// Check this and neighbor cells.
-			const int cells[6]= { x, y,   prev_x, y,  x, prev_y };
-
-			for( unsigned int c= 0u; c < 6u; c+= 2u )
-			{
-				if( cells[c+0u] >= 0 && cells[c+0u] < int(MapData::c_map_size) &&
-					cells[c+1u] >= 0 && cells[c+1u] < int(MapData::c_map_size) )
-				{
-					unsigned short index= index_field_[ cells[c] + cells[c+1u] * int(MapData::c_map_size) ];
-					while( index != IndexElement::c_dummy_next )
-					{
-						PC_ASSERT( index <= index_elements_.size() );
-						const IndexElement& element= index_elements_[index];
-
-						if( func( element.index_element ) )
-							return;
-
-						index= element.next;
-					}
-				}
-			}
+			x+= step_x;
+			t_max_x+= t_delta_x;
 		}
 		else
 		{
-			// Check one cell.
-			if( x >= 0 && x < int(MapData::c_map_size) &&
-				y >= 0 && y < int(MapData::c_map_size) )
-			{
-				unsigned short index= index_field_[ x + y * int(MapData::c_map_size) ];
-				while( index != IndexElement::c_dummy_next )
-				{
-					PC_ASSERT( index <= index_elements_.size() );
-					const IndexElement& element= index_elements_[index];
-
-					if( func( element.index_element ) )
-						return;
-
-					index= element.next;
-				}
-			}
+			y+= step_y;
+			t_max_y+= t_delta_y;
 		}
 
-		prev_x= x;
-		prev_y= y;
-	} // line trace
+		// Stop, if ray leaves map.
+		if( ( x < 0 && step_x < 0 ) || ( x >= int(MapData::c_map_size) && step_x > 0 ) ||
+			( y < 0 && step_y < 0 ) || ( y >= int(MapData::c_map_size) && step_y > 0 ) )
+			break;
+	} // grid traversal
+}
 
-	// Process dynamic models without any optimizations.
-	for( const unsigned short dynamic_model_index : dynamic_models_indeces_ )
+inline unsigned int CollisionIndex::GetElementNumber( const MapData::IndexElement& element ) const
+{
+	switch( element.type )
 	{
-		MapData::IndexElement element;
-		element.type= MapData::IndexElement::StaticModel;
-		element.index= dynamic_model_index;
-		func( element );
-	}
+	case MapData::IndexElement::StaticWall:
+		PC_ASSERT( element.index < static_walls_count_ );
+		return element.index;
+
+	case MapData::IndexElement::DynamicWall:
+		PC_ASSERT( element.index < dynamic_walls_cells_.size() );
+		return static_walls_count_ + element.index;
+
+	case MapData::IndexElement::StaticModel:
+		PC_ASSERT( element.index < dynamic_models_cells_.size() );
+		return static_walls_count_ + static_cast<unsigned int>( dynamic_walls_cells_.size() ) + element.index;
+
+	default:
+		PC_ASSERT(false);
+		return 0u;
+	};
 }
 
 } // namespace PanzerChasm
@@ -0,0 +1,320 @@
+#include "../assert.hpp"
+#include "player_interest.hpp"
+
+#include "delta_snapshots.hpp"
+
+namespace PanzerChasm
+{
+
+// Compare messages field by field - messages may contain uninitialized padding bits.
+
+static bool StatesEqual( const Messages::WallPosition& l, const Messages::WallPosition& r )
+{
+	return
+		l.wall_index == r.wall_index &&
+		l.vertices_xy[0][0] == r.vertices_xy[0][0] &&
+		l.vertices_xy[0][1] == r.vertices_xy[0][1] &&
+		l.vertices_xy[1][0] == r.vertices_xy[1][0] &&
+		l.vertices_xy[1][1] == r.vertices_xy[1][1] &&
+		l.z == r.z &&
+		l.texture_id == r.texture_id;
+}
+
+static bool StatesEqual( const Messages::StaticModelState& l, const Messages::StaticModelState& r )
+{
+	return
+		l.static_model_index == r.static_model_index &&
+		l.xyz[0] == r.xyz[0] && l.xyz[1] == r.xyz[1] && l.xyz[2] == r.xyz[2] &&
+		l.angle == r.angle &&
+		l.animation_frame == r.animation_frame &&
+		l.visible == r.visible &&
+		l.animation_playing == r.animation_playing &&
+		l.model_id == r.model_id;
+}
+
+static bool StatesEqual( const Messages::ItemState& l, const Messages::ItemState& r )
+{
+	return
+		l.item_index == r.item_index &&
+		l.z == r.z &&
+		l.picked == r.picked;
+}
+
+static bool StatesEqual( const Messages::MonsterState& l, const Messages::MonsterState& r )
+{
+	return
+		l.monster_id == r.monster_id &&
+		l.xyz[0] == r.xyz[0] && l.xyz[1] == r.xyz[1] && l.xyz[2] == r.xyz[2] &&
+		l.angle == r.angle &&
+		l.monster_type == r.monster_type &&
+		l.body_parts_mask == r.body_parts_mask &&
+		l.animation == r.animation &&
+		l.animation_frame == r.animation_frame &&
+		l.is_fully_dead == r.is_fully_dead &&
+		l.is_invisible == r.is_invisible &&
+		l.color == r.color;
+}
+
+static bool StatesEqual( const Messages::RocketState& l, const Messages::RocketState& r )
+{
+	return
+		l.rocket_id == r.rocket_id &&
+		l.xyz[0] == r.xyz[0] && l.xyz[1] == r.xyz[1] && l.xyz[2] == r.xyz[2] &&
+		l.angle[0] == r.angle[0] && l.angle[1] == r.angle[1];
+}
+
+constexpr unsigned int DeltaSnapshots::ClientState::c_max_unacknowledged_snapshots;
+
+void DeltaSnapshots::ClientState::Reset()
+{
+	walls.clear();
+	static_models.clear();
+	items.clear();
+	monsters.clear();
+	rockets.clear();
+
+	for( SentSnapshot& sent_snapshot : sent_snapshots )
+	{
+		sent_snapshot.sequence= 0u;
+		sent_snapshot.entities.clear();
+	}
+}
+
+void DeltaSnapshots::ClientState::Acknowledge( const unsigned int sequence, const unsigned int previous_snapshots_mask )
+{
+	if( sequence == 0u )
+		return;
+
+	MarkSnapshotReceived( sequence );
+	for( unsigned int i= 0u; i < 32u; i++ )
+	{
+		if( ( previous_snapshots_mask & ( 1u << i ) ) != 0u && sequence > i + 1u )
+			MarkSnapshotReceived( sequence - 1u - i );
+	}
+
+	// Client never receives snapshots earlier, than acknowledged, so, they are not needed anymore.
+	for( SentSnapshot& sent_snapshot : sent_snapshots )
+	{
+		if( sent_snapshot.sequence <= sequence )
+		{
+			sent_snapshot.sequence= 0u;
+			sent_snapshot.entities.clear();
+		}
+	}
+}
+
+void DeltaSnapshots::ClientState::MarkSnapshotReceived( const unsigned int sequence )
+{
+	const SentSnapshot& sent_snapshot= sent_snapshots[ sequence % c_max_unacknowledged_snapshots ];
+	if( sent_snapshot.sequence != sequence )
+		return; // Snapshot is too old or already acknowledged.
+
+	for( const SentEntity& entity : sent_snapshot.entities )
+	{
+		EntityRecord* record= nullptr;
+		switch( entity.kind )
+		{
+		case EntityKind::Wall:
+			if( entity.index < walls.size() )
+				record= &walls[ entity.index ];
+			break;
+		case EntityKind::StaticModel:
+			if( entity.index < static_models.size() )
+				record= &static_models[ entity.index ];
+			break;
+		case EntityKind::Item:
+			if( entity.index < items.size() )
+				record= &items[ entity.index ];
+			break;
+		case EntityKind::Monster:
+			{
+				const auto it= monsters.find( entity.index );
+				if( it != monsters.end() )
+					record= &it->second;
+			}
+			break;
+		case EntityKind::Rocket:
+			{
+				const auto it= rockets.find( entity.index );
+				if( it != rockets.end() )
+					record= &it->second;
+			}
+			break;
+		};
+
+		// Entity may be received already in later snapshot.
+		if( record != nullptr && record->received_sequence < sequence )
+			record->received_sequence= sequence;
+	}
+}
+
+DeltaSnapshots::DeltaSnapshots()
+{}
+
+DeltaSnapshots::~DeltaSnapshots()
+{}
+
+void DeltaSnapshots::BeginSnapshot( const unsigned int sequence )
+{
+	PC_ASSERT( sequence > sequence_ );
+	sequence_= sequence;
+}
+
+void DeltaSnapshots::SetWallState( const Messages::WallPosition& message, const m_Vec3& pos )
+{
+	SetIndexedState( walls_states_, message.wall_index, message, pos );
+}
+
+void DeltaSnapshots::SetStaticModelState( const Messages::StaticModelState& message, const m_Vec3& pos )
+{
+	SetIndexedState( static_models_states_, message.static_model_index, message, pos );
+}
+
+void DeltaSnapshots::SetItemState( const Messages::ItemState& message, const m_Vec3& pos )
+{
+	SetIndexedState( items_states_, message.item_index, message, pos );
+}
+
+void DeltaSnapshots::SetMonsterState( const Messages::MonsterState& message, const m_Vec3& pos )
+{
+	SetState( monsters_states_[ message.monster_id ], message, pos );
+}
+
+void DeltaSnapshots::SetRocketState( const Messages::RocketState& message, const m_Vec3& pos )
+{
+	SetState( rockets_states_[ message.rocket_id ], message, pos );
+}
+
+void DeltaSnapshots::EndSnapshot()
+{
+	for( auto it= monsters_states_.begin(); it != monsters_states_.end(); )
+	{
+		if( it->second.update_sequence != sequence_ )
+			it= monsters_states_.erase( it );
+		else
+			++it;
+	}
+	for( auto it= rockets_states_.begin(); it != rockets_states_.end(); )
+	{
+		if( it->second.update_sequence != sequence_ )
+			it= rockets_states_.erase( it );
+		else
+			++it;
+	}
+}
+
+void DeltaSnapshots::SendSnapshot( MessagesSender& messages_sender, const PlayerInterest& interest, ClientState& client_state ) const
+{
+	Messages::SnapshotBegin begin_message;
+	begin_message.sequence= sequence_;
+	messages_sender.SendUnreliableMessage( begin_message );
+
+	ClientState::SentSnapshot& sent_snapshot= client_state.sent_snapshots[ sequence_ % ClientState::c_max_unacknowledged_snapshots ];
+	sent_snapshot.sequence= sequence_;
+	sent_snapshot.entities.clear();
+
+	SendContext context{ messages_sender, interest, sent_snapshot, 0u };
+
+	SendIndexedStates( walls_states_, EntityKind::Wall, client_state.walls, context );
+	SendIndexedStates( static_models_states_, EntityKind::StaticModel, client_state.static_models, context );
+	SendIndexedStates( items_states_, EntityKind::Item, client_state.items, context );
+	SendEntitiesStates( monsters_states_, EntityKind::Monster, client_state.monsters, context );
+	SendEntitiesStates( rockets_states_, EntityKind::Rocket, client_state.rockets, context );
+
+	Messages::SnapshotEnd end_message;
+	end_message.sequence= sequence_;
+	end_message.state_messages_count= context.state_messages_count;
+	messages_sender.SendUnreliableMessage( end_message );
+}
+
+template<class Message>
+void DeltaSnapshots::SetState( EntityState<Message>& state, const Message& message, const m_Vec3& pos )
+{
+	if( state.update_sequence == 0u || !StatesEqual( state.message, message ) )
+	{
+		state.message= message;
+		state.change_sequence= sequence_;
+	}
+	state.pos= pos;
+	state.update_sequence= sequence_;
+}
+
+template<class Message>
+void DeltaSnapshots::SetIndexedState(
+	std::vector< EntityState<Message> >& states,
+	const unsigned int index,
+	const Message& message,
+	const m_Vec3& pos )
+{
+	if( index >= states.size() )
+		states.resize( index + 1u );
+
+	SetState( states[ index ], message, pos );
+}
+
+template<class Message>
+void DeltaSnapshots::SendIndexedStates(
+	const std::vector< EntityState<Message> >& states,
+	const EntityKind kind,
+	std::vector<ClientState::EntityRecord>& records,
+	SendContext& context )
+{
+	if( records.size() < states.size() )
+		records.resize( states.size() );
+
+	for( unsigned int i= 0u; i < states.size(); i++ )
+		SendStateIfNeeded( states[i], kind, EntityId(i), records[i], context );
+}
+
+template<class Message>
+void DeltaSnapshots::SendEntitiesStates(
+	const EntitiesContainer< EntityState<Message> >& states,
+	const EntityKind kind,
+	EntitiesContainer<ClientState::EntityRecord>& records,
+	SendContext& context )
+{
+	for( const auto& state_value : states )
+		SendStateIfNeeded( state_value.second, kind, state_value.first, records[ state_value.first ], context );
+
+	// Remove records of dead entities.
+	if( records.size() > states.size() )
+	{
+		for( auto it= records.begin(); it != records.end(); )
+		{
+			if( states.find( it->first ) == states.end() )
+				it= records.erase( it );
+			else
+				++it;
+		}
+	}
+}
+
+template<class Message>
+void DeltaSnapshots::SendStateIfNeeded(
+	const EntityState<Message>& state,
+	const EntityKind kind,
+	const EntityId index,
+	ClientState::EntityRecord& record,
+	SendContext& context )
+{
+	if( state.change_sequence <= record.received_sequence )
+		return; // Client already has this state.
+
+	// Accumulate priority, while state is not sent. So, low-priority states are sent with lower rate.
+	record.priority_accumulator+= context.interest.GetUpdatePriority( state.pos );
+	if( record.priority_accumulator < 1.0f )
+		return;
+	record.priority_accumulator-= 1.0f;
+
+	Message message= state.message;
+	message.snapshot_sequence= context.sent_snapshot.sequence;
+	context.messages_sender.SendUnreliableMessage( message );
+	context.state_messages_count++;
+
+	ClientState::SentEntity sent_entity;
+	sent_entity.kind= kind;
+	sent_entity.index= index;
+	context.sent_snapshot.entities.push_back( sent_entity );
+}
+
+} // namespace PanzerChasm
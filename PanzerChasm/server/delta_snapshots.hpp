@@ -0,0 +1,154 @@
+#pragma once
+#include <vector>
+
+#include <vec.hpp>
+
+#include "../entities_container.hpp"
+#include "../game_constants.hpp"
+#include "../messages.hpp"
+#include "../messages_sender.hpp"
+
+namespace PanzerChasm
+{
+
+class PlayerInterest;
+
+// Last states of map entities for delta snapshots.
+// Each server loop map writes states of all walls, models, items, monsters and rockets. For each state sequence of
+// snapshot, where state was changed last time, is stored.
+// For each client and each entity sequence of last acknowledged snapshot with state of this entity is stored.
+// Only states, changed after this snapshot, are sent to client. Changed states of entities with low priority
+// for client are sent not in each snapshot, but with lower rate.
+class DeltaSnapshots final
+{
+public:
+	enum class EntityKind : unsigned char
+	{
+		Wall,
+		StaticModel,
+		Item,
+		Monster,
+		Rocket,
+	};
+
+	// Per-client state of snapshots. Keep it for each client and reset it on map change.
+	struct ClientState
+	{
+		struct EntityRecord
+		{
+			unsigned int received_sequence= 0u; // Last acknowledged snapshot with state of entity.
+			float priority_accumulator= 0.0f;
+		};
+
+		struct SentEntity
+		{
+			EntityKind kind;
+			EntityId index; // Index of wall, model, item or id of monster, rocket.
+		};
+
+		struct SentSnapshot
+		{
+			unsigned int sequence= 0u; // Zero for free slot.
+			std::vector<SentEntity> entities;
+		};
+
+		// Acknowledgement must arrive before slot of its snapshot is reused, else states from this snapshot are sent again.
+		// So, ring buffer must hold all snapshots, sent during round trip time, for maximum server loops frequency.
+		static constexpr unsigned int c_max_round_trip_time_s= 2u;
+		static constexpr unsigned int c_max_unacknowledged_snapshots=
+			c_max_round_trip_time_s * GameConstants::max_server_loops_per_second;
+
+		void Reset();
+		// Marks states, sent in snapshot and in previous snapshots from mask, as received.
+		// Bit i of mask means snapshot with sequence "sequence - 1 - i".
+		// Snapshots, sent earlier, are never acknowledged after this.
+		void Acknowledge( unsigned int sequence, unsigned int previous_snapshots_mask );
+
+		std::vector<EntityRecord> walls;
+		std::vector<EntityRecord> static_models;
+		std::vector<EntityRecord> items;
+		EntitiesContainer<EntityRecord> monsters;
+		EntitiesContainer<EntityRecord> rockets;
+
+		SentSnapshot sent_snapshots[ c_max_unacknowledged_snapshots ]; // Ring buffer, indexed by sequence.
+
+	private:
+		void MarkSnapshotReceived( unsigned int sequence );
+	};
+
+public:
+	DeltaSnapshots();
+	~DeltaSnapshots();
+
+	// Sequence must increase from snapshot to snapshot. Zero sequence is reserved for "nothing acknowledged".
+	void BeginSnapshot( unsigned int sequence );
+	void SetWallState( const Messages::WallPosition& message, const m_Vec3& pos );
+	void SetStaticModelState( const Messages::StaticModelState& message, const m_Vec3& pos );
+	void SetItemState( const Messages::ItemState& message, const m_Vec3& pos );
+	void SetMonsterState( const Messages::MonsterState& message, const m_Vec3& pos );
+	void SetRocketState( const Messages::RocketState& message, const m_Vec3& pos );
+	// Removes states of monsters and rockets, which are not set in this snapshot.
+	void EndSnapshot();
+
+	// Sends states, not received by client, between "SnapshotBegin" and "SnapshotEnd" messages.
+	void SendSnapshot( MessagesSender& messages_sender, const PlayerInterest& interest, ClientState& client_state ) const;
+
+private:
+	template<class Message>
+	struct EntityState
+	{
+		Message message;
+		m_Vec3 pos;
+		unsigned int change_sequence= 0u; // Last snapshot, where state was changed.
+		unsigned int update_sequence= 0u; // Last snapshot, where state was set. Zero for new states.
+	};
+
+	// Temporary data for sending of one snapshot.
+	struct SendContext
+	{
+		MessagesSender& messages_sender;
+		const PlayerInterest& interest;
+		ClientState::SentSnapshot& sent_snapshot;
+		unsigned int state_messages_count;
+	};
+
+private:
+	template<class Message>
+	void SetState( EntityState<Message>& state, const Message& message, const m_Vec3& pos );
+
+	template<class Message>
+	void SetIndexedState( std::vector< EntityState<Message> >& states, unsigned int index, const Message& message, const m_Vec3& pos );
+
+	template<class Message>
+	static void SendIndexedStates(
+		const std::vector< EntityState<Message> >& states,
+		EntityKind kind,
+		std::vector<ClientState::EntityRecord>& records,
+		SendContext& context );
+
+	template<class Message>
+	static void SendEntitiesStates(
+		const EntitiesContainer< EntityState<Message> >& states,
+		EntityKind kind,
+		EntitiesContainer<ClientState::EntityRecord>& records,
+		SendContext& context );
+
+	template<class Message>
+	static void SendStateIfNeeded(
+		const EntityState<Message>& state,
+		EntityKind kind,
+		EntityId index,
+		ClientState::EntityRecord& record,
+		SendContext& context );
+
+private:
+	unsigned int sequence_= 0u;
+
+	std::vector< EntityState<Messages::WallPosition> > walls_states_;
+	std::vector< EntityState<Messages::StaticModelState> > static_models_states_;
+	std::vector< EntityState<Messages::ItemState> > items_states_;
+	EntitiesContainer< EntityState<Messages::MonsterState> > monsters_states_;
+	EntitiesContainer< EntityState<Messages::RocketState> > rockets_states_;
+};
+
+} // namespace PanzerChasm
@@ -23,4 +23,6 @@ typedef std::weak_ptr<const Player> PlayerConstWeakPtr;
 
 class Server;
 
+class TickProfiler;
+
 } // namespace PanzerChasm
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstring>
 
 #include <matrix.hpp>
@@ -10,7 +11,10 @@
 #include "collisions.hpp"
 #include "collision_index.inl"
 #include "monster.hpp"
+#include "monsters_index.inl"
 #include "player.hpp"
+#include "player_interest.hpp"
+#include "tick_profiler.hpp"
 
 #include "map.hpp"
 
@@ -18,6 +22,14 @@ namespace PanzerChasm
 {
 
 static const float g_commands_coords_scale= 1.0f / 256.0f;
+static const float g_items_respawn_time_s= 60.0f; // TODO - select correct respawn time for each item.
+
+// Timer events may fire a bit earlier, than their condition becomes true, because of rounding.
+// Retry such events in next tick.
+static Time GetTimerRetryTime( const Time current_time )
+{
+	return current_time + Time::FromInternalRepresentation(1);
+}
 
 static unsigned int AnimationNumberToModelNumber( const unsigned int animation_number )
 {
@@ -80,6 +92,27 @@ void Map::ProcessElementLinks(
 	}
 }
 
+template<class Func>
+void Map::ProcessInParallel( const unsigned int count, const unsigned int elements_per_task, const Func& func )
+{
+	if( count <= elements_per_task || thread_pool_.GetThreadsCount() <= 1u )
+	{
+		func( 0u, count );
+		return;
+	}
+
+	for( unsigned int first= 0u; first < count; first+= elements_per_task )
+	{
+		const unsigned int last= std::min( first + elements_per_task, count );
+		thread_pool_.AddTask(
+			[&func, first, last]
+			{
+				func( first, last );
+			} );
+	}
+	thread_pool_.WaitAll();
+}
+
 Map::Map(
 	const DifficultyType difficulty,
 	const GameRules game_rules,
@@ -95,16 +128,17 @@ Map::Map(
 	, map_end_callback_( std::move( map_end_callback ) )
 	, text_message_callback_(std::move(text_message_callback) )
 	, random_generator_( std::make_shared<LongRand>() )
+	, max_monster_radius_( GetMaxMonsterRadius( *game_resources ) )
 	, collision_index_( map_data )
+	, visibility_matrix_( map_data->visibility_matrix )
+	, navigation_( *map_data, collision_index_ )
 {
 	PC_ASSERT( map_data_ != nullptr );
+	PC_ASSERT( visibility_matrix_ != nullptr );
 	PC_ASSERT( game_resources_ != nullptr );
 
 	unsigned int difficulty_mask= static_cast<unsigned int>( difficulty_ );
 
-	std::memset( wind_field_, 0, sizeof(wind_field_) );
-	std::memset( death_field_, 0, sizeof(death_field_) );
-
 	procedures_.resize( map_data_->procedures.size() );
 	for( unsigned int p= 0u; p < procedures_.size(); p++ )
 	{
@@ -219,6 +253,8 @@ Map::Map(
 							random_generator_,
 							map_start_time ) );
 
+			monsters_index_.AddMonster( monster_id, *monster );
+
 			monsters_birth_messages_.emplace_back();
 			Messages::MonsterBirth& message= monsters_birth_messages_.back();
 
@@ -295,6 +331,7 @@ EntityId Map::SpawnPlayer( const PlayerPtr& player )
 	players_.emplace( player_id, player );
 	const MonstersContainer::value_type& monster_value=
 		* monsters_.emplace( player_id, player ).first;
+	monsters_index_.AddMonster( player_id, *player );
 
 	monsters_birth_messages_.emplace_back();
 	Messages::MonsterBirth& message= monsters_birth_messages_.back();
@@ -310,6 +347,7 @@ void Map::DespawnPlayer( const EntityId player_id )
 {
 	const bool erased= players_.erase( player_id ) != 0u;
 	monsters_.erase( player_id );
+	monsters_index_.RemoveMonster( player_id );
 
 	if( erased )
 	{
@@ -370,6 +408,10 @@ void Map::PlantMine(
 	mine.owner_id= owner_monster_id;
 	next_rocket_id_++;
 
+	timer_wheel_.Schedule(
+		current_time + Time::FromSeconds( double(GameConstants::mines_preparation_time_s) ) - Time::FromInternalRepresentation(1),
+		TimerEvent{ TimerEvent::Type::MineTurnOn, mine.id } );
+
 	dynamic_items_birth_messages_.emplace_back();
 	PrepareMineBirthMessage( mine, dynamic_items_birth_messages_.back() );
 }
@@ -464,25 +506,33 @@ m_Vec3 Map::CollideWithMap(
 	float new_z= in_pos.z;
 
 	// Store list of objects, collisions with which alread processed.
+	// Dynamic walls have separate list, so, many static walls and models can not exhaust limit for dynamic walls.
 	constexpr unsigned int c_max_collisions= 32u;
-	MapData::IndexElement processed_collisions[ c_max_collisions ];
-	unsigned int processed_collisions_count= 0u;
+	MapData::IndexElement processed_collisions[2][ c_max_collisions ];
+	unsigned int processed_collisions_count[2]= { 0u, 0u };
+	const auto collisions_list_index=
+	[]( const MapData::IndexElement& index_element ) -> unsigned int
+	{
+		return index_element.type == MapData::IndexElement::DynamicWall ? 1u : 0u;
+	};
 	const auto collision_processed=
 	[&]( const MapData::IndexElement& index_element )
 	{
-		if( processed_collisions_count == c_max_collisions )
+		const unsigned int list_index= collisions_list_index( index_element );
+		if( processed_collisions_count[ list_index ] == c_max_collisions )
 			return true;
-		for( unsigned int i= 0u; i < processed_collisions_count; i++ )
-			if( std::memcmp( &processed_collisions[i], &index_element, sizeof(MapData::IndexElement) ) == 0 )
+		for( unsigned int i= 0u; i < processed_collisions_count[ list_index ]; i++ )
+			if( std::memcmp( &processed_collisions[ list_index ][i], &index_element, sizeof(MapData::IndexElement) ) == 0 )
 				return true;
 		return false;
 	};
 	const auto process_collision=
 	[&]( const MapData::IndexElement& index_element )
 	{
-		PC_ASSERT( processed_collisions_count < c_max_collisions );
-		processed_collisions[ processed_collisions_count ]= index_element;
-		processed_collisions_count++;
+		const unsigned int list_index= collisions_list_index( index_element );
+		PC_ASSERT( processed_collisions_count[ list_index ] < c_max_collisions );
+		processed_collisions[ list_index ][ processed_collisions_count[ list_index ] ]= index_element;
+		processed_collisions_count[ list_index ]++;
 	};
 
 	const auto elements_process_func=
@@ -597,49 +647,48 @@ m_Vec3 Map::CollideWithMap(
 				}
 			}
 		}
-		else
+		else if( index_element.type == MapData::IndexElement::DynamicWall )
 		{
-			// TODO
-		}
-	};
-
-	collision_index_.ProcessElementsInRadius(
-		pos, radius,
-		elements_process_func );
+			PC_ASSERT( index_element.index < dynamic_walls_.size() );
+			const DynamicWall& wall= dynamic_walls_[ index_element.index ];
 
-	// Dynamic walls
-	for( const DynamicWall& wall : dynamic_walls_ )
-	{
-		if( wall.vert_pos[0] == wall.vert_pos[1] )
-			continue;
+			if( wall.vert_pos[0] == wall.vert_pos[1] )
+				return;
 
-		const MapData::WallTextureDescription& tex= map_data_->walls_textures[ wall.texture_id ];
-		if( tex.gso[0] )
-			continue;
+			const MapData::WallTextureDescription& tex= map_data_->walls_textures[ wall.texture_id ];
+			if( tex.gso[0] )
+				return;
 
-		// PROCESS.05:
-		// ;  up            [ x,y] [ H]   [s:num]     ,if H>=80 then walktrough
-		if( wall.z >= 80.0f / 64.0f )
-			continue;
+			// PROCESS.05:
+			// ;  up            [ x,y] [ H]   [s:num]     ,if H>=80 then walktrough
+			if( wall.z >= 80.0f / 64.0f )
+				return;
 
-		if( z_top < wall.z || z_bottom > wall.z + GameConstants::walls_height )
-			continue;
+			if( z_top < wall.z || z_bottom > wall.z + GameConstants::walls_height )
+				return;
 
-		// Do not collide with wall, if we are behind it. But collide, if wall is transparent.
-		if( wall.texture_id < MapData::c_first_transparent_texture_id &&
-			mVec2Cross( pos - wall.vert_pos[0], wall.vert_pos[1] - wall.vert_pos[0] ) > 0.0f )
-			continue;
+			// Do not collide with wall, if we are behind it. But collide, if wall is transparent.
+			if( wall.texture_id < MapData::c_first_transparent_texture_id &&
+				mVec2Cross( pos - wall.vert_pos[0], wall.vert_pos[1] - wall.vert_pos[0] ) > 0.0f )
+				return;
 
-		m_Vec2 new_pos;
-		if( CollideCircleWithLineSegment(
-				wall.vert_pos[0], wall.vert_pos[1],
-				pos, radius,
-				new_pos ) )
-		{
-			pos= new_pos;
-			out_movement_restriction.AddRestriction( GetNormalForWall( wall ).xy() );
+			m_Vec2 new_pos;
+			if( CollideCircleWithLineSegment(
+					wall.vert_pos[0], wall.vert_pos[1],
+					pos, radius,
+					new_pos ) )
+			{
+				process_collision( index_element );
+				pos= new_pos;
+				out_movement_restriction.AddRestriction( GetNormalForWall( wall ).xy() );
+			}
 		}
-	}
+	};
+
+	// Static walls, dynamic walls, map models.
+	collision_index_.ProcessElementsInRadius(
+		pos, radius,
+		elements_process_func );
 
 	if( new_z <= 0.0f )
 	{
@@ -657,6 +706,12 @@ bool Map::CanSee( const m_Vec3& from, const m_Vec3& to ) const
 	if( from == to )
 		return true;
 
+	// Fast reject by static walls visibility. Matrix is valid only for lines inside walls height range.
+	if( from.z >= 0.0f && from.z <= GameConstants::walls_height &&
+		to.z >= 0.0f && to.z <= GameConstants::walls_height &&
+		!visibility_matrix_->MayBeVisible( from.xy(), to.xy() ) )
+		return false;
+
 	m_Vec3 direction= to - from;
 	const float max_see_distance= direction.Length();
 	direction.Normalize();
@@ -722,6 +777,26 @@ bool Map::CanSee( const m_Vec3& from, const m_Vec3& to ) const
 					return true;
 			}
 		}
+		else if( element.type == MapData::IndexElement::DynamicWall )
+		{
+			PC_ASSERT( element.index < dynamic_walls_.size() );
+			const DynamicWall& wall= dynamic_walls_[ element.index ];
+
+			const MapData::WallTextureDescription& wall_texture= map_data_->walls_textures[ wall.texture_id ];
+			if( wall_texture.gso[1] )
+				return false;
+
+			m_Vec3 candidate_pos;
+			if( RayIntersectWall(
+					wall.vert_pos[0], wall.vert_pos[1],
+					wall.z, wall.z + 2.0f,
+					from, direction,
+					candidate_pos ) )
+			{
+				if( try_set_occluder( candidate_pos ) )
+					return true;
+			}
+		}
 		else
 		{
 			PC_ASSERT( false );
@@ -729,39 +804,30 @@ bool Map::CanSee( const m_Vec3& from, const m_Vec3& to ) const
 		return false;
 	};
 
-	// Static walls and map models.
+	// Static walls, dynamic walls, map models.
 	collision_index_.RayCast(
 		from, direction,
 		element_process_func,
 		max_see_distance );
 
-	// Dynamic walls.
-	for( const DynamicWall& wall : dynamic_walls_ )
-	{
-		const MapData::WallTextureDescription& wall_texture= map_data_->walls_textures[ wall.texture_id ];
-		if( wall_texture.gso[1] )
-			continue;
-
-		m_Vec3 candidate_pos;
-		if( RayIntersectWall(
-				wall.vert_pos[0], wall.vert_pos[1],
-				wall.z, wall.z + 2.0f,
-				from, direction,
-				candidate_pos ) )
-		{
-			if( try_set_occluder( candidate_pos ) )
-				break;
-		}
-	}
-
 	return can_see;
 }
 
+bool Map::GetMoveDirection( const EntityId player_id, const m_Vec2& from, const m_Vec2& to, m_Vec2& out_direction ) const
+{
+	return navigation_.GetMoveDirection( player_id, from, to, out_direction );
+}
+
 const Map::MonstersContainer& Map::GetMonsters() const
 {
 	return monsters_;
 }
 
+unsigned int Map::GetGeometryRevision() const
+{
+	return geometry_revision_;
+}
+
 const Map::PlayersContainer& Map::GetPlayers() const
 {
 	return players_;
@@ -952,22 +1018,7 @@ void Map::ProcessPlayerPosition(
 	//Process items
 	for( Item& item : items_ )
 	{
-		if( !item.enabled )
-			continue;
-
-		if( item.picked_up && game_rules_ == GameRules::Deathmatch )
-		{
-			const float time_since_picked_up_s= ( current_time - item.pick_up_time ).ToSeconds();
-			const float respawn_time_s= 60.0f; // TODO - select correct respawn time for each item.
-			if( time_since_picked_up_s >= respawn_time_s )
-			{
-				// Respawn item.
-				// TODO - add light flash effect.
-				item.picked_up= false;
-			}
-		}
-
-		if( item.picked_up )
+		if( !item.enabled || item.picked_up )
 			continue;
 
 		const float square_distance= ( item.pos.xy() - pos ).SquareLength();
@@ -977,6 +1028,10 @@ void Map::ProcessPlayerPosition(
 			if( item.picked_up )
 			{
 				item.pick_up_time= current_time;
+				if( game_rules_ == GameRules::Deathmatch )
+					timer_wheel_.Schedule(
+						current_time + Time::FromSeconds( double(g_items_respawn_time_s) ),
+						TimerEvent{ TimerEvent::Type::ItemRespawn, static_cast<unsigned int>( &item - items_.data() ) } );
 
 				const ACode a_code= static_cast<ACode>( game_resources_->items_description[ item.item_id ].a_code );
 				if( a_code >= ACode::Weapon_First && a_code <= ACode::Weapon_Last )
@@ -1032,7 +1087,7 @@ void Map::ProcessPlayerPosition(
 	}
 }
 
-void Map::Tick( const Time current_time, const Time last_tick_delta )
+void Map::Tick( const Time current_time, const Time last_tick_delta, TickProfiler& profiler )
 {
 	const Time prev_tick_time= current_time - last_tick_delta;
 	const unsigned int death_ticks=
@@ -1041,92 +1096,114 @@ void Map::Tick( const Time current_time, const Time last_tick_delta )
 
 	const float last_tick_delta_s= last_tick_delta.ToSeconds();
 
-	// Update state of procedures
-	for( unsigned int p= 0u; p < procedures_.size(); p++ )
-	{
-		const MapData::Procedure& procedure= map_data_->procedures[p];
-		ProcedureState& procedure_state= procedures_[p];
+	ProcessTimerEvents( current_time );
 
-		const Time time_since_last_state_change= current_time - procedure_state.last_state_change_time;
-		const float new_stage=
-			procedure.speed > 0.0f
-				? ( time_since_last_state_change.ToSeconds() * procedure.speed * GameConstants::procedures_speed_scale )
-				: 1.0f;
+	// Update state of active procedures.
+	// Procedures may be activated while processing of other procedures, so, search position of next procedure after each step.
+	{
+		const TickProfiler::ScopedTimer timer( profiler, TickProfiler::Phase::Procedures );
+		for( unsigned int i= 0u; i < active_procedures_.size(); )
+		{
+			const unsigned int p= active_procedures_[i];
+			const MapData::Procedure& procedure= map_data_->procedures[p];
+			ProcedureState& procedure_state= procedures_[p];
 
-		// Check map end
-		if( procedure_state.movement_state != ProcedureState::MovementState::None &&
-			procedure.end_delay_s > 0.0f &&
-			time_since_last_state_change.ToSeconds() >= procedure.end_delay_s )
-			map_end_triggered_= true;
+			const Time time_since_last_state_change= current_time - procedure_state.last_state_change_time;
+			const float new_stage=
+				procedure.speed > 0.0f
+					? ( time_since_last_state_change.ToSeconds() * procedure.speed * GameConstants::procedures_speed_scale )
+					: 1.0f;
 
-		switch( procedure_state.movement_state )
-		{
-		case ProcedureState::MovementState::None:
-			break;
+			// Check map end
+			if( procedure_state.movement_state != ProcedureState::MovementState::None &&
+				procedure.end_delay_s > 0.0f &&
+				time_since_last_state_change.ToSeconds() >= procedure.end_delay_s )
+				map_end_triggered_= true;
 
-		case ProcedureState::MovementState::StartWait:
-			if( time_since_last_state_change.ToSeconds() >= procedure.start_delay_s )
+			switch( procedure_state.movement_state )
 			{
-				ActivateProcedureSwitches( procedure, true, current_time );
-				DoProcedureImmediateCommands( procedure, current_time );
-				EmitProcedureSound( procedure );
-				procedure_state.movement_state= ProcedureState::MovementState::Movement;
-				procedure_state.movement_stage= 0.0f;
-				procedure_state.last_state_change_time= current_time;
-			}
-			else
-				procedure_state.movement_stage= new_stage;
-			break;
+			case ProcedureState::MovementState::None:
+				break;
 
-		case ProcedureState::MovementState::Movement:
-			if( new_stage >= 1.0f )
-			{
-				// TODO - do it at the end of movement?
-				// Maybe, do this at end of reverse-movement?
-				DoProcedureDeactivationCommands( procedure );
+			case ProcedureState::MovementState::StartWait:
+				if( time_since_last_state_change.ToSeconds() >= procedure.start_delay_s )
+				{
+					ActivateProcedureSwitches( procedure, true, current_time );
+					DoProcedureImmediateCommands( procedure, current_time );
+					EmitProcedureSound( procedure );
+					procedure_state.movement_state= ProcedureState::MovementState::Movement;
+					procedure_state.movement_stage= 0.0f;
+					procedure_state.last_state_change_time= current_time;
+				}
+				else
+					procedure_state.movement_stage= new_stage;
+				break;
 
-				procedure_state.movement_state= ProcedureState::MovementState::BackWait;
-				procedure_state.movement_stage= 0.0f;
-				procedure_state.last_state_change_time= current_time;
-			}
-			else
-				procedure_state.movement_stage= new_stage;
-			break;
+			case ProcedureState::MovementState::Movement:
+				if( new_stage >= 1.0f )
+				{
+					// TODO - do it at the end of movement?
+					// Maybe, do this at end of reverse-movement?
+					DoProcedureDeactivationCommands( procedure );
 
-		case ProcedureState::MovementState::BackWait:
-		{
-			const Time wait_time= current_time - procedure_state.last_state_change_time;
-			if(
-				procedure.back_wait_s > 0.0f &&
-				wait_time.ToSeconds() >= procedure.back_wait_s )
+					procedure_state.movement_state= ProcedureState::MovementState::BackWait;
+					procedure_state.movement_stage= 0.0f;
+					procedure_state.last_state_change_time= current_time;
+				}
+				else
+					procedure_state.movement_stage= new_stage;
+				break;
+
+			case ProcedureState::MovementState::BackWait:
 			{
-				ActivateProcedureSwitches( procedure, false, current_time );
-				DeactivateProcedureLightSources( procedure );
-				procedure_state.movement_state= ProcedureState::MovementState::ReverseMovement;
-				procedure_state.movement_stage= 0.0f;
-				procedure_state.last_state_change_time= current_time;
+				const Time wait_time= current_time - procedure_state.last_state_change_time;
+				if(
+					procedure.back_wait_s > 0.0f &&
+					wait_time.ToSeconds() >= procedure.back_wait_s )
+				{
+					ActivateProcedureSwitches( procedure, false, current_time );
+					DeactivateProcedureLightSources( procedure );
+					procedure_state.movement_state= ProcedureState::MovementState::ReverseMovement;
+					procedure_state.movement_stage= 0.0f;
+					procedure_state.last_state_change_time= current_time;
+				}
 			}
-		}
-			break;
+				break;
 
-		case ProcedureState::MovementState::ReverseMovement:
-			// Emit reverse movement sound if we really start move and not blocked by player.
-			if( procedure_state.movement_stage <= 0.01f && new_stage > 0.01f )
-				EmitProcedureSound( procedure );
+			case ProcedureState::MovementState::ReverseMovement:
+				// Emit reverse movement sound if we really start move and not blocked by player.
+				if( procedure_state.movement_stage <= 0.01f && new_stage > 0.01f )
+					EmitProcedureSound( procedure );
 
-			if( new_stage >= 1.0f )
-			{
-				procedure_state.movement_state= ProcedureState::MovementState::None;
-				procedure_state.movement_stage= 0.0f;
-				procedure_state.last_state_change_time= current_time;
-			}
-			else
-				procedure_state.movement_stage= new_stage;
-			break;
-		}; // switch state
-	} // for procedures
+				if( new_stage >= 1.0f )
+				{
+					procedure_state.movement_state= ProcedureState::MovementState::None;
+					procedure_state.movement_stage= 0.0f;
+					procedure_state.last_state_change_time= current_time;
+				}
+				else
+					procedure_state.movement_stage= new_stage;
+				break;
+			}; // switch state
+
+			i= static_cast<unsigned int>( std::upper_bound( active_procedures_.begin(), active_procedures_.end(), p ) - active_procedures_.begin() );
+		} // for procedures
+
+		// Remove waiting procedures from active list. They will be woken up by timer events.
+		active_procedures_.erase(
+			std::remove_if(
+				active_procedures_.begin(), active_procedures_.end(),
+				[&]( const unsigned int p )
+				{
+					return TryPutProcedureToSleep( p, current_time );
+				} ),
+			active_procedures_.end() );
+	}
 
-	MoveMapObjects( current_time );
+	{
+		const TickProfiler::ScopedTimer timer( profiler, TickProfiler::Phase::MoveMapObjects );
+		MoveMapObjects( current_time );
+	}
 
 	// Process static models
 	for( StaticModel& model : static_models_ )
@@ -1187,667 +1264,455 @@ void Map::Tick( const Time current_time, const Time last_tick_delta )
 			model.current_animation_frame= model.animation_start_frame;
 	} // for static models
 
-	// Process shots
-	for( unsigned int r= 0u; r < rockets_.size(); )
 	{
-		Rocket& rocket= rockets_[r];
-		const GameResources::RocketDescription& rocket_description= game_resources_->rockets_description[ rocket.rocket_type_id ];
+		const TickProfiler::ScopedTimer timer( profiler, TickProfiler::Phase::Rockets );
+		ProcessRockets( current_time, last_tick_delta_s );
+	}
 
-		const bool has_infinite_speed= rocket.HasInfiniteSpeed( *game_resources_ );
-		const float time_delta_s= ( current_time - rocket.start_time ).ToSeconds();
+	// Process mines
+	{
+		const TickProfiler::ScopedTimer timer( profiler, TickProfiler::Phase::Mines );
+		for( unsigned int m= 0u; m < mines_.size(); )
+		{
+			Mine& mine= mines_[m];
+			if( !mine.turned_on )
+			{
+				// Mine is turned on by timer event.
+				m++;
+				continue;
+			}
 
-		HitResult hit_result;
+			const float time_delta_s= ( current_time - mine.planting_time ).ToSeconds();
 
-		if( has_infinite_speed )
-			hit_result= ProcessShot( rocket.start_point, rocket.normalized_direction, Constants::max_float, rocket.owner_id );
-		else
-		{
-			const float c_length_eps= 1.0f / 64.0f;
-			const float gravity_force= GameConstants::rockets_gravity_scale * float( rocket_description.gravity_force );
-			const float speed= rocket_description.fast ? GameConstants::fast_rockets_speed : GameConstants::rockets_speed;
+			bool need_kill= false;
 
-			m_Vec3 new_pos;
-			if( rocket_description.reflect )
+			if( time_delta_s > 30.0f ) // Kill too old mines
+				need_kill= true;
+			else
 			{
-				rocket.speed.z-= gravity_force * last_tick_delta_s;
-				new_pos= rocket.previous_position + rocket.speed * last_tick_delta_s;
+				// Try activate mine.
+				bool activated= false;
+				monsters_index_.ProcessMonstersInRadius(
+					mine.pos.xy(), GameConstants::mines_activation_radius + max_monster_radius_,
+					[&]( EntityId, const MonsterBase& monster )
+					{
+						const float square_distance= ( monster.Position().xy() - mine.pos.xy() ).SquareLength();
 
-				if( new_pos.z < 0.0f ) // Reflect.
-				{
-					new_pos.z= 0.0f;
-					rocket.speed.z= std::abs( rocket.speed.z );
-				}
+						const float monster_radius=
+							monster.MonsterId() == 0u
+								? GameConstants::player_radius :
+								game_resources_->monsters_description[ monster.MonsterId() ].w_radius;
 
-				rocket.normalized_direction= rocket.speed;
-				rocket.normalized_direction.Normalize();
-			}
-			else if( rocket_description.Auto2 )
-			{
-				m_Vec3 target_pos;
-				if( FindNearestPlayerPos( rocket.previous_position, target_pos ) )
+						const float activation_distance= GameConstants::mines_activation_radius + monster_radius;
+						if( square_distance < activation_distance * activation_distance )
+							activated= true;
+					} );
+
+				if( activated )
 				{
-					m_Vec3 dir_to_target= target_pos - rocket.previous_position;
-					dir_to_target.Normalize();
+					need_kill= true;
 
-					m_Vec3 rot_axis= mVec3Cross( rocket.normalized_direction, dir_to_target );
-					const float rot_axis_square_length= rot_axis.SquareLength();
-					if( rot_axis_square_length < 0.001f * 0.001f )
-						rot_axis= m_Vec3( 0.0f, 0.0f, 1.0f );
+					// TODO - maybe add some random damage variations, like with rockets and bullets?
+					DoExplosionDamage(
+						mine.pos, GameConstants::mines_explosion_radius,
+						GameConstants::mines_damage,
+						mine.owner_id, current_time );
 
-					const float c_rot_speed= Constants::half_pi;
-					m_Mat4 mat;
-					mat.Rotate( rot_axis, last_tick_delta_s * c_rot_speed );
+					particles_effects_messages_.emplace_back();
+					Messages::ParticleEffectBirth& message= particles_effects_messages_.back();
+					message.effect_id= static_cast<unsigned char>(ParticleEffect::Explosion);
+					PositionToMessagePosition( mine.pos, message.xyz );
 
-					rocket.normalized_direction= rocket.normalized_direction * mat;
-					rocket.normalized_direction.Normalize();
+					PlayMapEventSound( mine.pos, 40u );
 				}
-
-				new_pos= rocket.previous_position + rocket.normalized_direction * speed * last_tick_delta_s;
 			}
-			else
+
+			if( need_kill )
 			{
-				new_pos=
-					rocket.start_point +
-					rocket.normalized_direction * ( time_delta_s * speed ) +
-					m_Vec3( 0.0f, 0.0f, -1.0f ) * ( gravity_force * time_delta_s * time_delta_s * 0.5f );
+				dynamic_items_death_messages_.emplace_back();
+				dynamic_items_death_messages_.back().item_id= mine.id;
+
+				if( m != mines_.size() - 1u )
+					mine= mines_.back();
+				mines_.pop_back();
 			}
+			else
+				m++;
+		}
+	}
 
-			m_Vec3 dir= new_pos - rocket.previous_position;
-			const float max_distance= dir.Length() + c_length_eps;
-			dir.Normalize();
+	// Update paths to players. Monsters use them in think phase.
+	{
+		const TickProfiler::ScopedTimer timer( profiler, TickProfiler::Phase::Navigation );
+		navigation_.Update( players_ );
+	}
 
-			hit_result= ProcessShot( rocket.previous_position, dir, max_distance, rocket.owner_id );
+	// Process monsters.
+	// Read-only think phase runs in parallel, after that monsters tick serially in container order.
+	// So, results do not depend on threads count and on order of think tasks execution.
+	{
+		const TickProfiler::ScopedTimer timer( profiler, TickProfiler::Phase::MonstersThink );
+		ThinkMonsters( current_time );
+	}
+	{
+		const TickProfiler::ScopedTimer timer( profiler, TickProfiler::Phase::MonstersTick );
 
-			if( rocket_description.reflect &&
-				hit_result.object_type == HitResult::ObjectType::Floor && hit_result.object_index == 0u )
-				hit_result.object_type= HitResult::ObjectType::None; // Reflecting rockets does not hit floors.
+		// Skip zones sampling, if there are no active zones.
+		const bool have_wind= !wind_zones_.Empty();
+		const bool have_death_zones= !death_zones_.Empty() && death_ticks > 0u;
 
-			// Emit smoke trail
-			const unsigned int sprite_effect_id=
-				game_resources_->rockets_description[ rocket.rocket_type_id ].smoke_trail_effect_id;
-			if( sprite_effect_id != 0u )
+		for( MonstersContainer::value_type& monster_value : monsters_ )
+		{
+			monster_value.second->Tick( *this, monster_value.first, current_time, last_tick_delta );
+
+			// Process teleports for monster
+			MonsterBase& monster= *monster_value.second;
+
+			const float c_teleport_radius= 0.5f;
+
+			for( const MapData::Teleport& teleport : map_data_->teleports )
 			{
-				const float c_particels_per_unit= 2.0f; // TODO - calibrate
-				const float length_delta= ( new_pos - rocket.previous_position ).Length() * c_particels_per_unit;
-				const float new_track_length= rocket.track_length + length_delta;
-				for( unsigned int i= static_cast<unsigned int>( rocket.track_length ) + 1u;
-					i <= static_cast<unsigned int>( new_track_length ); i++ )
-				{
-					const float part= ( float(i) - rocket.track_length ) / length_delta;
+				const m_Vec2 tele_pos( float(teleport.from[0]) + 0.5f, float(teleport.from[1]) + 0.5f );
 
-					sprite_effects_.emplace_back();
-					SpriteEffect& effect= sprite_effects_.back();
+				if( ( tele_pos - monster.Position().xy() ).SquareLength() >= c_teleport_radius * c_teleport_radius )
+					continue;
 
-					effect.pos= ( 1.0f - part ) * rocket.previous_position + part * new_pos;
-					effect.effect_id= sprite_effect_id;
+				m_Vec2 dst;
+				for( unsigned int j= 0u; j < 2u; j++ )
+				{
+					if( teleport.to[j] >= MapData::c_map_size )
+						dst.ToArr()[j]= float( teleport.to[j] ) / 256.0f;
+					else
+						dst.ToArr()[j]= float( teleport.to[j] );
 				}
+				monster.Teleport(
+					m_Vec3(
+						dst,
+						GetFloorLevel( dst, GameConstants::player_radius ) ),
+					teleport.angle );
 
-				rocket.track_length= new_track_length;
+				// Emit random teleport sound at destination point.
+				PlayMapEventSound(
+					m_Vec3( dst, GameConstants::walls_height * 0.5f ),
+					Sound::SoundId::Teleport0 + random_generator_->Rand() % 3u );
+
+				break;
 			}
 
-			rocket.previous_position= new_pos;
-		}
-
-		// Calculate shifted hit pos.
-		m_Vec3 hit_pos_normal_shifted;
-		const float c_walls_effect_offset= 1.0f / 32.0f;
-		switch(hit_result.object_type)
-		{
-		case HitResult::ObjectType::None:
-			break;
-		case HitResult::ObjectType::StaticWall:
-			hit_pos_normal_shifted=
-				hit_result.pos + GetNormalForWall( map_data_->static_walls[ hit_result.object_index ] ) * c_walls_effect_offset;
-			break;
-		case HitResult::ObjectType::DynamicWall:
-			hit_pos_normal_shifted=
-				hit_result.pos + GetNormalForWall( dynamic_walls_[ hit_result.object_index ] ) * c_walls_effect_offset;
-			break;
-		case HitResult::ObjectType::Model:
-		{
-			const m_Vec2 dir= hit_result.pos.xy() - static_models_[ hit_result.object_index ].pos.xy();
-			hit_pos_normal_shifted=
-				hit_result.pos + m_Vec3( dir, 0.0f ) * ( c_walls_effect_offset / dir.Length() );
-			break;
-		}
-		case HitResult::ObjectType::Monster:
-			hit_pos_normal_shifted= hit_result.pos;
-			break;
-		case HitResult::ObjectType::Floor:
-			hit_pos_normal_shifted=
-				hit_result.pos + m_Vec3( 0.0f, 0.0f, ( hit_result.object_index == 0 ? 1.0f : -1.0f ) * c_walls_effect_offset );
-			break;
-		};
-
-		// Warn monsters.
-		if( hit_result.object_type != HitResult::ObjectType::None )
-			TryWarnMonsters( hit_pos_normal_shifted, current_time );
-
-		const bool process_explosion= !has_infinite_speed;
-		if( hit_result.object_type != HitResult::ObjectType::None && process_explosion )
-			DoExplosionDamage(
-				hit_result.pos, rocket_description.explosion_radius,
-				GetRocketDamage( rocket_description.power ),
-				rocket.owner_id, current_time );
-
-		// Gen hit effect.
-		if( hit_result.object_type == HitResult::ObjectType::Monster )
-		{
-			AddParticleEffect( hit_result.pos, ParticleEffect::Blood );
-			PlayMapEventSound( hit_result.pos, Sound::SoundId::FirstRocketHit + rocket.rocket_type_id );
-
-			// Hack for rockets and grenades. Make effect together with blood.
-			if( ( rocket_description.blow_effect == 2 || rocket_description.blow_effect == 4 )
-				&& !has_infinite_speed )
-				GenParticleEffectForRocketHit( hit_result.pos, rocket.rocket_type_id );
-		}
-		else if( hit_result.object_type != HitResult::ObjectType::None )
-		{
-			GenParticleEffectForRocketHit( hit_pos_normal_shifted, rocket.rocket_type_id );
-			PlayMapEventSound( hit_pos_normal_shifted, Sound::SoundId::FirstRocketHit + rocket.rocket_type_id );
-		}
-
-		// Try break breakable models.
-		if( hit_result.object_type == HitResult::ObjectType::Model )
-		{
-			StaticModel& model= static_models_[ hit_result.object_index ];
-
-			if( model.model_id >= map_data_->models_description.size() )
-				goto end_loop;
-
-			const MapData::ModelDescription& model_description= map_data_->models_description[ model.model_id ];
-
-			// Process shot even if model is breakable. TODO - check this.
-			ProcessElementLinks(
-				MapData::IndexElement::StaticModel,
-				hit_result.object_index,
-				[&]( const MapData::Link& link )
-				{
-					if( link.type == MapData::Link::Shoot )
-						ProcedureProcessShoot( link.proc_id, current_time );
-				} );
-
-			if( !process_explosion &&
-				model_description.blow_effect != 0 )
+			// Process wind for monster
+			// TODO - select more correct way to do this.
+			const int wind_x= static_cast<int>( monster.Position().x - 0.5f );
+			const int wind_y= static_cast<int>( monster.Position().y - 0.5f );
+			if( have_wind &&
+				wind_x >= 0 && wind_x < int(MapData::c_map_size - 1u) &&
+				wind_y >= 0 && wind_y < int(MapData::c_map_size - 1u) )
 			{
-				model.health-= int(rocket_description.power);
-				if( model.health <= 0 )
+				// Find interpolated value of wind in 4 cells, nearest to monster center.
+				const auto wind_fetch=
+				[&]( int x, int y )
 				{
-					DestroyModel( hit_result.object_index );
-
-					ProcessElementLinks(
-						MapData::IndexElement::StaticModel,
-						hit_result.object_index,
-						[&]( const MapData::Link& link )
-						{
-							if( link.type == MapData::Link::Destroy )
-								ProcedureProcessDestroy( link.proc_id, current_time );
-						} );
-				}
-			}
-		}
-		else if(
-			hit_result.object_type == HitResult::ObjectType::StaticWall ||
-			hit_result.object_type == HitResult::ObjectType::DynamicWall )
-		{
-			ProcessElementLinks(
-				hit_result.object_type == HitResult::ObjectType::StaticWall
-					? MapData::IndexElement::StaticWall
-					: MapData::IndexElement::DynamicWall,
-				hit_result.object_index,
-				[&]( const MapData::Link& link )
+					const m_Vec2* const wind= wind_zones_.Get( x, y );
+					return wind == nullptr ? m_Vec2( 0.0f, 0.0f ) : *wind;
+				};
+				const float dx= monster.Position().x - 0.5f - float(wind_x);
+				const float dy= monster.Position().y - 0.5f - float(wind_y);
+
+				const m_Vec2 wind_vec=
+					wind_fetch(wind_x  , wind_y  ) * (1.0f - dx) * (1.0f - dy) +
+					wind_fetch(wind_x  , wind_y+1) * (1.0f - dx) *         dy  +
+					wind_fetch(wind_x+1, wind_y  ) *         dx  * (1.0f - dy) +
+					wind_fetch(wind_x+1, wind_y+1) *         dx  *         dy;
+
+				if( wind_vec.SquareLength() > 0.0f )
 				{
-					if( link.type == MapData::Link::Shoot )
-						ProcedureProcessShoot( link.proc_id, current_time );
-				} );
-		}
-		else if( hit_result.object_type == HitResult::ObjectType::Floor )
-		{
-			// TODO - support rockets reflections
-		}
-		else if( hit_result.object_type == HitResult::ObjectType::Monster )
-		{
-			if( !process_explosion )
-			{
-				auto it= monsters_.find( hit_result.object_index );
-				PC_ASSERT( it != monsters_.end() );
+					const float time_delta_s= last_tick_delta_s;
+					const float c_wind_power_scale= 0.5f;
+					const m_Vec2 pos_delta= time_delta_s * c_wind_power_scale * wind_vec;
 
-				const MonsterBasePtr& monster= it->second;
-				PC_ASSERT( monster != nullptr );
-				monster->Hit(
-					GetRocketDamage(rocket_description.power),
-					rocket.normalized_direction.xy(), rocket.owner_id,
-					*this,
-					hit_result.object_index ,current_time );
+					monster.SetPosition( monster.Position() + m_Vec3( pos_delta, 0.0f ) );
+				}
 			}
-		}
 
-	end_loop:
-		// Try remove rocket
-		if( hit_result.object_type != HitResult::ObjectType::None || // kill hited
-			time_delta_s > 16.0f || // kill old rockets
-			has_infinite_speed ) // kill bullets
-		{
-			if( !has_infinite_speed )
+			// Process death for monster.
+			// TODO - make death zone intersection calculation correct, like with wind zones.
+			if( have_death_zones )
 			{
-				rockets_death_messages_.emplace_back();
-				rockets_death_messages_.back().rocket_id= rocket.rocket_id;
+				const DamageFiledCell* const cell=
+					death_zones_.Get(
+						static_cast<int>( monster.Position().x ),
+						static_cast<int>( monster.Position().y ) );
+				if( cell != nullptr && cell->damage > 0u )
+				{
+					// TODO - select correct monster height
+					if( !( monster.Position().z > float(cell->z_top) / 64u ||
+						   monster.Position().z + GameConstants::player_height < float(cell->z_bottom) / 64u ) )
+						monster.Hit(
+							int( cell->damage * death_ticks ), m_Vec2( 0.0f, 0.0f ), 0u,
+							*this,
+							monster_value.first, current_time );
+				}
 			}
 
-			if( r != rockets_.size() - 1u )
-				rockets_[r]= rockets_.back();
-			rockets_.pop_back();
+			monsters_index_.UpdateMonster( monster_value.first );
 		}
-		else
-			r++;
-	} // for rockets
+	}
 
-	// Process mines
-	for( unsigned int m= 0u; m < mines_.size(); )
+	// Collide monsters with map
 	{
-		Mine& mine= mines_[m];
-		const float time_delta_s= ( current_time - mine.planting_time ).ToSeconds();
-
-		bool need_kill= false;
-
-		if( time_delta_s > 30.0f ) // Kill too old mines
-			need_kill= true;
-		else if( time_delta_s >= GameConstants::mines_preparation_time_s )
+		const TickProfiler::ScopedTimer timer( profiler, TickProfiler::Phase::MonstersCollisions );
+		for( MonstersContainer::value_type& monster_value : monsters_ )
 		{
-			if( !mine.turned_on )
-			{
-				mine.turned_on= true;
-				PlayMapEventSound( mine.pos, Sound::SoundId::MineOn );
-			}
-
-			// Try activate mine.
-			bool activated= false;
-			for( const MonstersContainer::value_type& monster_value : monsters_ )
-			{
-				MonsterBase& monster= *monster_value.second;
+			MonsterBase& monster= *monster_value.second;
+			const bool is_player= monster.MonsterId() == 0u;
 
-				const float square_distance= ( monster.Position().xy() - mine.pos.xy() ).SquareLength();
-				if( square_distance > 8.0f * 8.0f ) // Too far, early reject.
-					continue;
+			if( is_player && static_cast<const Player&>(monster).IsNoclip() )
+				continue;
 
-				const float monster_radius=
-					monster.MonsterId() == 0u
-						? GameConstants::player_radius :
-						game_resources_->monsters_description[ monster.MonsterId() ].w_radius;
+			const EntityId mosnter_id= monster.MonsterId();
 
-				const float activation_distance= GameConstants::mines_activation_radius + monster_radius;
-				if( square_distance < activation_distance * activation_distance )
-					activated= true;
-			}
+			const float height=
+				is_player
+					? GameConstants::player_height
+					: std::max( GameConstants::player_height, game_resources_->monsters_models[ mosnter_id ].z_max );
+			const float radius= is_player ? GameConstants::player_radius : game_resources_->monsters_description[ mosnter_id ].w_radius;
 
-			if( activated )
-			{
-				need_kill= true;
+			MovementRestriction movement_restriction;
+			bool on_floor= false;
+			const m_Vec3 old_monster_pos= monster.Position();
+			const m_Vec3 new_monster_pos=
+				CollideWithMap(
+					old_monster_pos, height, radius, last_tick_delta,
+					on_floor, movement_restriction );
 
-				// TODO - maybe add some random damage variations, like with rockets and bullets?
-				DoExplosionDamage(
-					mine.pos, GameConstants::mines_explosion_radius,
-					GameConstants::mines_damage,
-					mine.owner_id, current_time );
+			const m_Vec3 position_delta= new_monster_pos - old_monster_pos;
 
-				particles_effects_messages_.emplace_back();
-				Messages::ParticleEffectBirth& message= particles_effects_messages_.back();
-				message.effect_id= static_cast<unsigned char>(ParticleEffect::Explosion);
-				PositionToMessagePosition( mine.pos, message.xyz );
+			if( position_delta.z != 0.0f ) // Vertical clamp
+				monster.ClampSpeed( m_Vec3( 0.0f, 0.0f, position_delta.z > 0.0f ? 1.0f : -1.0f ) );
 
-				PlayMapEventSound( mine.pos, 40u );
-			}
-		}
+			const float position_delta_length= position_delta.xy().Length();
+			if( position_delta_length != 0.0f ) // Horizontal clamp
+				monster.ClampSpeed( m_Vec3( position_delta.xy() / position_delta_length, 0.0f ) );
 
-		if( need_kill )
-		{
-			dynamic_items_death_messages_.emplace_back();
-			dynamic_items_death_messages_.back().item_id= mine.id;
+			monster.SetPosition( new_monster_pos );
+			monster.SetOnFloor( on_floor );
+			monster.SetMovementRestriction( movement_restriction );
 
-			if( m != mines_.size() - 1u )
-				mine= mines_.back();
-			mines_.pop_back();
+			monsters_index_.UpdateMonster( monster_value.first );
 		}
-		else
-			m++;
-	}
-
-	// Process monsters
-	for( MonstersContainer::value_type& monster_value : monsters_ )
-	{
-		monster_value.second->Tick( *this, monster_value.first, current_time, last_tick_delta );
-
-		// Process teleports for monster
-		MonsterBase& monster= *monster_value.second;
 
-		const float c_teleport_radius= 0.5f;
-
-		for( const MapData::Teleport& teleport : map_data_->teleports )
+		// Process mortal walls for monsters.
+		const float c_min_mortal_angle_cos= 0.2f;
+		for( const DynamicWall& wall : dynamic_walls_ )
 		{
-			const m_Vec2 tele_pos( float(teleport.from[0]) + 0.5f, float(teleport.from[1]) + 0.5f );
-
-			if( ( tele_pos - monster.Position().xy() ).SquareLength() >= c_teleport_radius * c_teleport_radius )
+			if( !wall.mortal )
+				continue;
+			if( wall.vert_pos[0] == wall.vert_pos[1] )
 				continue;
 
-			m_Vec2 dst;
-			for( unsigned int j= 0u; j < 2u; j++ )
-			{
-				if( teleport.to[j] >= MapData::c_map_size )
-					dst.ToArr()[j]= float( teleport.to[j] ) / 256.0f;
-				else
-					dst.ToArr()[j]= float( teleport.to[j] );
-			}
-			monster.Teleport(
-				m_Vec3(
-					dst,
-					GetFloorLevel( dst, GameConstants::player_radius ) ),
-				teleport.angle );
+			monsters_index_.ProcessMonstersNearSegment(
+				wall.vert_pos[0], wall.vert_pos[1], max_monster_radius_,
+				[&]( const EntityId monster_id, MonsterBase& monster )
+				{
+					const float monster_radius= game_resources_->monsters_description[ monster.MonsterId() ].w_radius;
 
-			// Emit random teleport sound at destination point.
-			PlayMapEventSound(
-				m_Vec3( dst, GameConstants::walls_height * 0.5f ),
-				Sound::SoundId::Teleport0 + random_generator_->Rand() % 3u );
+					m_Vec2 out_pos;
 
-			break;
-		}
+					if( !CollideCircleWithLineSegment(
+							wall.vert_pos[0], wall.vert_pos[1],
+							monster.Position().xy(), monster_radius,
+							out_pos ) )
+						return;
 
-		// Process wind for monster
-		// TODO - select more correct way to do this.
-		const int wind_x= static_cast<int>( monster.Position().x - 0.5f );
-		const int wind_y= static_cast<int>( monster.Position().y - 0.5f );
-		if( wind_x >= 0 && wind_x < int(MapData::c_map_size - 1u) &&
-			wind_y >= 0 && wind_y < int(MapData::c_map_size - 1u) )
-		{
-			// Find interpolated value of wind in 4 cells, nearest to monster center.
-			const auto wind_fetch=
-			[&]( int x, int y )
-			{
-				const char* const wind_cell= wind_field_[ x + y * int(MapData::c_map_size) ];
-				return m_Vec2( wind_cell[0], wind_cell[1] );
-			};
-			const float dx= monster.Position().x - 0.5f - float(wind_x);
-			const float dy= monster.Position().y - 0.5f - float(wind_y);
+					const m_Vec2 wall_normal= GetNormalForWall( wall ).xy();
 
-			const m_Vec2 wind_vec=
-				wind_fetch(wind_x  , wind_y  ) * (1.0f - dx) * (1.0f - dy) +
-				wind_fetch(wind_x  , wind_y+1) * (1.0f - dx) *         dy  +
-				wind_fetch(wind_x+1, wind_y  ) *         dx  * (1.0f - dy) +
-				wind_fetch(wind_x+1, wind_y+1) *         dx  *         dy;
+					m_Vec2 push_dir= out_pos - monster.Position().xy();
+					const float push_dir_square_length= push_dir.SquareLength();
+					if( push_dir_square_length <= 0.0f )
+						return;
+					push_dir/= std::sqrt( push_dir_square_length );
 
-			if( wind_vec.SquareLength() > 0.0f )
-			{
-				const float time_delta_s= last_tick_delta_s;
-				const float c_wind_power_scale= 0.5f;
-				const m_Vec2 pos_delta= time_delta_s * c_wind_power_scale * wind_vec;
+					const m_Vec2 wall_vec= wall.vert_pos[1] - wall.vert_pos[0];
 
-				monster.SetPosition( monster.Position() + m_Vec3( pos_delta, 0.0f ) );
-			}
-		}
+					const float relative_pos_wall_projected= ( (out_pos - wall.vert_pos[0] ) * wall_vec ) / wall_vec.SquareLength();
+					const m_Vec2 wall_speed_at_projection_point=
+						wall.vert_move_speed[1] *          relative_pos_wall_projected +
+						wall.vert_move_speed[0] * ( 1.0f - relative_pos_wall_projected );
 
-		// Process death for monster.
-		// TODO - make death zone intersection calculation correct, like with wind zones.
-		const int monster_x= static_cast<int>( monster.Position().x );
-		const int monster_y= static_cast<int>( monster.Position().y );
-		if( monster_x >= 0 && monster_x < int(MapData::c_map_size) &&
-			monster_y >= 0 && monster_y < int(MapData::c_map_size) )
-		{
-			const DamageFiledCell& cell= death_field_[ monster_x + monster_y * int(MapData::c_map_size) ];
-			if( cell.damage > 0u && death_ticks > 0u )
-			{
-				// TODO - select correct monster height
-				if( !( monster.Position().z > float(cell.z_top) / 64u ||
-					   monster.Position().z + GameConstants::player_height < float(cell.z_bottom) / 64u ) )
-					monster.Hit(
-						int( cell.damage * death_ticks ), m_Vec2( 0.0f, 0.0f ), 0u,
-						*this,
-						monster_value.first, current_time );
-			}
-		}
-	}
+					const float speed_square_length= wall_speed_at_projection_point.SquareLength();
+					if( speed_square_length <= 0.0f )
+						return;
 
-	// Collide monsters with map
-	for( MonstersContainer::value_type& monster_value : monsters_ )
-	{
-		MonsterBase& monster= *monster_value.second;
-		const bool is_player= monster.MonsterId() == 0u;
+					const m_Vec2 speed_dir= wall_speed_at_projection_point / std::sqrt( speed_square_length );
+					if( speed_dir * wall_normal < c_min_mortal_angle_cos ) // Wall can hit only if speed have same direction with normal.
+						return;
 
-		if( is_player && static_cast<const Player&>(monster).IsNoclip() )
-			continue;
+					if( monster.GetMovementRestriction().MovementIsBlocked( push_dir ) )
+						monster.Hit(
+							static_cast<int>(GameConstants::mortal_walls_damage_per_second * last_tick_delta_s),
+							m_Vec2( 0.0f, 0.0f ), 0,
+							*this,
+							monster_id, current_time );
+				} );
+		}
+		// Process mortal models for monsters.
+		for( const StaticModel& model : static_models_ )
+		{
+			if( !model.mortal || model.model_id >= map_data_->models_description.size() )
+				continue;
 
-		const EntityId mosnter_id= monster.MonsterId();
+			const MapData::ModelDescription& model_description= map_data_->models_description[ model.model_id ];
+			const float model_radius= model_description.radius;
+			if( model_radius <= 0.0f )
+				continue;
 
-		const float height=
-			is_player
-				? GameConstants::player_height
-				: std::max( GameConstants::player_height, game_resources_->monsters_models[ mosnter_id ].z_max );
-		const float radius= is_player ? GameConstants::player_radius : game_resources_->monsters_description[ mosnter_id ].w_radius;
+			const float speed_square_length= model.move_speed.SquareLength();
+			if( speed_square_length <= 0.0f )
+				continue;
+			const m_Vec2 speed_dir= model.move_speed / std::sqrt( speed_square_length );
 
-		MovementRestriction movement_restriction;
-		bool on_floor= false;
-		const m_Vec3 old_monster_pos= monster.Position();
-		const m_Vec3 new_monster_pos=
-			CollideWithMap(
-				old_monster_pos, height, radius, last_tick_delta,
-				on_floor, movement_restriction );
+			// Use extended radius, because model may be square.
+			monsters_index_.ProcessMonstersInRadius(
+				model.pos.xy(), model_radius * 1.5f + max_monster_radius_,
+				[&]( const EntityId monster_id, MonsterBase& monster )
+				{
+					const float monster_radius= game_resources_->monsters_description[ monster.MonsterId() ].w_radius;
 
-		const m_Vec3 position_delta= new_monster_pos - old_monster_pos;
+					bool collided= false;
+					m_Vec2 new_pos;
+					if( CollideWithSquare( model_description ) )
+					{
+						collided=
+							CollideCircleWithSquare(
+								model.pos.xy(), model.angle, model_radius,
+								monster.Position().xy(), monster_radius,
+								new_pos );
+					}
+					else
+					{
+						const float collide_distance= monster_radius + model_radius;
+						const m_Vec2 vec_to_monster= monster.Position().xy() - model.pos.xy();
+						if( vec_to_monster.SquareLength() < collide_distance * collide_distance )
+						{
+							collided= true;
+							new_pos= vec_to_monster / vec_to_monster.Length() * collide_distance;
+						}
+					}
+					if( collided )
+					{
+						m_Vec2 normal= new_pos - monster.Position().xy();
+						normal.Normalize();
+
+						if( normal * speed_dir < c_min_mortal_angle_cos )
+							return;
+
+						if( monster.GetMovementRestriction().MovementIsBlocked( normal ) )
+							monster.Hit(
+								static_cast<int>(GameConstants::mortal_walls_damage_per_second * last_tick_delta_s),
+								m_Vec2( 0.0f, 0.0f ), 0,
+								*this,
+								monster_id, current_time );
+					}
+				} );
+		}
 
-		if( position_delta.z != 0.0f ) // Vertical clamp
-			monster.ClampSpeed( m_Vec3( 0.0f, 0.0f, position_delta.z > 0.0f ? 1.0f : -1.0f ) );
+		// Collide monsters together
+		for( MonstersContainer::value_type& first_monster_value : monsters_ )
+		{
+			MonsterBase& first_monster= *first_monster_value.second;
+			if( first_monster.Health() <= 0 )
+				continue;
 
-		const float position_delta_length= position_delta.xy().Length();
-		if( position_delta_length != 0.0f ) // Horizontal clamp
-			monster.ClampSpeed( m_Vec3( position_delta.xy() / position_delta_length, 0.0f ) );
+			const float first_monster_radius= game_resources_->monsters_description[ first_monster.MonsterId() ].w_radius;
+			const m_Vec2 first_monster_z_minmax=
+				first_monster.GetZMinMax() + m_Vec2( first_monster.Position().z, first_monster.Position().z );
 
-		monster.SetPosition( new_monster_pos );
-		monster.SetOnFloor( on_floor );
-		monster.SetMovementRestriction( movement_restriction );
-	}
+			// Collect near monsters first, because monsters index can not be modified while iterating over it.
+			near_monsters_.clear();
+			monsters_index_.ProcessMonstersInRadius(
+				first_monster.Position().xy(), first_monster_radius + max_monster_radius_,
+				[&]( const EntityId monster_id, MonsterBase& monster )
+				{
+					if( &monster != &first_monster && monster.Health() > 0 )
+						near_monsters_.emplace_back( monster_id, &monster );
+				} );
 
-	// Process mortal walls for monsters.
-	const float c_min_mortal_angle_cos= 0.2f;
-	for( const DynamicWall& wall : dynamic_walls_ )
-	{
-		if( !wall.mortal )
-			continue;
-		if( wall.vert_pos[0] == wall.vert_pos[1] )
-			continue;
+			for( const std::pair< EntityId, MonsterBase* >& near_monster : near_monsters_ )
+			{
+				MonsterBase& second_monster= *near_monster.second;
 
-		for( MonstersContainer::value_type& monster_value : monsters_ )
-		{
-			MonsterBase& monster= *monster_value.second;
-			const float monster_radius= game_resources_->monsters_description[ monster.MonsterId() ].w_radius;
+				const float square_distance= ( first_monster.Position().xy() - second_monster.Position().xy() ).SquareLength();
 
-			m_Vec2 out_pos;
+				const float second_monster_radius= game_resources_->monsters_description[ second_monster.MonsterId() ].w_radius;
+				const float min_distance= second_monster_radius + first_monster_radius;
+				if( square_distance > min_distance * min_distance )
+					continue;
 
-			if( !CollideCircleWithLineSegment(
-					wall.vert_pos[0], wall.vert_pos[1],
-					monster.Position().xy(), monster_radius,
-					out_pos ) )
-				continue;
+				const m_Vec2 second_monster_z_minmax=
+					second_monster.GetZMinMax() + m_Vec2( second_monster.Position().z, second_monster.Position().z );
+				if(  first_monster_z_minmax.y < second_monster_z_minmax.x ||
+					second_monster_z_minmax.y <  first_monster_z_minmax.x ) // Z check
+					continue;
 
-			const m_Vec2 wall_normal= GetNormalForWall( wall ).xy();
+				// Collide here
+				m_Vec2 collide_vec= second_monster.Position().xy() - first_monster.Position().xy();
+				collide_vec.Normalize();
 
-			m_Vec2 push_dir= out_pos - monster.Position().xy();
-			const float push_dir_square_length= push_dir.SquareLength();
-			if( push_dir_square_length <= 0.0f )
-				continue;
-			push_dir/= std::sqrt( push_dir_square_length );
+				const float move_delta= min_distance - std::sqrt( square_distance );
 
-			const m_Vec2 wall_vec= wall.vert_pos[1] - wall.vert_pos[0];
+				float first_monster_k;
+				if( first_monster.MonsterId() == 0u && second_monster.MonsterId() != 0u )
+					first_monster_k= 1.0f;
+				else if( first_monster.MonsterId() != 0u && second_monster.MonsterId() == 0u )
+					first_monster_k= 0.0f;
+				else
+					first_monster_k= 0.5f;
 
-			const float relative_pos_wall_projected= ( (out_pos - wall.vert_pos[0] ) * wall_vec ) / wall_vec.SquareLength();
-			const m_Vec2 wall_speed_at_projection_point=
-				wall.vert_move_speed[1] *          relative_pos_wall_projected +
-				wall.vert_move_speed[0] * ( 1.0f - relative_pos_wall_projected );
+				const bool  first_blocked=  first_monster.GetMovementRestriction().MovementIsBlocked( -collide_vec );
+				const bool second_blocked= second_monster.GetMovementRestriction().MovementIsBlocked(  collide_vec );
+				if(  first_blocked && !second_blocked )
+					first_monster_k= 0.0f;
+				if( !first_blocked &&  second_blocked )
+					first_monster_k= 1.0f;
 
-			const float speed_square_length= wall_speed_at_projection_point.SquareLength();
-			if( speed_square_length <= 0.0f )
-				continue;
+				const m_Vec2  first_monster_pos=  first_monster.Position().xy() - collide_vec * move_delta * first_monster_k;
+				const m_Vec2 second_monster_pos= second_monster.Position().xy() + collide_vec * move_delta * ( 1.0f - first_monster_k );
 
-			const m_Vec2 speed_dir= wall_speed_at_projection_point / std::sqrt( speed_square_length );
-			if( speed_dir * wall_normal < c_min_mortal_angle_cos ) // Wall can hit only if speed have same direction with normal.
-				continue;
+				 first_monster.SetPosition( m_Vec3( first_monster_pos ,  first_monster.Position().z ) );
+				second_monster.SetPosition( m_Vec3( second_monster_pos, second_monster.Position().z ) );
+			}
 
-			if( monster.GetMovementRestriction().MovementIsBlocked( push_dir ) )
-				monster.Hit(
-					static_cast<int>(GameConstants::mortal_walls_damage_per_second * last_tick_delta_s),
-					m_Vec2( 0.0f, 0.0f ), 0,
-					*this,
-					monster_value.first, current_time );
+			monsters_index_.UpdateMonster( first_monster_value.first );
+			for( const std::pair< EntityId, MonsterBase* >& near_monster : near_monsters_ )
+				monsters_index_.UpdateMonster( near_monster.first );
 		}
 	}
-	// Process mortal models for monsters.
-	for( const StaticModel& model : static_models_ )
-	{
-		if( !model.mortal || model.model_id >= map_data_->models_description.size() )
-			continue;
 
-		const MapData::ModelDescription& model_description= map_data_->models_description[ model.model_id ];
-		const float model_radius= model_description.radius;
-		if( model_radius <= 0.0f )
-			continue;
+	// Process backpacks
+	for( auto& backpack_value : backpacks_ )
+	{
+		Backpack& backpack= *backpack_value.second;
 
-		const float speed_square_length= model.move_speed.SquareLength();
-		if( speed_square_length <= 0.0f )
-			continue;
-		const m_Vec2 speed_dir= model.move_speed / std::sqrt( speed_square_length );
+		backpack.vertical_speed+= GameConstants::vertical_acceleration * last_tick_delta_s;
+		backpack.pos.z+= backpack.vertical_speed * last_tick_delta_s;
+		backpack.pos.z= std::max( backpack.pos.z, backpack.min_z );
+	}
 
-		for( MonstersContainer::value_type& monster_value : monsters_ )
+	// Process rotating lights, which end time come.
+	for( const unsigned int model_number : expired_rotating_lights_ )
+	{
+		StaticModel& model= static_models_[ model_number ];
+		if( model.linked_rotating_light != nullptr &&
+			current_time >= model.linked_rotating_light->end_time )
 		{
-			MonsterBase& monster= *monster_value.second;
-			const float monster_radius= game_resources_->monsters_description[ monster.MonsterId() ].w_radius;
+			// Kill expired rotating light source.
+			rotating_light_sources_death_messages_.emplace_back();
+			Messages::RotatingLightSourceDeath& message= rotating_light_sources_death_messages_.back();
+			message.light_source_id= model_number;
 
-			bool collided= false;
-			m_Vec2 new_pos;
-			if( CollideWithSquare( model_description ) )
-			{
-				collided=
-					CollideCircleWithSquare(
-						model.pos.xy(), model.angle, model_radius,
-						monster.Position().xy(), monster_radius,
-						new_pos );
-			}
-			else
-			{
-				const float collide_distance= monster_radius + model_radius;
-				const m_Vec2 vec_to_monster= monster.Position().xy() - model.pos.xy();
-				if( vec_to_monster.SquareLength() < collide_distance * collide_distance )
-				{
-					collided= true;
-					new_pos= vec_to_monster / vec_to_monster.Length() * collide_distance;
-				}
-			}
-			if( collided )
-			{
-				m_Vec2 normal= new_pos - monster.Position().xy();
-				normal.Normalize();
-
-				if( normal * speed_dir < c_min_mortal_angle_cos )
-					continue;
-
-				if( monster.GetMovementRestriction().MovementIsBlocked( normal ) )
-					monster.Hit(
-						static_cast<int>(GameConstants::mortal_walls_damage_per_second * last_tick_delta_s),
-						m_Vec2( 0.0f, 0.0f ), 0,
-						*this,
-						monster_value.first, current_time );
-			}
-		}
-	}
-
-	// Collide monsters together
-	for( MonstersContainer::value_type& first_monster_value : monsters_ )
-	{
-		MonsterBase& first_monster= *first_monster_value.second;
-		if( first_monster.Health() <= 0 )
-			continue;
-
-		const float first_monster_radius= game_resources_->monsters_description[ first_monster.MonsterId() ].w_radius;
-		const m_Vec2 first_monster_z_minmax=
-			first_monster.GetZMinMax() + m_Vec2( first_monster.Position().z, first_monster.Position().z );
-
-		for( MonstersContainer::value_type& second_monster_value : monsters_ )
-		{
-			MonsterBase& second_monster= *second_monster_value.second;
-			if( &second_monster == &first_monster )
-				continue;
-
-			if( second_monster.Health() <= 0 )
-				continue;
-
-			const float square_distance= ( first_monster.Position().xy() - second_monster.Position().xy() ).SquareLength();
-
-			const float c_max_collide_distance= 8.0f;
-			if( square_distance > c_max_collide_distance * c_max_collide_distance )
-				continue;
-
-			const float second_monster_radius= game_resources_->monsters_description[ second_monster.MonsterId() ].w_radius;
-			const float min_distance= second_monster_radius + first_monster_radius;
-			if( square_distance > min_distance * min_distance )
-				continue;
-
-			const m_Vec2 second_monster_z_minmax=
-				second_monster.GetZMinMax() + m_Vec2( second_monster.Position().z, second_monster.Position().z );
-			if(  first_monster_z_minmax.y < second_monster_z_minmax.x ||
-				second_monster_z_minmax.y <  first_monster_z_minmax.x ) // Z check
-				continue;
-
-			// Collide here
-			m_Vec2 collide_vec= second_monster.Position().xy() - first_monster.Position().xy();
-			collide_vec.Normalize();
-
-			const float move_delta= min_distance - std::sqrt( square_distance );
-
-			float first_monster_k;
-			if( first_monster.MonsterId() == 0u && second_monster.MonsterId() != 0u )
-				first_monster_k= 1.0f;
-			else if( first_monster.MonsterId() != 0u && second_monster.MonsterId() == 0u )
-				first_monster_k= 0.0f;
-			else
-				first_monster_k= 0.5f;
-
-			const bool  first_blocked=  first_monster.GetMovementRestriction().MovementIsBlocked( -collide_vec );
-			const bool second_blocked= second_monster.GetMovementRestriction().MovementIsBlocked(  collide_vec );
-			if(  first_blocked && !second_blocked )
-				first_monster_k= 0.0f;
-			if( !first_blocked &&  second_blocked )
-				first_monster_k= 1.0f;
-
-			const m_Vec2  first_monster_pos=  first_monster.Position().xy() - collide_vec * move_delta * first_monster_k;
-			const m_Vec2 second_monster_pos= second_monster.Position().xy() + collide_vec * move_delta * ( 1.0f - first_monster_k );
-
-			 first_monster.SetPosition( m_Vec3( first_monster_pos ,  first_monster.Position().z ) );
-			second_monster.SetPosition( m_Vec3( second_monster_pos, second_monster.Position().z ) );
-		}
-	}
-
-	// Process backpacks
-	for( auto& backpack_value : backpacks_ )
-	{
-		Backpack& backpack= *backpack_value.second;
-
-		backpack.vertical_speed+= GameConstants::vertical_acceleration * last_tick_delta_s;
-		backpack.pos.z+= backpack.vertical_speed * last_tick_delta_s;
-		backpack.pos.z= std::max( backpack.pos.z, backpack.min_z );
-	}
-
-	// Process rotating lights.
-	for( StaticModel& model : static_models_ )
-	{
-		if( model.linked_rotating_light != nullptr )
-		{
-			if( current_time >= model.linked_rotating_light->end_time )
-			{
-				// Kill expired rotating light source.
-				rotating_light_sources_death_messages_.emplace_back();
-				Messages::RotatingLightSourceDeath& message= rotating_light_sources_death_messages_.back();
-				message.light_source_id= &model - static_models_.data();
-
-				model.linked_rotating_light= nullptr;
-			}
+			model.linked_rotating_light= nullptr;
 		}
 	}
+	expired_rotating_lights_.clear();
 
 	// At end of this procedure, report about map change, if this needed.
 	// Do it here, because map can be desctructed at callback call.
@@ -1891,7 +1756,7 @@ void Map::SendMessagesForNewlyConnectedPlayer( MessagesSender& messages_sender )
 		messages_sender.SendUnreliableMessage( message );
 	}
 
-	for( const std::unordered_map<EntityId, BackpackPtr>::value_type& backpack_value : backpacks_ )
+	for( const BackpacksContainer::value_type& backpack_value : backpacks_ )
 	{
 		Messages::DynamicItemBirth message;
 		PrepareBackpackBirthMessage( *backpack_value.second, backpack_value.first, message );
@@ -1920,8 +1785,10 @@ void Map::SendMessagesForNewlyConnectedPlayer( MessagesSender& messages_sender )
 	}
 }
 
-void Map::SendUpdateMessages( MessagesSender& messages_sender ) const
+void Map::UpdateSnapshot( const unsigned int snapshot_sequence )
 {
+	delta_snapshots_.BeginSnapshot( snapshot_sequence );
+
 	Messages::WallPosition wall_message;
 
 	for( const DynamicWall& wall : dynamic_walls_ )
@@ -1933,7 +1800,9 @@ void Map::SendUpdateMessages( MessagesSender& messages_sender ) const
 		wall_message.z= CoordToMessageCoord( wall.z );
 		wall_message.texture_id= wall.texture_id;
 
-		messages_sender.SendUnreliableMessage( wall_message );
+		delta_snapshots_.SetWallState(
+			wall_message,
+			m_Vec3( ( wall.vert_pos[0] + wall.vert_pos[1] ) * 0.5f, GameConstants::walls_height * 0.5f ) );
 	}
 
 	Messages::StaticModelState model_message;
@@ -1951,7 +1820,7 @@ void Map::SendUpdateMessages( MessagesSender& messages_sender ) const
 		PositionToMessagePosition( model.pos, model_message.xyz );
 		model_message.angle= AngleToMessageAngle( model.angle );
 
-		messages_sender.SendUnreliableMessage( model_message );
+		delta_snapshots_.SetStaticModelState( model_message, model.pos );
 	}
 
 	for( const Item& item : items_ )
@@ -1961,27 +1830,65 @@ void Map::SendUpdateMessages( MessagesSender& messages_sender ) const
 		message.z= CoordToMessageCoord( item.pos.z );
 		message.picked= item.picked_up || !item.enabled; // TODO - transfer enabled flag separately.
 
-		messages_sender.SendUnreliableMessage( message );
+		delta_snapshots_.SetItemState( message, item.pos );
 	}
 
-	Messages::SpriteEffectBirth sprite_message;
+	for( const MonstersContainer::value_type& monster_value : monsters_ )
+	{
+		Messages::MonsterState monster_message;
 
-	for( const SpriteEffect& effect : sprite_effects_ )
+		monster_value.second->BuildStateMessage( monster_message );
+		monster_message.monster_id= monster_value.first;
+
+		delta_snapshots_.SetMonsterState( monster_message, monster_value.second->Position() );
+	}
+
+	for( const Rocket& rocket : rockets_ )
 	{
-		sprite_message.effect_id= effect.effect_id;
-		PositionToMessagePosition( effect.pos, sprite_message.xyz );
+		Messages::RocketState rocket_message;
+		PrepareRocketStateMessage( rocket, rocket_message );
 
-		messages_sender.SendUnreliableMessage( sprite_message );
+		delta_snapshots_.SetRocketState( rocket_message, rocket.previous_position );
 	}
 
-	for( const MonstersContainer::value_type& monster_value : monsters_ )
+	delta_snapshots_.EndSnapshot();
+}
+
+void Map::SendUpdateMessages(
+	MessagesSender& messages_sender,
+	const EntityId player_monster_id,
+	DeltaSnapshots::ClientState& snapshots_state ) const
+{
+	// Send to client only entities, relevant for its player. If player is not spawned - send everything.
+	const PlayersContainer::const_iterator player_it= players_.find( player_monster_id );
+	const PlayerInterest interest=
+		player_it == players_.end()
+			? PlayerInterest()
+			: PlayerInterest( *visibility_matrix_, player_it->second->Position() );
+
+	const auto get_monster_position=
+	[&]( const EntityId monster_id, m_Vec3& out_pos ) -> bool
+	{
+		const auto it= monsters_.find( monster_id );
+		if( it == monsters_.end() )
+			return false;
+		out_pos= it->second->Position();
+		return true;
+	};
+
+	m_Vec3 pos;
+
+	Messages::SpriteEffectBirth sprite_message;
+
+	for( const SpriteEffect& effect : sprite_effects_ )
 	{
-		Messages::MonsterState monster_message;
+		if( !interest.MayBeVisible( effect.pos ) )
+			continue;
 
-		monster_value.second->BuildStateMessage( monster_message );
-		monster_message.monster_id= monster_value.first;
+		sprite_message.effect_id= effect.effect_id;
+		PositionToMessagePosition( effect.pos, sprite_message.xyz );
 
-		messages_sender.SendUnreliableMessage( monster_message );
+		messages_sender.SendUnreliableMessage( sprite_message );
 	}
 
 	for( const Messages::MonsterBirth& message : monsters_birth_messages_ )
@@ -2010,26 +1917,40 @@ void Map::SendUpdateMessages( MessagesSender& messages_sender ) const
 		messages_sender.SendReliableMessage( message );
 
 	for( const Messages::ParticleEffectBirth& message : particles_effects_messages_ )
-		messages_sender.SendUnreliableMessage( message );
+	{
+		MessagePositionToPosition( message.xyz, pos );
+		if( interest.MayBeVisible( pos ) )
+			messages_sender.SendUnreliableMessage( message );
+	}
 	for( const Messages::FullscreenBlendEffect& message : fullscreen_blend_messages_ )
 		messages_sender.SendUnreliableMessage( message );
 	for( const Messages::MonsterPartBirth& message : monsters_parts_birth_messages_ )
-		messages_sender.SendUnreliableMessage( message );
+	{
+		MessagePositionToPosition( message.xyz, pos );
+		if( interest.MayBeVisible( pos ) )
+			messages_sender.SendUnreliableMessage( message );
+	}
 
 	for( const Messages::MapEventSound& message : map_events_sounds_messages_ )
-		messages_sender.SendUnreliableMessage( message );
+	{
+		MessagePositionToPosition( message.xyz, pos );
+		if( interest.IsAudible( pos ) )
+			messages_sender.SendUnreliableMessage( message );
+	}
 	for( const Messages::MonsterLinkedSound& message : monster_linked_sounds_messages_ )
-		messages_sender.SendUnreliableMessage( message );
+	{
+		if( !get_monster_position( message.monster_id, pos ) || interest.IsAudible( pos ) )
+			messages_sender.SendUnreliableMessage( message );
+	}
 	for( const Messages::MonsterSound& message : monsters_sounds_messages_ )
-		messages_sender.SendUnreliableMessage( message );
-
-	for( const Rocket& rocket : rockets_ )
 	{
-		Messages::RocketState rocket_message;
-		PrepareRocketStateMessage( rocket, rocket_message );
-		messages_sender.SendUnreliableMessage( rocket_message );
+		if( !get_monster_position( message.monster_id, pos ) || interest.IsAudible( pos ) )
+			messages_sender.SendUnreliableMessage( message );
 	}
 
+	// Send snapshot after births of rockets, because client ignores states of unknown rockets.
+	delta_snapshots_.SendSnapshot( messages_sender, interest, snapshots_state );
+
 	for( const auto& backpack_value : backpacks_ )
 	{
 		Messages::DynamicItemUpdate message;
@@ -2068,6 +1989,8 @@ void Map::ActivateProcedure( const unsigned int procedure_number, const Time cur
 	procedure_state.movement_stage= 0.0f;
 	procedure_state.movement_state= ProcedureState::MovementState::StartWait;
 	procedure_state.last_state_change_time= current_time;
+
+	AddActiveProcedure( procedure_number );
 }
 
 void Map::TryActivateProcedure(
@@ -2100,6 +2023,7 @@ void Map::TryActivateProcedure(
 
 		procedure_state.last_state_change_time= current_time - Time::FromSeconds( dt_s );
 		procedure_state.movement_state= ProcedureState::MovementState::Movement;
+		AddActiveProcedure( procedure_number );
 		return;
 	}
 
@@ -2339,6 +2263,7 @@ void Map::DoProcedureImmediateCommands( const MapData::Procedure& procedure, con
 						light->brightness= command.args[4];
 
 						model.linked_rotating_light.reset( light );
+						timer_wheel_.Schedule( light->end_time, TimerEvent{ TimerEvent::Type::RotatingLightEnd, index_element.index } );
 
 						rotating_light_sources_birth_messages_.emplace_back();
 						Messages::RotatingLightSourceBirth& message= rotating_light_sources_birth_messages_.back();
@@ -2511,185 +2436,657 @@ void Map::ReturnProcedure( const unsigned int procedure_number, const Time curre
 	case ProcedureState::MovementState::ReverseMovement:
 		break;
 
-	case ProcedureState::MovementState::StartWait:
-		procedure_state.movement_state= ProcedureState::MovementState::None;
-		break;
+	case ProcedureState::MovementState::StartWait:
+		procedure_state.movement_state= ProcedureState::MovementState::None;
+		break;
+
+	case ProcedureState::MovementState::Movement:
+	{
+		procedure_state.movement_state= ProcedureState::MovementState::ReverseMovement;
+		float dt_s;
+		if( procedure.speed > 0.0f )
+			dt_s=
+				std::max(
+					1.0f / ( procedure.speed * GameConstants::procedures_speed_scale ) -
+					( current_time - procedure_state.last_state_change_time ).ToSeconds(),
+					0.0f );
+		else
+			dt_s= 0.0f;
+		procedure_state.last_state_change_time= current_time - Time::FromSeconds(dt_s);
+	}
+		break;
+
+	case ProcedureState::MovementState::BackWait:
+		procedure_state.movement_state= ProcedureState::MovementState::ReverseMovement;
+		procedure_state.last_state_change_time= current_time;
+		AddActiveProcedure( procedure_number );
+		break;
+	};
+}
+
+void Map::AddActiveProcedure( const unsigned int procedure_number )
+{
+	ProcedureState& procedure_state= procedures_[ procedure_number ];
+	if( procedure_state.active )
+		return;
+
+	procedure_state.active= true;
+	active_procedures_.insert(
+		std::lower_bound( active_procedures_.begin(), active_procedures_.end(), procedure_number ),
+		procedure_number );
+}
+
+bool Map::TryPutProcedureToSleep( const unsigned int procedure_number, const Time current_time )
+{
+	const MapData::Procedure& procedure= map_data_->procedures[ procedure_number ];
+	ProcedureState& procedure_state= procedures_[ procedure_number ];
+
+	// Time since last state change, after which procedure needs update. Negative value - wait forever.
+	float wait_time_s= -1.0f;
+	switch( procedure_state.movement_state )
+	{
+	case ProcedureState::MovementState::None:
+		break;
+
+	case ProcedureState::MovementState::StartWait:
+		wait_time_s= procedure.start_delay_s;
+		break;
+
+	case ProcedureState::MovementState::BackWait:
+		if( procedure.back_wait_s > 0.0f )
+			wait_time_s= procedure.back_wait_s;
+		break;
+
+	case ProcedureState::MovementState::Movement:
+	case ProcedureState::MovementState::ReverseMovement:
+		return false; // Moving procedures need update each tick.
+	};
+
+	// Map end check.
+	if( procedure_state.movement_state != ProcedureState::MovementState::None &&
+		procedure.end_delay_s > 0.0f )
+		wait_time_s= wait_time_s < 0.0f ? procedure.end_delay_s : std::min( wait_time_s, procedure.end_delay_s );
+
+	if( wait_time_s >= 0.0f )
+	{
+		// Wake up a bit earlier, because of rounding. Keep procedure active, if wake up time is near.
+		const Time wake_up_time=
+			procedure_state.last_state_change_time + Time::FromSeconds( double(wait_time_s) ) - Time::FromInternalRepresentation(1);
+		if( wake_up_time <= current_time )
+			return false;
+
+		timer_wheel_.Schedule( wake_up_time, TimerEvent{ TimerEvent::Type::ProcedureWakeUp, procedure_number } );
+	}
+
+	procedure_state.active= false;
+	return true;
+}
+
+void Map::ProcessTimerEvents( const Time current_time )
+{
+	timer_wheel_.Advance(
+		current_time,
+		[&]( const TimerEvent& event )
+		{
+			switch( event.type )
+			{
+			case TimerEvent::Type::ProcedureWakeUp:
+				AddActiveProcedure( event.index );
+				break;
+
+			case TimerEvent::Type::MineTurnOn:
+				for( Mine& mine : mines_ )
+				{
+					if( mine.id != event.index || mine.turned_on )
+						continue;
+
+					if( ( current_time - mine.planting_time ).ToSeconds() >= GameConstants::mines_preparation_time_s )
+					{
+						mine.turned_on= true;
+						PlayMapEventSound( mine.pos, Sound::SoundId::MineOn );
+					}
+					else
+						timer_wheel_.Schedule( GetTimerRetryTime( current_time ), event );
+					break;
+				}
+				break;
+
+			case TimerEvent::Type::ItemRespawn:
+			{
+				Item& item= items_[ event.index ];
+				if( !item.picked_up )
+					break;
+
+				if( ( current_time - item.pick_up_time ).ToSeconds() >= g_items_respawn_time_s )
+				{
+					// Respawn item.
+					// TODO - add light flash effect.
+					item.picked_up= false;
+				}
+				else
+					timer_wheel_.Schedule( GetTimerRetryTime( current_time ), event );
+			}
+				break;
+
+			case TimerEvent::Type::RotatingLightEnd:
+				// Process it at end of tick.
+				expired_rotating_lights_.push_back( event.index );
+				break;
+			};
+		} );
+}
+
+void Map::ProcessWind( const MapData::Procedure::ActionCommand& command, bool activate )
+{
+	PC_ASSERT( command.id == MapData::Procedure::ActionCommandId::Wind );
+
+	const unsigned int x0= static_cast<unsigned int>( command.args[0] );
+	const unsigned int y0= static_cast<unsigned int>( command.args[1] );
+	const unsigned int x1= static_cast<unsigned int>( command.args[2] );
+	const unsigned int y1= static_cast<unsigned int>( command.args[3] );
+	const char dir_x= static_cast<char>( static_cast<int>( command.args[4] ) );
+	const char dir_y= static_cast<char>( static_cast<int>( command.args[5] ) );
+
+	if( activate )
+		wind_zones_.Activate( x0, y0, x1, y1, m_Vec2( float(dir_x), float(dir_y) ) );
+	else
+		wind_zones_.Deactivate( x0, y0, x1, y1 );
+}
+
+void Map::ProcessDeathZone( const MapData::Procedure::ActionCommand& command, const bool activate )
+{
+	PC_ASSERT( command.id == MapData::Procedure::ActionCommandId::Death );
+
+	const unsigned int x0= static_cast<unsigned int>( command.args[0] );
+	const unsigned int y0= static_cast<unsigned int>( command.args[1] );
+	const unsigned int x1= static_cast<unsigned int>( command.args[2] );
+	const unsigned int y1= static_cast<unsigned int>( command.args[3] );
+	const int z_0= static_cast<int>( command.args[4] );
+	const int z_1= static_cast<int>( command.args[5] );
+	const unsigned char damage= static_cast<unsigned char>( command.args[6] );
+
+	if( activate )
+	{
+		DamageFiledCell cell;
+		cell.damage= damage;
+		cell.z_bottom= std::max( std::min( z_0, 255 ), 0 );
+		cell.z_top   = std::max( std::min( z_1, 255 ), 0 );
+		death_zones_.Activate( x0, y0, x1, y1, cell );
+	}
+	else
+		death_zones_.Deactivate( x0, y0, x1, y1 );
+}
+
+void Map::DestroyModel( const unsigned int model_index )
+{
+	PC_ASSERT( model_index < static_models_.size() );
+	StaticModel& model= static_models_[ model_index ];
+
+	EmitModelDestructionEffects( model_index );
+
+	model.model_id++; // now, this model has other model type
+
+	// Reset animation. Animation must be consistent with model.
+	model.animation_start_frame= 0u;
+	model.current_animation_frame= 0u;
+	model.animation_state= StaticModel::AnimationState::Animation;
+
+	if( model.model_id < map_data_->models_description.size() )
+		model.health= map_data_->models_description[ model.model_id ].break_limit;
+	else
+		model.health= 0;
+
+	// Model radius may change.
+	UpdateModelInCollisionIndex( model_index );
+	geometry_revision_++;
+}
+
+void Map::UpdateModelInCollisionIndex( const unsigned int model_index )
+{
+	const StaticModel& model= static_models_[ model_index ];
+	const float radius=
+		model.model_id < map_data_->models_description.size()
+			? map_data_->models_description[ model.model_id ].radius
+			: 0.0f;
+
+	collision_index_.UpdateDynamicModel( model_index, model.pos.xy(), radius );
+}
+
+bool Map::DoExplosionDamage(
+	const m_Vec3& explosion_center,
+	const float explosion_radius,
+	const int base_damage,
+	const EntityId explosion_owner_monster_id,
+	const Time current_time )
+{
+	bool damage_done= false;
+
+	const auto distance_to_damage=
+	[&] ( const float distance ) -> int
+	{
+		return std::round( float(base_damage) * ( 1.0f - distance / explosion_radius ) );
+	};
+
+	monsters_index_.ProcessMonstersInRadius(
+		explosion_center.xy(), explosion_radius + max_monster_radius_,
+		[&]( const EntityId monster_id, MonsterBase& monster )
+		{
+			const float monster_radius=
+				monster.MonsterId() == 0u
+				? GameConstants::player_radius
+				: game_resources_->monsters_description[ monster.MonsterId() ].w_radius;
+
+			const m_Vec2 monster_z_minmax= monster.GetZMinMax();
+
+			const float distance=
+				DistanceToCylinder(
+					monster.Position().xy(), monster_radius,
+					monster.Position().z + monster_z_minmax.x, monster.Position().z + monster_z_minmax.y,
+					explosion_center );
+
+			if( distance > explosion_radius )
+				return;
+
+			const int damage= distance_to_damage(distance);
+			if( damage > 0 )
+			{
+				monster.Hit(
+					damage, ( monster.Position().xy() - explosion_center.xy() ), explosion_owner_monster_id,
+					*this,
+					monster_id, current_time );
+				damage_done= true;
+			}
+		} );
+
+	for( StaticModel& model : static_models_ )
+	{
+		if( model.model_id >= map_data_->models_description.size() )
+			continue;
+
+		const MapData::ModelDescription& description= map_data_->models_description[ model.model_id ];
+		if( description.radius <= 0.0f || description.blow_effect == 0 ) // Not explodable.
+			continue;
+
+		const Model& model_geometry= map_data_->models[ model.model_id ];
+
+		const float distance=
+			DistanceToCylinder(
+				model.pos.xy(), description.radius,
+				model.pos.z + model_geometry.z_min, model.pos.z + model_geometry.z_max,
+				explosion_center );
+
+		if( distance > explosion_radius )
+			continue;
+
+		const int damage= distance_to_damage(distance);
+		if( damage <= 0 )
+			continue;
+
+		model.health-= damage;
+		if( model.health <= 0 )
+		{
+			const unsigned int model_index= &model - static_models_.data();
+			DestroyModel( model_index );
+			damage_done= true;
+
+			ProcessElementLinks(
+				MapData::IndexElement::StaticModel,
+				model_index,
+				[&]( const MapData::Link& link )
+				{
+					if( link.type == MapData::Link::Destroy )
+						ProcedureProcessDestroy( link.proc_id, current_time );
+				} );
+		}
+	}
+
+	return damage_done;
+}
+
+void Map::ProcessRockets( const Time current_time, const float last_tick_delta_s )
+{
+	const unsigned int rocket_count= rockets_.size();
+	rockets_segments_.start_point.resize( rocket_count );
+	rockets_segments_.direction.resize( rocket_count );
+	rockets_segments_.length.resize( rocket_count );
+	rockets_segments_.hit_result.resize( rocket_count );
+	rockets_segments_.need_kill.resize( rocket_count );
+
+	// Move rockets, calculate segments, passed by rockets in this tick.
+	for( unsigned int r= 0u; r < rocket_count; r++ )
+	{
+		Rocket& rocket= rockets_[r];
+		const GameResources::RocketDescription& rocket_description= game_resources_->rockets_description[ rocket.rocket_type_id ];
+
+		const bool has_infinite_speed= rocket.HasInfiniteSpeed( *game_resources_ );
+		const float time_delta_s= ( current_time - rocket.start_time ).ToSeconds();
+
+		if( has_infinite_speed )
+		{
+			rockets_segments_.start_point[r]= rocket.start_point;
+			rockets_segments_.direction[r]= rocket.normalized_direction;
+			rockets_segments_.length[r]= Constants::max_float;
+		}
+		else
+		{
+			const float c_length_eps= 1.0f / 64.0f;
+			const float gravity_force= GameConstants::rockets_gravity_scale * float( rocket_description.gravity_force );
+			const float speed= rocket_description.fast ? GameConstants::fast_rockets_speed : GameConstants::rockets_speed;
+
+			m_Vec3 new_pos;
+			if( rocket_description.reflect )
+			{
+				rocket.speed.z-= gravity_force * last_tick_delta_s;
+				new_pos= rocket.previous_position + rocket.speed * last_tick_delta_s;
+
+				if( new_pos.z < 0.0f ) // Reflect.
+				{
+					new_pos.z= 0.0f;
+					rocket.speed.z= std::abs( rocket.speed.z );
+				}
+
+				rocket.normalized_direction= rocket.speed;
+				rocket.normalized_direction.Normalize();
+			}
+			else if( rocket_description.Auto2 )
+			{
+				m_Vec3 target_pos;
+				if( FindNearestPlayerPos( rocket.previous_position, target_pos ) )
+				{
+					m_Vec3 dir_to_target= target_pos - rocket.previous_position;
+					dir_to_target.Normalize();
+
+					m_Vec3 rot_axis= mVec3Cross( rocket.normalized_direction, dir_to_target );
+					const float rot_axis_square_length= rot_axis.SquareLength();
+					if( rot_axis_square_length < 0.001f * 0.001f )
+						rot_axis= m_Vec3( 0.0f, 0.0f, 1.0f );
+
+					const float c_rot_speed= Constants::half_pi;
+					m_Mat4 mat;
+					mat.Rotate( rot_axis, last_tick_delta_s * c_rot_speed );
+
+					rocket.normalized_direction= rocket.normalized_direction * mat;
+					rocket.normalized_direction.Normalize();
+				}
+
+				new_pos= rocket.previous_position + rocket.normalized_direction * speed * last_tick_delta_s;
+			}
+			else
+			{
+				new_pos=
+					rocket.start_point +
+					rocket.normalized_direction * ( time_delta_s * speed ) +
+					m_Vec3( 0.0f, 0.0f, -1.0f ) * ( gravity_force * time_delta_s * time_delta_s * 0.5f );
+			}
+
+			m_Vec3 dir= new_pos - rocket.previous_position;
+			const float max_distance= dir.Length() + c_length_eps;
+			dir.Normalize();
+
+			rockets_segments_.start_point[r]= rocket.previous_position;
+			rockets_segments_.direction[r]= dir;
+			rockets_segments_.length[r]= max_distance;
+
+			// Emit smoke trail
+			const unsigned int sprite_effect_id=
+				game_resources_->rockets_description[ rocket.rocket_type_id ].smoke_trail_effect_id;
+			if( sprite_effect_id != 0u )
+			{
+				const float c_particels_per_unit= 2.0f; // TODO - calibrate
+				const float length_delta= ( new_pos - rocket.previous_position ).Length() * c_particels_per_unit;
+				const float new_track_length= rocket.track_length + length_delta;
+				for( unsigned int i= static_cast<unsigned int>( rocket.track_length ) + 1u;
+					i <= static_cast<unsigned int>( new_track_length ); i++ )
+				{
+					const float part= ( float(i) - rocket.track_length ) / length_delta;
+
+					sprite_effects_.emplace_back();
+					SpriteEffect& effect= sprite_effects_.back();
+
+					effect.pos= ( 1.0f - part ) * rocket.previous_position + part * new_pos;
+					effect.effect_id= sprite_effect_id;
+				}
+
+				rocket.track_length= new_track_length;
+			}
+
+			rocket.previous_position= new_pos;
+		}
+	}
+
+	// Trace segments. Tracing does not modify map, so, do it in parallel.
+	const unsigned int c_rockets_per_task= 16u;
+	ProcessInParallel(
+		rocket_count, c_rockets_per_task,
+		[this]( const unsigned int first, const unsigned int last )
+		{
+			for( unsigned int r= first; r < last; r++ )
+				rockets_segments_.hit_result[r]= TraceRocketSegment(r);
+		} );
+
+	// Process hits serially, in rockets order.
+	// Hits may damage or kill monsters and destroy models. After such change trace segments of following rockets again.
+	// Other hits do not affect tracing, because walls and models are moved by procedures only later in tick.
+	bool map_changed= false;
+	for( unsigned int r= 0u; r < rocket_count; r++ )
+	{
+		Rocket& rocket= rockets_[r];
+		const GameResources::RocketDescription& rocket_description= game_resources_->rockets_description[ rocket.rocket_type_id ];
+
+		const bool has_infinite_speed= rocket.HasInfiniteSpeed( *game_resources_ );
+		const float time_delta_s= ( current_time - rocket.start_time ).ToSeconds();
+
+		const HitResult hit_result= map_changed ? TraceRocketSegment(r) : rockets_segments_.hit_result[r];
+
+		// Calculate shifted hit pos.
+		m_Vec3 hit_pos_normal_shifted;
+		const float c_walls_effect_offset= 1.0f / 32.0f;
+		switch(hit_result.object_type)
+		{
+		case HitResult::ObjectType::None:
+			break;
+		case HitResult::ObjectType::StaticWall:
+			hit_pos_normal_shifted=
+				hit_result.pos + GetNormalForWall( map_data_->static_walls[ hit_result.object_index ] ) * c_walls_effect_offset;
+			break;
+		case HitResult::ObjectType::DynamicWall:
+			hit_pos_normal_shifted=
+				hit_result.pos + GetNormalForWall( dynamic_walls_[ hit_result.object_index ] ) * c_walls_effect_offset;
+			break;
+		case HitResult::ObjectType::Model:
+		{
+			const m_Vec2 dir= hit_result.pos.xy() - static_models_[ hit_result.object_index ].pos.xy();
+			hit_pos_normal_shifted=
+				hit_result.pos + m_Vec3( dir, 0.0f ) * ( c_walls_effect_offset / dir.Length() );
+			break;
+		}
+		case HitResult::ObjectType::Monster:
+			hit_pos_normal_shifted= hit_result.pos;
+			break;
+		case HitResult::ObjectType::Floor:
+			hit_pos_normal_shifted=
+				hit_result.pos + m_Vec3( 0.0f, 0.0f, ( hit_result.object_index == 0 ? 1.0f : -1.0f ) * c_walls_effect_offset );
+			break;
+		};
+
+		// Warn monsters.
+		if( hit_result.object_type != HitResult::ObjectType::None )
+			TryWarnMonsters( hit_pos_normal_shifted, current_time );
+
+		const bool process_explosion= !has_infinite_speed;
+		if( hit_result.object_type != HitResult::ObjectType::None && process_explosion &&
+			DoExplosionDamage(
+				hit_result.pos, rocket_description.explosion_radius,
+				GetRocketDamage( rocket_description.power ),
+				rocket.owner_id, current_time ) )
+			map_changed= true;
+
+		// Gen hit effect.
+		if( hit_result.object_type == HitResult::ObjectType::Monster )
+		{
+			AddParticleEffect( hit_result.pos, ParticleEffect::Blood );
+			PlayMapEventSound( hit_result.pos, Sound::SoundId::FirstRocketHit + rocket.rocket_type_id );
+
+			// Hack for rockets and grenades. Make effect together with blood.
+			if( ( rocket_description.blow_effect == 2 || rocket_description.blow_effect == 4 )
+				&& !has_infinite_speed )
+				GenParticleEffectForRocketHit( hit_result.pos, rocket.rocket_type_id );
+		}
+		else if( hit_result.object_type != HitResult::ObjectType::None )
+		{
+			GenParticleEffectForRocketHit( hit_pos_normal_shifted, rocket.rocket_type_id );
+			PlayMapEventSound( hit_pos_normal_shifted, Sound::SoundId::FirstRocketHit + rocket.rocket_type_id );
+		}
+
+		// Try break breakable models.
+		if( hit_result.object_type == HitResult::ObjectType::Model )
+		{
+			StaticModel& model= static_models_[ hit_result.object_index ];
 
-	case ProcedureState::MovementState::Movement:
-	{
-		procedure_state.movement_state= ProcedureState::MovementState::ReverseMovement;
-		float dt_s;
-		if( procedure.speed > 0.0f )
-			dt_s=
-				std::max(
-					1.0f / ( procedure.speed * GameConstants::procedures_speed_scale ) -
-					( current_time - procedure_state.last_state_change_time ).ToSeconds(),
-					0.0f );
-		else
-			dt_s= 0.0f;
-		procedure_state.last_state_change_time= current_time - Time::FromSeconds(dt_s);
-	}
-		break;
+			if( model.model_id >= map_data_->models_description.size() )
+				goto end_loop;
 
-	case ProcedureState::MovementState::BackWait:
-		procedure_state.movement_state= ProcedureState::MovementState::ReverseMovement;
-		procedure_state.last_state_change_time= current_time;
-		break;
-	};
-}
+			const MapData::ModelDescription& model_description= map_data_->models_description[ model.model_id ];
 
-void Map::ProcessWind( const MapData::Procedure::ActionCommand& command, bool activate )
-{
-	PC_ASSERT( command.id == MapData::Procedure::ActionCommandId::Wind );
+			// Process shot even if model is breakable. TODO - check this.
+			ProcessElementLinks(
+				MapData::IndexElement::StaticModel,
+				hit_result.object_index,
+				[&]( const MapData::Link& link )
+				{
+					if( link.type == MapData::Link::Shoot )
+						ProcedureProcessShoot( link.proc_id, current_time );
+				} );
 
-	const unsigned int x0= static_cast<unsigned int>( command.args[0] );
-	const unsigned int y0= static_cast<unsigned int>( command.args[1] );
-	const unsigned int x1= static_cast<unsigned int>( command.args[2] );
-	const unsigned int y1= static_cast<unsigned int>( command.args[3] );
-	const int dir_x= static_cast<int>( command.args[4] );
-	const int dir_y= static_cast<int>( command.args[5] );
+			if( !process_explosion &&
+				model_description.blow_effect != 0 )
+			{
+				model.health-= int(rocket_description.power);
+				if( model.health <= 0 )
+				{
+					DestroyModel( hit_result.object_index );
+					map_changed= true;
 
-	for( unsigned int y= y0; y <= y1 && y < MapData::c_map_size; y++ )
-	for( unsigned int x= x0; x <= x1 && x < MapData::c_map_size; x++ )
-	{
-		char* const cell= wind_field_[ x + y * MapData::c_map_size ];
-		if( activate )
+					ProcessElementLinks(
+						MapData::IndexElement::StaticModel,
+						hit_result.object_index,
+						[&]( const MapData::Link& link )
+						{
+							if( link.type == MapData::Link::Destroy )
+								ProcedureProcessDestroy( link.proc_id, current_time );
+						} );
+				}
+			}
+		}
+		else if(
+			hit_result.object_type == HitResult::ObjectType::StaticWall ||
+			hit_result.object_type == HitResult::ObjectType::DynamicWall )
+		{
+			ProcessElementLinks(
+				hit_result.object_type == HitResult::ObjectType::StaticWall
+					? MapData::IndexElement::StaticWall
+					: MapData::IndexElement::DynamicWall,
+				hit_result.object_index,
+				[&]( const MapData::Link& link )
+				{
+					if( link.type == MapData::Link::Shoot )
+						ProcedureProcessShoot( link.proc_id, current_time );
+				} );
+		}
+		else if( hit_result.object_type == HitResult::ObjectType::Floor )
 		{
-			cell[0]= dir_x;
-			cell[1]= dir_y;
+			// TODO - support rockets reflections
 		}
-		else
-			cell[0]= cell[1]= 0;
-	}
-}
+		else if( hit_result.object_type == HitResult::ObjectType::Monster )
+		{
+			if( !process_explosion )
+			{
+				auto it= monsters_.find( hit_result.object_index );
+				PC_ASSERT( it != monsters_.end() );
 
-void Map::ProcessDeathZone( const MapData::Procedure::ActionCommand& command, const bool activate )
-{
-	PC_ASSERT( command.id == MapData::Procedure::ActionCommandId::Death );
+				const MonsterBasePtr& monster= it->second;
+				PC_ASSERT( monster != nullptr );
+				monster->Hit(
+					GetRocketDamage(rocket_description.power),
+					rocket.normalized_direction.xy(), rocket.owner_id,
+					*this,
+					hit_result.object_index ,current_time );
+				map_changed= true;
+			}
+		}
 
-	const unsigned int x0= static_cast<unsigned int>( command.args[0] );
-	const unsigned int y0= static_cast<unsigned int>( command.args[1] );
-	const unsigned int x1= static_cast<unsigned int>( command.args[2] );
-	const unsigned int y1= static_cast<unsigned int>( command.args[3] );
-	const int z_0= static_cast<int>( command.args[4] );
-	const int z_1= static_cast<int>( command.args[5] );
-	const unsigned char damage= static_cast<unsigned char>( command.args[6] );
+	end_loop:
+		// Kill hited, old rockets and bullets.
+		rockets_segments_.need_kill[r]=
+			hit_result.object_type != HitResult::ObjectType::None ||
+			time_delta_s > 16.0f ||
+			has_infinite_speed;
+	} // for rockets
+
+	PC_ASSERT( rockets_.size() == rocket_count );
 
-	for( unsigned int y= y0; y <= y1 && y < MapData::c_map_size; y++ )
-	for( unsigned int x= x0; x <= x1 && x < MapData::c_map_size; x++ )
+	// Remove killed rockets.
+	for( unsigned int r= 0u; r < rockets_.size(); )
 	{
-		DamageFiledCell& cell= death_field_[ x + y * MapData::c_map_size ];
-		if( activate )
+		if( rockets_segments_.need_kill[r] )
 		{
-			cell.damage= damage;
-			cell.z_bottom= std::max( std::min( z_0, 255 ), 0 );
-			cell.z_top   = std::max( std::min( z_1, 255 ), 0 );
+			if( !rockets_[r].HasInfiniteSpeed( *game_resources_ ) )
+			{
+				rockets_death_messages_.emplace_back();
+				rockets_death_messages_.back().rocket_id= rockets_[r].rocket_id;
+			}
+
+			if( r != rockets_.size() - 1u )
+			{
+				rockets_[r]= rockets_.back();
+				rockets_segments_.need_kill[r]= rockets_segments_.need_kill.back();
+			}
+			rockets_.pop_back();
+			rockets_segments_.need_kill.pop_back();
 		}
 		else
-			cell.damage= 0u;
+			r++;
 	}
 }
 
-void Map::DestroyModel( const unsigned int model_index )
+Map::HitResult Map::TraceRocketSegment( const unsigned int rocket_index ) const
 {
-	PC_ASSERT( model_index < static_models_.size() );
-	StaticModel& model= static_models_[ model_index ];
+	const Rocket& rocket= rockets_[ rocket_index ];
 
-	EmitModelDestructionEffects( model_index );
-
-	model.model_id++; // now, this model has other model type
+	HitResult hit_result=
+		ProcessShot(
+			rockets_segments_.start_point[ rocket_index ],
+			rockets_segments_.direction[ rocket_index ],
+			rockets_segments_.length[ rocket_index ],
+			rocket.owner_id );
 
-	// Reset animation. Animation must be consistent with model.
-	model.animation_start_frame= 0u;
-	model.current_animation_frame= 0u;
-	model.animation_state= StaticModel::AnimationState::Animation;
+	const GameResources::RocketDescription& rocket_description= game_resources_->rockets_description[ rocket.rocket_type_id ];
+	if( rocket_description.reflect && !rocket.HasInfiniteSpeed( *game_resources_ ) &&
+		hit_result.object_type == HitResult::ObjectType::Floor && hit_result.object_index == 0u )
+		hit_result.object_type= HitResult::ObjectType::None; // Reflecting rockets does not hit floors.
 
-	if( model.model_id < map_data_->models_description.size() )
-		model.health= map_data_->models_description[ model.model_id ].break_limit;
-	else
-		model.health= 0;
+	return hit_result;
 }
 
-void Map::DoExplosionDamage(
-	const m_Vec3& explosion_center,
-	const float explosion_radius,
-	const int base_damage,
-	const EntityId explosion_owner_monster_id,
-	const Time current_time )
+void Map::ThinkMonsters( const Time current_time )
 {
-	const auto distance_to_damage=
-	[&] ( const float distance ) -> int
-	{
-		return std::round( float(base_damage) * ( 1.0f - distance / explosion_radius ) );
-	};
-
-	for( MonstersContainer::value_type& monster_value : monsters_ )
+	monsters_to_think_.clear();
+	for( const MonstersContainer::value_type& monster_value : monsters_ )
 	{
-		MonsterBase& monster= *monster_value.second;
-		const float monster_radius=
-			monster.MonsterId() == 0u
-			? GameConstants::player_radius
-			: game_resources_->monsters_description[ monster.MonsterId() ].w_radius;
-
-		const m_Vec2 monster_z_minmax= monster.GetZMinMax();
-
-		const float distance=
-			DistanceToCylinder(
-				monster.Position().xy(), monster_radius,
-				monster.Position().z + monster_z_minmax.x, monster.Position().z + monster_z_minmax.y,
-				explosion_center );
-
-		if( distance > explosion_radius )
-			continue;
-
-		const int damage= distance_to_damage(distance);
-		if( damage > 0 )
-			monster.Hit(
-				damage, ( monster.Position().xy() - explosion_center.xy() ), explosion_owner_monster_id,
-				*this,
-				monster_value.first, current_time );
+		PC_ASSERT( monster_value.second != nullptr );
+		monsters_to_think_.emplace_back( monster_value.first, monster_value.second.get() );
 	}
 
-	for( StaticModel& model : static_models_ )
-	{
-		if( model.model_id >= map_data_->models_description.size() )
-			continue;
-
-		const MapData::ModelDescription& description= map_data_->models_description[ model.model_id ];
-		if( description.radius <= 0.0f || description.blow_effect == 0 ) // Not explodable.
-			continue;
-
-		const Model& model_geometry= map_data_->models[ model.model_id ];
-
-		const float distance=
-			DistanceToCylinder(
-				model.pos.xy(), description.radius,
-				model.pos.z + model_geometry.z_min, model.pos.z + model_geometry.z_max,
-				explosion_center );
-
-		if( distance > explosion_radius )
-			continue;
-
-		const int damage= distance_to_damage(distance);
-		if( damage <= 0 )
-			continue;
-
-		model.health-= damage;
-		if( model.health <= 0 )
+	// Small tasks, for better load balancing - monsters think time differs a lot.
+	const unsigned int c_monsters_per_task= 8u;
+	ProcessInParallel(
+		monsters_to_think_.size(), c_monsters_per_task,
+		[this, current_time]( const unsigned int first, const unsigned int last )
 		{
-			const unsigned int model_index= &model - static_models_.data();
-			DestroyModel( model_index );
-
-			ProcessElementLinks(
-				MapData::IndexElement::StaticModel,
-				model_index,
-				[&]( const MapData::Link& link )
-				{
-					if( link.type == MapData::Link::Destroy )
-						ProcedureProcessDestroy( link.proc_id, current_time );
-				} );
-		}
-	}
+			const Map& map= *this;
+			for( unsigned int i= first; i < last; i++ )
+				monsters_to_think_[i].second->Think( map, monsters_to_think_[i].first, current_time );
+		} );
 }
 
 void Map::TryWarnMonsters( const m_Vec3& pos, const Time current_time )
@@ -2936,15 +3333,25 @@ void Map::MoveMapObjects( const Time current_time )
 	}
 
 	// Apply objects transformations.
+	bool geometry_changed= false;
 	for( unsigned int w= 0u; w < dynamic_walls_.size(); w++ )
 	{
 		const MapData::Wall& map_wall= map_data_->dynamic_walls[ w ];
 		DynamicWall& wall= dynamic_walls_[ w ];
 
+		const m_Vec2 prev_vert_pos[2]= { wall.vert_pos[0], wall.vert_pos[1] };
+		const float prev_z= wall.z;
+
 		for( unsigned int j= 0u; j < 2u; j++ )
 			wall.vert_pos[j]= map_wall.vert_pos[j] * wall.transformation.mat;
 
 		wall.z= wall.transformation.d_z;
+
+		if( !( wall.vert_pos[0] == prev_vert_pos[0] && wall.vert_pos[1] == prev_vert_pos[1] && wall.z == prev_z ) )
+			geometry_changed= true;
+
+		collision_index_.UpdateDynamicWall( w, wall.vert_pos[0], wall.vert_pos[1] );
+		navigation_.UpdateDynamicWall( w, wall.vert_pos[0], wall.vert_pos[1], wall.z, wall.texture_id );
 	}
 
 	for( unsigned int m= 0u; m < static_models_.size(); m++ )
@@ -2952,13 +3359,24 @@ void Map::MoveMapObjects( const Time current_time )
 		const MapData::StaticModel& map_model= map_data_->static_models[ m ];
 		StaticModel& model= static_models_[ m ];
 
+		const m_Vec3 prev_pos= model.pos;
+
 		const m_Vec2 xy= map_model.pos * model.transformation.mat;
 		model.pos.x= xy.x;
 		model.pos.y= xy.y;
 		model.pos.z= model.baze_z + model.transformation.d_z;
 
 		model.angle= map_model.angle + model.transformation_angle_delta;
+
+		if( !( model.pos == prev_pos ) )
+			geometry_changed= true;
+
+		UpdateModelInCollisionIndex( m );
+		navigation_.UpdateModel( m, model.pos, model.model_id );
 	}
+
+	if( geometry_changed )
+		geometry_revision_++;
 }
 
 Map::HitResult Map::ProcessShot(
@@ -2969,6 +3387,7 @@ Map::HitResult Map::ProcessShot(
 {
 	HitResult result;
 	float nearest_shot_point_square_distance= max_distance * max_distance;
+	float nearest_shot_point_distance= max_distance;
 
 	const auto process_candidate_shot_pos=
 	[&]( const m_Vec3& candidate_pos, const HitResult::ObjectType object_type, const unsigned int object_index )
@@ -2978,6 +3397,7 @@ Map::HitResult Map::ProcessShot(
 		{
 			result.pos= candidate_pos;
 			nearest_shot_point_square_distance= square_distance;
+			nearest_shot_point_distance= std::sqrt( square_distance );
 
 			result.object_type= object_type;
 			result.object_index= object_index;
@@ -3031,54 +3451,59 @@ Map::HitResult Map::ProcessShot(
 				process_candidate_shot_pos( candidate_pos, HitResult::ObjectType::Model, &model - static_models_.data() );
 			}
 		}
-		else
+		else if( element.type == MapData::IndexElement::DynamicWall )
 		{
-			// TODO
+			PC_ASSERT( element.index < dynamic_walls_.size() );
+			const DynamicWall& wall= dynamic_walls_[ element.index ];
+
+			const MapData::WallTextureDescription& wall_texture= map_data_->walls_textures[ wall.texture_id ];
+			if( wall_texture.gso[1] )
+				return false;
+
+			m_Vec3 candidate_pos;
+			if( RayIntersectWall(
+					wall.vert_pos[0], wall.vert_pos[1],
+					wall.z, wall.z + 2.0f,
+					shot_start_point, shot_direction_normalized,
+					candidate_pos ) )
+			{
+				process_candidate_shot_pos( candidate_pos, HitResult::ObjectType::DynamicWall, &wall - dynamic_walls_.data() );
+			}
 		}
 
-		// TODO - return true, sometimes.
 		return false;
 	};
 
+	// Static walls, dynamic walls, map models.
+	// Ray cast stops after nearest hit.
 	collision_index_.RayCast(
 		shot_start_point, shot_direction_normalized,
 		func,
-		max_distance );
-
-	// Dynamic walls
-	for( const DynamicWall& wall : dynamic_walls_ )
-	{
-		const MapData::WallTextureDescription& wall_texture= map_data_->walls_textures[ wall.texture_id ];
-		if( wall_texture.gso[1] )
-			continue;
-
-		m_Vec3 candidate_pos;
-		if( RayIntersectWall(
-				wall.vert_pos[0], wall.vert_pos[1],
-				wall.z, wall.z + 2.0f,
-				shot_start_point, shot_direction_normalized,
-				candidate_pos ) )
-		{
-			process_candidate_shot_pos( candidate_pos, HitResult::ObjectType::DynamicWall, &wall - dynamic_walls_.data() );
-		}
-	}
+		max_distance,
+		&nearest_shot_point_distance );
 
 	// Monsters
-	for( const MonstersContainer::value_type& monster_value : monsters_ )
-	{
-		if( monster_value.first == skip_monster_id )
-			continue;
+	// Fetch only monsters before nearest hit point. Limit distance for shots with infinite distance - it is enough to cover whole map.
+	const float monsters_fetch_distance= std::min( nearest_shot_point_distance, float( MapData::c_map_size * 2u ) );
+	monsters_index_.ProcessMonstersNearSegment(
+		shot_start_point.xy(),
+		shot_start_point.xy() + shot_direction_normalized.xy() * monsters_fetch_distance,
+		max_monster_radius_,
+		[&]( const EntityId monster_id, const MonsterBase& monster )
+		{
+			if( monster_id == skip_monster_id )
+				return;
 
-		m_Vec3 candidate_pos;
-		if( monster_value.second->TryShot(
-				shot_start_point, shot_direction_normalized,
-				candidate_pos ) )
-		{
-			process_candidate_shot_pos(
-				candidate_pos, HitResult::ObjectType::Monster,
-				monster_value.first );
-		}
-	}
+			m_Vec3 candidate_pos;
+			if( monster.TryShot(
+					shot_start_point, shot_direction_normalized,
+					candidate_pos ) )
+			{
+				process_candidate_shot_pos(
+					candidate_pos, HitResult::ObjectType::Monster,
+					monster_id );
+			}
+		} );
 
 	// Floors, ceilings
 	for( unsigned int z= 0u; z <= 2u; z+= 2u )
@@ -3201,6 +3626,15 @@ EntityId Map::GetNextMonsterId()
 	return ++next_monster_id_;
 }
 
+float Map::GetMaxMonsterRadius( const GameResources& game_resources )
+{
+	float result= GameConstants::player_radius;
+	for( const GameResources::MonsterDescription& description : game_resources.monsters_description )
+		result= std::max( result, description.w_radius );
+
+	return result;
+}
+
 EntityId Map::GetLightSourceId(
 	const unsigned int parent_procedure_number,
 	const unsigned int light_source_coomand_number ) const
@@ -3219,6 +3653,7 @@ void Map::PrepareRocketStateMessage( const Rocket& rocket, Messages::RocketState
 	VecToAngles( rocket.normalized_direction, angle );
 	for( unsigned int j= 0u; j < 2u; j++ )
 		message.angle[j]= AngleToMessageAngle( angle[j] );
+	message.snapshot_sequence= 0u;
 }
 
 void Map::PrepareMineBirthMessage( const Mine& mine, Messages::DynamicItemBirth& message )
@@ -1,17 +1,24 @@
 #pragma once
-#include <unordered_map>
 
 #include <matrix.hpp>
 
+#include "../entities_container.hpp"
 #include "../map_loader.hpp"
 #include "../messages_sender.hpp"
 #include "../particles.hpp"
 #include "../rand.hpp"
+#include "../thread_pool.hpp"
 #include "../time.hpp"
+#include "active_zones.hpp"
 #include "collision_index.hpp"
 #include "backpack.hpp"
+#include "delta_snapshots.hpp"
 #include "fwd.hpp"
+#include "monsters_index.hpp"
 #include "movement_restriction.hpp"
+#include "navigation.hpp"
+#include "timer_wheel.hpp"
+#include "visibility_matrix.hpp"
 
 namespace PanzerChasm
 {
@@ -23,8 +30,8 @@ public:
 	typedef std::function<void()> MapEndCallback;
 	typedef std::function<void(const char*)> TextMessageCallback;
 
-	typedef std::unordered_map< EntityId, MonsterBasePtr > MonstersContainer;
-	typedef std::unordered_map< EntityId, PlayerPtr > PlayersContainer;
+	typedef EntitiesContainer<MonsterBasePtr> MonstersContainer;
+	typedef EntitiesContainer<PlayerPtr> PlayersContainer;
 
 	Map(
 		DifficultyType difficulty,
@@ -87,15 +94,29 @@ public:
 		bool& out_on_floor, MovementRestriction& out_movement_restriction ) const;
 
 	bool CanSee( const m_Vec3& from, const m_Vec3& to ) const;
+	// Revision of dynamic geometry ( dynamic walls and models ), which may change result of "CanSee".
+	// Increased after each change of this geometry, so, visibility, calculated with same revision, is still actual.
+	unsigned int GetGeometryRevision() const;
+
+	// Returns direction of path from "from" to "to" along navigation field of player.
+	// Returns false, if "to" is far from player, or if field does not help. Thread-safe.
+	bool GetMoveDirection( EntityId player_id, const m_Vec2& from, const m_Vec2& to, m_Vec2& out_direction ) const;
 
 	const MonstersContainer& GetMonsters() const;
 	const PlayersContainer& GetPlayers() const;
 
 	void ProcessPlayerPosition( Time current_time, EntityId player_monster_id, MessagesSender& messages_sender );
-	void Tick( Time current_time, Time last_tick_delta );
+	void Tick( Time current_time, Time last_tick_delta, TickProfiler& profiler );
 
 	void SendMessagesForNewlyConnectedPlayer( MessagesSender& messages_sender ) const;
-	void SendUpdateMessages( MessagesSender& messages_sender ) const;
+	// Call it once per server loop, before sending of update messages.
+	void UpdateSnapshot( unsigned int snapshot_sequence );
+	// Sends update messages, relevant for player. States of walls, models, items, monsters, rockets are sent only if
+	// client has not received them yet. States of far and hidden entities are sent with lower rate.
+	void SendUpdateMessages(
+		MessagesSender& messages_sender,
+		EntityId player_monster_id,
+		DeltaSnapshots::ClientState& snapshots_state ) const;
 
 	void ClearUpdateEvents();
 
@@ -115,6 +136,7 @@ private:
 
 		bool locked= false;
 		bool first_message_printed= false;
+		bool active= false; // Is in active procedures list. Do not save.
 
 		MovementState movement_state= MovementState::None;
 		float movement_stage= 0.0f; // stage of current movement state [0; 1]
@@ -229,6 +251,8 @@ private:
 
 	typedef std::vector<Mine> Mines;
 
+	typedef EntitiesContainer<BackpackPtr> BackpacksContainer;
+
 	struct SpriteEffect
 	{
 		m_Vec3 pos;
@@ -253,7 +277,7 @@ private:
 		float brightness;
 		unsigned short turn_on_time_ms;
 	};
-	typedef std::unordered_map< EntityId, LightSource > LightSourcesContainer;
+	typedef EntitiesContainer<LightSource> LightSourcesContainer;
 
 	struct HitResult
 	{
@@ -271,6 +295,21 @@ private:
 		m_Vec3 pos;
 	};
 
+	// Event for timer wheel. Object may change or disappear before event time, so, check it, when event fires.
+	struct TimerEvent
+	{
+		enum class Type
+		{
+			ProcedureWakeUp, // index - procedure number
+			MineTurnOn, // index - mine id
+			ItemRespawn, // index - item number
+			RotatingLightEnd, // index - static model number
+		};
+
+		Type type;
+		unsigned int index;
+	};
+
 	struct DamageFiledCell
 	{
 		unsigned char damage; // 0 - means no damage
@@ -288,14 +327,23 @@ private:
 	void DeactivateProcedureLightSources( const MapData::Procedure& procedure );
 	void EmitProcedureSound( const MapData::Procedure& procedure );
 	void ReturnProcedure( unsigned int procedure_number, Time current_time );
+	void AddActiveProcedure( unsigned int procedure_number );
+	// Returns true, if procedure does not need update each tick. Schedules procedure wake up in this case.
+	bool TryPutProcedureToSleep( unsigned int procedure_number, Time current_time );
+	void ProcessTimerEvents( Time current_time );
 
 	void ProcessWind( const MapData::Procedure::ActionCommand& command, bool activate );
 	void ProcessDeathZone( const MapData::Procedure::ActionCommand& command, bool activate );
 	void DestroyModel( unsigned int model_index );
-	void DoExplosionDamage(
+	void UpdateModelInCollisionIndex( unsigned int model_index );
+	// Returns true, if monsters were damaged or models were destroyed.
+	bool DoExplosionDamage(
 		const m_Vec3& explosion_center, float explosion_radius,
 		int base_damage, EntityId explosion_owner_monster_id, Time current_time );
 
+	void ProcessRockets( Time current_time, float last_tick_delta_s );
+	HitResult TraceRocketSegment( unsigned int rocket_index ) const;
+	void ThinkMonsters( Time current_time );
 	void TryWarnMonsters( const m_Vec3& pos, Time current_time );
 	void MoveMapObjects( Time current_time );
 
@@ -305,6 +353,11 @@ private:
 		unsigned int index,
 		const Func& func );
 
+	// Func( unsigned int first, unsigned int last ) - process elements in range [first; last).
+	// Func calls may be executed in parallel, so, they must not modify shared state.
+	template<class Func>
+	void ProcessInParallel( unsigned int count, unsigned int elements_per_task, const Func& func );
+
 	HitResult ProcessShot(
 		const m_Vec3& shot_start_point,
 		const m_Vec3& shot_direction_normalized,
@@ -316,6 +369,7 @@ private:
 	float GetFloorLevel( const m_Vec2& pos, float radius= 0.0f ) const;
 
 	EntityId GetNextMonsterId();
+	static float GetMaxMonsterRadius( const GameResources& game_resources );
 	EntityId GetLightSourceId( unsigned int parent_procedure_number, unsigned int light_source_coomand_number ) const;
 
 	static void PrepareRocketStateMessage( const Rocket& rocket, Messages::RocketState& message );
@@ -337,11 +391,21 @@ private:
 
 	const LongRandPtr random_generator_;
 
+	// Upper bound of monsters collision radius. Used for expanding of monsters index queries.
+	const float max_monster_radius_;
+
 	unsigned int next_spawn_number_= 0u; // For multiplayer modes only. Do not save.
 
 	DynamicWalls dynamic_walls_;
 
 	std::vector<ProcedureState> procedures_;
+	// Numbers of procedures, which need update each tick, in ascending order.
+	// Other procedures sleep until their timer events.
+	std::vector<unsigned int> active_procedures_;
+
+	// Wake up times for procedures, mines, items and rotating lights.
+	TimerWheel<TimerEvent> timer_wheel_;
+	std::vector<unsigned int> expired_rotating_lights_;
 
 	bool map_end_triggered_= false;
 
@@ -350,7 +414,7 @@ private:
 
 	Rockets rockets_;
 	Mines mines_;
-	std::unordered_map<EntityId, BackpackPtr> backpacks_;
+	BackpacksContainer backpacks_;
 	EntityId next_rocket_id_= 1u; // Common id for rockets, mines, backpacks, etc.
 
 	SpriteEffects sprite_effects_;
@@ -359,6 +423,25 @@ private:
 	MonstersContainer monsters_; // + players
 	EntityId next_monster_id_= 1u;
 
+	// Temporary storage for monsters index queries results.
+	std::vector< std::pair< EntityId, MonsterBase* > > near_monsters_;
+
+	// Monsters think in parallel, see ThinkMonsters.
+	std::vector< std::pair< EntityId, MonsterBase* > > monsters_to_think_;
+
+	// Segments, passed by rockets in current tick, in structure of arrays form. Indexed same as rockets_.
+	struct
+	{
+		std::vector<m_Vec3> start_point;
+		std::vector<m_Vec3> direction;
+		std::vector<float> length;
+		std::vector<HitResult> hit_result;
+		std::vector<bool> need_kill;
+	} rockets_segments_;
+
+	// Workers for read-only parts of tick, see ProcessInParallel.
+	ThreadPool thread_pool_;
+
 	LightSourcesContainer light_sources_;
 
 	std::vector<Messages::MonsterBirth> monsters_birth_messages_;
@@ -378,13 +461,21 @@ private:
 	std::vector<Messages::MonsterLinkedSound> monster_linked_sounds_messages_;
 	std::vector<Messages::MonsterSound> monsters_sounds_messages_;
 
-	// Put large objects here.
+	// Last states of walls, models, items, monsters and rockets. Do not save.
+	DeltaSnapshots delta_snapshots_;
+
+	// Active wind and death zones. Built by procedures.
+	ActiveZones<m_Vec2> wind_zones_;
+	ActiveZones<DamageFiledCell> death_zones_;
 
-	// TODO - compress this fields
-	char wind_field_[ MapData::c_map_size * MapData::c_map_size ][2];
-	DamageFiledCell death_field_[ MapData::c_map_size * MapData::c_map_size ];
+	unsigned int geometry_revision_= 0u; // Do not save.
+
+	// Put large objects here.
 
-	const CollisionIndex collision_index_;
+	CollisionIndex collision_index_;
+	const VisibilityMatrixConstPtr visibility_matrix_; // Shared with map data.
+	Navigation navigation_; // Must be initialized after collision index.
+	MonstersIndex monsters_index_; // Monsters + players.
 };
 
 } // PanzerChasm
@@ -1,3 +1,4 @@
+#include "../game_constants.hpp"
 #include "../save_load_streams.hpp"
 #include "map.hpp"
 #include "monster.hpp"
@@ -108,7 +109,7 @@ void Map::Save( SaveStream& save_stream ) const
 
 	// Backpacks
 	save_stream.WriteUInt32( static_cast<uint32_t>( backpacks_.size() ) );
-	for( const std::unordered_map<EntityId, BackpackPtr>::value_type& backpack_value : backpacks_ )
+	for( const BackpacksContainer::value_type& backpack_value : backpacks_ )
 	{
 		const Backpack& backpack = *backpack_value.second;
 
@@ -160,17 +161,25 @@ void Map::Save( SaveStream& save_stream ) const
 		save_stream.WriteUInt16( light_source.turn_on_time_ms );
 	}
 
-	// Wind field
+	// Wind field. Save values of all cells, zones are restored from cells.
 	// TODO - optimize large arrays saving
-	for( const char* const wind_field_cell : wind_field_ )
+	for( unsigned int y= 0u; y < MapData::c_map_size; y++ )
+	for( unsigned int x= 0u; x < MapData::c_map_size; x++ )
 	{
-		save_stream.WriteInt8( int8_t( wind_field_cell[0] ) );
-		save_stream.WriteInt8( int8_t( wind_field_cell[1] ) );
+		const m_Vec2* const wind= wind_zones_.Get( int(x), int(y) );
+		save_stream.WriteInt8( int8_t( wind == nullptr ? 0 : int(wind->x) ) );
+		save_stream.WriteInt8( int8_t( wind == nullptr ? 0 : int(wind->y) ) );
 	}
 
 	// Death field
-	for( const DamageFiledCell& damage_field_cell : death_field_ )
+	for( unsigned int y= 0u; y < MapData::c_map_size; y++ )
+	for( unsigned int x= 0u; x < MapData::c_map_size; x++ )
 	{
+		DamageFiledCell damage_field_cell;
+		damage_field_cell.damage= damage_field_cell.z_bottom= damage_field_cell.z_top= 0u;
+		if( const DamageFiledCell* const zone_cell= death_zones_.Get( int(x), int(y) ) )
+			damage_field_cell= *zone_cell;
+
 		save_stream.WriteUInt8( damage_field_cell.damage );
 		save_stream.WriteUInt8( damage_field_cell.z_bottom );
 		save_stream.WriteUInt8( damage_field_cell.z_top );
@@ -192,9 +201,13 @@ Map::Map(
 	, map_end_callback_( std::move( map_end_callback ) )
 	, text_message_callback_( std::move(text_message_callback) )
 	, random_generator_( std::make_shared<LongRand>() )
+	, max_monster_radius_( GetMaxMonsterRadius( *game_resources ) )
 	, collision_index_( map_data )
+	, visibility_matrix_( map_data->visibility_matrix )
+	, navigation_( *map_data, collision_index_ )
 {
 	PC_ASSERT( map_data_ != nullptr );
+	PC_ASSERT( visibility_matrix_ != nullptr );
 	PC_ASSERT( game_resources_ != nullptr );
 
 	// Random generator.
@@ -232,6 +245,10 @@ Map::Map(
 		procedure_state.movement_state= static_cast<ProcedureState::MovementState>( movement_state );
 		load_stream.ReadFloat( procedure_state.movement_stage );
 		load_stream.ReadTime( procedure_state.last_state_change_time );
+
+		// Procedures, which do nothing, go to sleep after first update.
+		if( procedure_state.movement_state != ProcedureState::MovementState::None )
+			AddActiveProcedure( static_cast<unsigned int>( &procedure_state - procedures_.data() ) );
 	}
 
 	// Map end flag
@@ -270,6 +287,10 @@ Map::Map(
 			load_stream.ReadTime( model.linked_rotating_light->end_time );
 			load_stream.ReadFloat( model.linked_rotating_light->radius );
 			load_stream.ReadFloat( model.linked_rotating_light->brightness );
+
+			timer_wheel_.Schedule(
+				model.linked_rotating_light->end_time,
+				TimerEvent{ TimerEvent::Type::RotatingLightEnd, static_cast<unsigned int>( &model - static_models_.data() ) } );
 		}
 	}
 
@@ -316,6 +337,11 @@ Map::Map(
 		load_stream.ReadUInt16( mine.id );
 		load_stream.ReadUInt16( mine.owner_id );
 		load_stream.ReadBool( mine.turned_on );
+
+		if( !mine.turned_on )
+			timer_wheel_.Schedule(
+				mine.planting_time + Time::FromSeconds( double(GameConstants::mines_preparation_time_s) ) - Time::FromInternalRepresentation(1),
+				TimerEvent{ TimerEvent::Type::MineTurnOn, mine.id } );
 	}
 
 	// Backpacks
@@ -366,11 +392,13 @@ Map::Map(
 			player->SetRandomGenerator( random_generator_ );
 			players_[id]= player;
 			monsters_[id]= player;
+			monsters_index_.AddMonster( id, *player );
 		}
 		else
 		{
 			const MonsterPtr monster= std::make_shared<Monster>( monster_id, game_resources_, random_generator_, load_stream );
 			monsters_[id]= monster;
+			monsters_index_.AddMonster( id, *monster );
 		}
 	}
 
@@ -393,21 +421,58 @@ Map::Map(
 		load_stream.ReadUInt16( light_source.turn_on_time_ms );
 	}
 
-	// Wind field
+	// Wind field. Make zone for each run of cells with same values in row.
 	// TODO - optimize large arrays saving
-	for( char* const wind_field_cell : wind_field_ )
+	for( unsigned int y= 0u; y < MapData::c_map_size; y++ )
 	{
-		load_stream.ReadInt8( reinterpret_cast<int8_t&>(wind_field_cell[0]) );
-		load_stream.ReadInt8( reinterpret_cast<int8_t&>(wind_field_cell[1]) );
+		int8_t row[ MapData::c_map_size ][2];
+		for( unsigned int x= 0u; x < MapData::c_map_size; x++ )
+		{
+			load_stream.ReadInt8( row[x][0] );
+			load_stream.ReadInt8( row[x][1] );
+		}
+
+		for( unsigned int x= 0u; x < MapData::c_map_size; )
+		{
+			unsigned int run_end= x + 1u;
+			while( run_end < MapData::c_map_size && row[run_end][0] == row[x][0] && row[run_end][1] == row[x][1] )
+				run_end++;
+
+			if( row[x][0] != 0 || row[x][1] != 0 )
+				wind_zones_.Activate( x, y, run_end - 1u, y, m_Vec2( float(row[x][0]), float(row[x][1]) ) );
+			x= run_end;
+		}
 	}
 
 	// Death field
-	for( DamageFiledCell& damage_field_cell : death_field_ )
+	for( unsigned int y= 0u; y < MapData::c_map_size; y++ )
 	{
-		load_stream.ReadUInt8( damage_field_cell.damage );
-		load_stream.ReadUInt8( damage_field_cell.z_bottom );
-		load_stream.ReadUInt8( damage_field_cell.z_top );
+		DamageFiledCell row[ MapData::c_map_size ];
+		for( unsigned int x= 0u; x < MapData::c_map_size; x++ )
+		{
+			load_stream.ReadUInt8( row[x].damage );
+			load_stream.ReadUInt8( row[x].z_bottom );
+			load_stream.ReadUInt8( row[x].z_top );
+		}
+
+		for( unsigned int x= 0u; x < MapData::c_map_size; )
+		{
+			unsigned int run_end= x + 1u;
+			while( run_end < MapData::c_map_size &&
+				row[run_end].damage == row[x].damage && row[run_end].z_bottom == row[x].z_bottom && row[run_end].z_top == row[x].z_top )
+				run_end++;
+
+			if( row[x].damage != 0u )
+				death_zones_.Activate( x, y, run_end - 1u, y, row[x] );
+			x= run_end;
+		}
 	}
+
+	// Place loaded dynamic walls and models into collision index.
+	for( unsigned int w= 0u; w < dynamic_walls_.size(); w++ )
+		collision_index_.UpdateDynamicWall( w, dynamic_walls_[w].vert_pos[0], dynamic_walls_[w].vert_pos[1] );
+	for( unsigned int m= 0u; m < static_models_.size(); m++ )
+		UpdateModelInCollisionIndex( m );
 }
 
 void MonsterBase::Save( SaveStream& save_stream )
@@ -123,6 +123,69 @@ Monster::Monster(
 Monster::~Monster()
 {}
 
+void Monster::Think(
+	const Map& map,
+	const EntityId monster_id,
+	const Time current_time )
+{
+	PC_UNUSED( monster_id );
+	PC_UNUSED( current_time );
+
+	think_result_.pos= pos_;
+	think_result_.geometry_revision= map.GetGeometryRevision();
+	think_result_.target_visibility_calculated= false;
+	think_result_.have_move_direction= false;
+	think_result_.players_visibility.clear();
+
+	// Target visibility, needed for target position update.
+	const MonsterBasePtr target= target_.monster.lock();
+	if( target != nullptr )
+	{
+		think_result_.target_id= target_.monster_id;
+		think_result_.target_pos= target->Position();
+		think_result_.target_visible= CanSee( map, target->Position() );
+		think_result_.target_visibility_calculated= true;
+	}
+
+	// Path to target, needed for movement. Navigation fields exist only for players.
+	if( target != nullptr && target->MonsterId() == 0u &&
+		state_ != State::DeathAnimation && state_ != State::Dead &&
+		( target_.have_position || think_result_.target_visible ) )
+	{
+		// Position of visible target will be updated in tick.
+		const m_Vec2 target_pos= think_result_.target_visible ? target->Position().xy() : target_.position.xy();
+		think_result_.have_move_direction=
+			map.GetMoveDirection( target_.monster_id, pos_.xy(), target_pos, think_result_.move_direction );
+	}
+
+	// Players visibility, needed for target selection.
+	// Check players in same order and with same conditions, as in SelectTarget.
+	if( state_ == State::DeathAnimation || state_ == State::Dead )
+		return;
+	if( target != nullptr && target->Health() > 0 && ( target_.have_position || think_result_.target_visible ) )
+		return;
+
+	float nearest_player_distance= Constants::max_float;
+	for( const Map::PlayersContainer::value_type& player_value : map.GetPlayers() )
+	{
+		PC_ASSERT( player_value.second != nullptr );
+		const Player& player= *player_value.second;
+
+		const float distance_to_player= GetDistanceToPossibleTarget( player );
+		if( distance_to_player >= nearest_player_distance )
+			continue;
+
+		const bool visible= CanSee( map, player.Position() );
+		ThinkPlayerVisibility player_visibility;
+		player_visibility.player_id= player_value.first;
+		player_visibility.player_pos= player.Position();
+		player_visibility.visible= visible;
+		think_result_.players_visibility.push_back( player_visibility );
+		if( visible )
+			nearest_player_distance= distance_to_player;
+	}
+}
+
 void Monster::Tick(
 	Map& map,
 	const EntityId monster_id,
@@ -150,7 +213,7 @@ void Monster::Tick(
 	{
 		target_is_alive= target->Health() > 0;
 
-		if( CanSee( map, target->Position() ) )
+		if( CanSeeTarget( map, *target ) )
 		{
 			target_.position= target->Position();
 			target_.have_position= true;
@@ -213,7 +276,7 @@ void Monster::Tick(
 			{
 				if( description.rock >= 0 && target_is_alive &&
 					have_right_hand_ && // Monster hold weapon in right hand
-					CanSee( map, target->Position() ) )
+					CanSeeTarget( map, *target ) )
 				{
 					state_= State::RemoteAttack;
 					current_animation_= GetAnimation( AnimationId::RemoteAttack );
@@ -384,6 +447,11 @@ void Monster::Tick(
 		const unsigned int current_animation_frame_count= model.animations[ current_animation_ ].frame_count;
 		current_animation_frame_= std::min( new_frame_i, current_animation_frame_count - 1u );
 	}
+
+	// Think results are valid only for this tick.
+	think_result_.target_visibility_calculated= false;
+	think_result_.have_move_direction= false;
+	think_result_.players_visibility.clear();
 }
 
 void Monster::Hit(
@@ -653,6 +721,7 @@ void Monster::BuildStateMessage( Messages::MonsterState& out_message ) const
 	out_message.is_fully_dead= IsFullyDead();
 	out_message.is_invisible= IsInvisible();
 	out_message.color= 0;
+	out_message.snapshot_sequence= 0u;
 }
 
 bool Monster::IsBoss() const
@@ -681,6 +750,59 @@ bool Monster::CanSee( const Map& map, const m_Vec3& pos ) const
 	return map.CanSee( pos_ + g_see_point_delta, pos + g_see_point_delta );
 }
 
+bool Monster::CanSeeTarget( const Map& map, const MonsterBase& target ) const
+{
+	if( think_result_.target_visibility_calculated && think_result_.target_id == target_.monster_id &&
+		think_result_.pos == pos_ && think_result_.target_pos == target.Position() &&
+		think_result_.geometry_revision == map.GetGeometryRevision() )
+		return think_result_.target_visible;
+
+	// Target changed, monster or target moved or map geometry changed after think.
+	return CanSee( map, target.Position() );
+}
+
+bool Monster::CanSeePlayer( const Map& map, const EntityId player_id, const Player& player ) const
+{
+	if( think_result_.pos == pos_ && think_result_.geometry_revision == map.GetGeometryRevision() )
+	{
+		for( const ThinkPlayerVisibility& player_visibility : think_result_.players_visibility )
+			if( player_visibility.player_id == player_id && player_visibility.player_pos == player.Position() )
+				return player_visibility.visible;
+	}
+
+	// Player was not checked in think, monster or player moved or map geometry changed after think.
+	return CanSee( map, player.Position() );
+}
+
+float Monster::GetDistanceToPossibleTarget( const Player& player ) const
+{
+	if( player.Health() <= 0 )
+		return Constants::max_float;
+
+	const m_Vec2 dir_to_player= player.Position().xy() - Position().xy();
+	const float distance_to_player= dir_to_player.Length();
+	if( distance_to_player == 0.0f )
+		return Constants::max_float;
+
+	if( state_ == State::Idle )
+	{
+		const float c_half_view_angle= Constants::half_pi * 0.75f;
+		const float c_half_view_angle_cos= std::cos( c_half_view_angle );
+		const m_Vec2 view_dir( std::cos(angle_), std::sin(angle_) );
+
+		// Monsters in Idle state have no back eyes.
+		const float angle_cos= ( dir_to_player * view_dir ) / distance_to_player;
+		if( angle_cos < c_half_view_angle_cos )
+			return Constants::max_float;
+
+		// Monsters in Idle state didn`t see invisible players.
+		if( player.IsInvisible() )
+			return Constants::max_float;
+	}
+
+	return distance_to_player;
+}
+
 unsigned int Monster::GetIdleAnimation() const
 {
 	return GetAnyAnimation( { AnimationId::Idle0, AnimationId::Idle1, AnimationId::Run } );
@@ -750,7 +872,11 @@ void Monster::MoveToTarget( const float time_delta_s )
 	pos_.x+= std::cos(angle_) * distance_delta;
 	pos_.y+= std::sin(angle_) * distance_delta;
 
-	RotateToTarget( time_delta_s );
+	// Follow path around obstacles, if it is known, else go directly to target.
+	if( think_result_.have_move_direction && think_result_.target_id == target_.monster_id )
+		RotateToDirection( think_result_.move_direction, time_delta_s );
+	else
+		RotateToTarget( time_delta_s );
 }
 
 void Monster::RotateToTarget( float time_delta_s )
@@ -758,11 +884,15 @@ void Monster::RotateToTarget( float time_delta_s )
 	if( !target_.have_position )
 		return;
 
-	const m_Vec2 vec_to_target= target_.position.xy() - pos_.xy();
-	if( vec_to_target.SquareLength() == 0.0f )
+	RotateToDirection( target_.position.xy() - pos_.xy(), time_delta_s );
+}
+
+void Monster::RotateToDirection( const m_Vec2& direction, const float time_delta_s )
+{
+	if( direction.SquareLength() == 0.0f )
 		return;
 
-	const float target_angle= NormalizeAngle( std::atan2( vec_to_target.y, vec_to_target.x ) );
+	const float target_angle= NormalizeAngle( std::atan2( direction.y, direction.x ) );
 	float target_angle_delta= target_angle - angle_;
 	if( target_angle_delta > +Constants::pi )
 		target_angle_delta-= Constants::two_pi;
@@ -803,10 +933,6 @@ bool Monster::SelectTarget( const Map& map )
 			return true;
 	}
 
-	const float c_half_view_angle= Constants::half_pi * 0.75f;
-	const float c_half_view_angle_cos= std::cos( c_half_view_angle );
-	const m_Vec2 view_dir( std::cos(angle_), std::sin(angle_) );
-
 	float nearest_player_distance= Constants::max_float;
 	const Map::PlayersContainer::value_type* nearest_player= nullptr;
 
@@ -816,30 +942,11 @@ bool Monster::SelectTarget( const Map& map )
 		PC_ASSERT( player_value.second != nullptr );
 		const Player& player= *player_value.second;
 
-		if( player.Health() <= 0 )
-			continue;
-
-		const m_Vec2 dir_to_player= player.Position().xy() - Position().xy();
-		const float distance_to_player= dir_to_player.Length();
-		if( distance_to_player == 0.0f )
-			continue;
-
+		const float distance_to_player= GetDistanceToPossibleTarget( player );
 		if( distance_to_player >= nearest_player_distance )
 			continue;
 
-		if( state_ == State::Idle )
-		{
-			// Monsters in Idle state have no back eyes.
-			const float angle_cos= ( dir_to_player * view_dir ) / distance_to_player;
-			if( angle_cos < c_half_view_angle_cos )
-				continue;
-
-			// Monsters in Idle state didn`t see invisible players.
-			if( player.IsInvisible() )
-				continue;
-		}
-
-		if( CanSee( map, player.Position() ) )
+		if( CanSeePlayer( map, player_value.first, player ) )
 		{
 			nearest_player_distance= distance_to_player;
 			nearest_player= &player_value;
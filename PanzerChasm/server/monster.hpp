@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <vector>
 
 #include <vec.hpp>
 
@@ -31,6 +32,11 @@ public:
 
 	virtual void Save( SaveStream& save_stream ) override;
 
+	virtual void Think(
+		const Map& map,
+		EntityId monster_id,
+		Time current_time ) override;
+
 	virtual void Tick(
 		Map& map,
 		EntityId monster_id,
@@ -77,12 +83,18 @@ private:
 	bool IsFinalBoss() const;
 
 	bool CanSee( const Map& map, const m_Vec3& pos ) const;
+	// Use visibility, calculated in Think, if possible.
+	bool CanSeeTarget( const Map& map, const MonsterBase& target ) const;
+	bool CanSeePlayer( const Map& map, EntityId player_id, const Player& player ) const;
+	// Returns max_float if player can not be target.
+	float GetDistanceToPossibleTarget( const Player& player ) const;
 
 	unsigned int GetIdleAnimation() const;
 	void DoShoot( const m_Vec3& target_pos, Map& map, EntityId monster_id, Time current_time );
 	void FallDown( float time_delta_s );
 	void MoveToTarget( float time_delta_s );
 	void RotateToTarget( float time_delta_s );
+	void RotateToDirection( const m_Vec2& direction, float time_delta_s );
 	bool SelectTarget( const Map& map ); // returns true, if selected
 	int SelectMeleeAttackAnimation();
 	void SpawnBodyPart( Map& map, unsigned char part_id );
@@ -105,6 +117,28 @@ private:
 		m_Vec3 position;
 		bool have_position= false;
 	} target_;
+
+	struct ThinkPlayerVisibility
+	{
+		EntityId player_id;
+		m_Vec3 player_pos;
+		bool visible;
+	};
+
+	// Results of Think. Not saved.
+	// Visibility results are valid only while monster and target stay in positions, for which they were calculated.
+	struct
+	{
+		m_Vec3 pos; // Monster position in think.
+		m_Vec3 target_pos;
+		unsigned int geometry_revision; // Map geometry revision for visibility checks.
+		EntityId target_id= 0u;
+		bool target_visibility_calculated= false;
+		bool target_visible= false;
+		bool have_move_direction= false; // Direction of path to target.
+		m_Vec2 move_direction;
+		std::vector<ThinkPlayerVisibility> players_visibility; // Only for checked players.
+	} think_result_;
 };
 
 } // namespace PanzerChasm
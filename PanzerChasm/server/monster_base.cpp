@@ -125,6 +125,16 @@ const MovementRestriction& MonsterBase::GetMovementRestriction() const
 	return movement_restriction_;
 }
 
+void MonsterBase::Think(
+	const Map& map,
+	const EntityId monster_id,
+	const Time current_time )
+{
+	PC_UNUSED( map );
+	PC_UNUSED( monster_id );
+	PC_UNUSED( current_time );
+}
+
 int MonsterBase::GetAnimation( const AnimationId id ) const
 {
 	PC_ASSERT( monster_id_ < game_resources_->monsters_models.size() );
@@ -46,6 +46,13 @@ public:
 	void SetMovementRestriction( const MovementRestriction& restriction );
 	const MovementRestriction& GetMovementRestriction() const;
 
+	// Read-only part of tick. Called for all monsters before their ticks, possibly in parallel for different monsters.
+	// Must not modify map and other monsters, may only store results in this monster for following Tick call.
+	virtual void Think(
+		const Map& map,
+		EntityId monster_id,
+		Time current_time );
+
 	virtual void Tick(
 		Map& map,
 		EntityId monster_id,
@@ -0,0 +1,81 @@
+#include <cmath>
+
+#include "../assert.hpp"
+#include "monster_base.hpp"
+
+#include "monsters_index.hpp"
+
+namespace PanzerChasm
+{
+
+MonstersIndex::MonstersIndex()
+{}
+
+MonstersIndex::~MonstersIndex()
+{}
+
+void MonstersIndex::AddMonster( const EntityId monster_id, MonsterBase& monster )
+{
+	PC_ASSERT( monsters_.find( monster_id ) == monsters_.end() );
+
+	MonsterInfo& info= monsters_[ monster_id ];
+	info.monster= &monster;
+	info.cell= GetCellForPosition( monster.Position().xy() );
+
+	cells_[ info.cell ].push_back( CellElement{ monster_id, &monster } );
+}
+
+void MonstersIndex::RemoveMonster( const EntityId monster_id )
+{
+	const auto it= monsters_.find( monster_id );
+	if( it == monsters_.end() )
+		return;
+
+	RemoveFromCell( monster_id, it->second.cell );
+	monsters_.erase( it );
+}
+
+void MonstersIndex::UpdateMonster( const EntityId monster_id )
+{
+	const auto it= monsters_.find( monster_id );
+	PC_ASSERT( it != monsters_.end() );
+	MonsterInfo& info= it->second;
+
+	const unsigned int new_cell= GetCellForPosition( info.monster->Position().xy() );
+	if( new_cell == info.cell )
+		return;
+
+	RemoveFromCell( monster_id, info.cell );
+	info.cell= new_cell;
+	cells_[ new_cell ].push_back( CellElement{ monster_id, info.monster } );
+}
+
+unsigned int MonstersIndex::GetCellForPosition( const m_Vec2& pos )
+{
+	const int x= static_cast<int>( std::floor( pos.x ) );
+	const int y= static_cast<int>( std::floor( pos.y ) );
+	if( x < 0 || x >= int(MapData::c_map_size) ||
+		y < 0 || y >= int(MapData::c_map_size) )
+		return c_outside_map_cell;
+
+	return static_cast<unsigned int>( x + y * int(MapData::c_map_size) );
+}
+
+void MonstersIndex::RemoveFromCell( const EntityId monster_id, const unsigned int cell )
+{
+	Cell& cell_elements= cells_[ cell ];
+	for( unsigned int i= 0u; i < cell_elements.size(); i++ )
+	{
+		if( cell_elements[i].monster_id == monster_id )
+		{
+			if( i != cell_elements.size() - 1u )
+				cell_elements[i]= cell_elements.back();
+			cell_elements.pop_back();
+			return;
+		}
+	}
+
+	PC_ASSERT(false);
+}
+
+} // namespace PanzerChasm
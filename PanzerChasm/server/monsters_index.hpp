@@ -0,0 +1,71 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+#include "../map_loader.hpp"
+#include "fwd.hpp"
+
+namespace PanzerChasm
+{
+
+// Uniform grid of monsters (and players) for fast proximity queries.
+// Each monster placed in map cell of its center. Monsters outside map placed in special cell, which is fetched by any query.
+// Index must be updated after monsters movement, see UpdateMonster.
+// Queries return candidates only, callers must do exact checks.
+class MonstersIndex final
+{
+public:
+	MonstersIndex();
+	~MonstersIndex();
+
+	void AddMonster( EntityId monster_id, MonsterBase& monster );
+	void RemoveMonster( EntityId monster_id );
+
+	// Moves monster to new cell, if it moves to other cell since last update.
+	void UpdateMonster( EntityId monster_id );
+
+	// Func( EntityId monster_id, MonsterBase& monster ).
+	// Fetches monsters with centers inside square with center "pos" and half-size "radius".
+	template<class Func>
+	void ProcessMonstersInRadius(
+		const m_Vec2& pos, float radius,
+		const Func& func ) const;
+
+	// Fetches monsters with centers at distance less, than "radius", from line segment.
+	template<class Func>
+	void ProcessMonstersNearSegment(
+		const m_Vec2& from, const m_Vec2& to, float radius,
+		const Func& func ) const;
+
+private:
+	struct CellElement
+	{
+		EntityId monster_id;
+		MonsterBase* monster;
+	};
+
+	typedef std::vector<CellElement> Cell;
+
+	struct MonsterInfo
+	{
+		MonsterBase* monster;
+		unsigned int cell;
+	};
+
+	static constexpr unsigned int c_outside_map_cell= MapData::c_map_size * MapData::c_map_size;
+
+private:
+	static unsigned int GetCellForPosition( const m_Vec2& pos );
+	void RemoveFromCell( EntityId monster_id, unsigned int cell );
+
+	template<class Func>
+	void ProcessCell( unsigned int cell, const Func& func ) const;
+
+private:
+	std::unordered_map< EntityId, MonsterInfo > monsters_;
+
+	// Map cells and one cell for monsters outside map.
+	Cell cells_[ MapData::c_map_size * MapData::c_map_size + 1u ];
+};
+
+} // namespace PanzerChasm
@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#include "monsters_index.hpp"
+
+namespace PanzerChasm
+{
+
+template<class Func>
+void MonstersIndex::ProcessMonstersInRadius(
+	const m_Vec2& pos, const float radius,
+	const Func& func ) const
+{
+	const int x_start= std::max( static_cast<int>( std::floor( pos.x - radius ) ), 0 );
+	const int x_end  = std::min( static_cast<int>( std::floor( pos.x + radius ) ), int(MapData::c_map_size - 1u) );
+	const int y_start= std::max( static_cast<int>( std::floor( pos.y - radius ) ), 0 );
+	const int y_end  = std::min( static_cast<int>( std::floor( pos.y + radius ) ), int(MapData::c_map_size - 1u) );
+
+	for( int y= y_start; y <= y_end; y++ )
+	for( int x= x_start; x <= x_end; x++ )
+		ProcessCell( x + y * int(MapData::c_map_size), func );
+
+	ProcessCell( c_outside_map_cell, func );
+}
+
+template<class Func>
+void MonstersIndex::ProcessMonstersNearSegment(
+	const m_Vec2& from, const m_Vec2& to, const float radius,
+	const Func& func ) const
+{
+	const float segment_x_min= std::min( from.x, to.x );
+	const float segment_x_max= std::max( from.x, to.x );
+	const float dx= to.x - from.x;
+	const float dy_dx= std::abs( dx ) > 0.001f ? ( to.y - from.y ) / dx : 0.0f;
+
+	const int x_start= std::max( static_cast<int>( std::floor( segment_x_min - radius ) ), 0 );
+	const int x_end  = std::min( static_cast<int>( std::floor( segment_x_max + radius ) ), int(MapData::c_map_size - 1u) );
+
+	for( int x= x_start; x <= x_end; x++ )
+	{
+		// Find part of segment, which is closer, than radius, to this column and fetch cells near this part.
+		float column_y_min, column_y_max;
+		if( std::abs( dx ) > 0.001f )
+		{
+			const float column_x_min= std::max( float(x     ) - radius, segment_x_min );
+			const float column_x_max= std::min( float(x + 1) + radius, segment_x_max );
+			const float y0= from.y + dy_dx * ( column_x_min - from.x );
+			const float y1= from.y + dy_dx * ( column_x_max - from.x );
+			column_y_min= std::min( y0, y1 );
+			column_y_max= std::max( y0, y1 );
+		}
+		else
+		{
+			column_y_min= std::min( from.y, to.y );
+			column_y_max= std::max( from.y, to.y );
+		}
+
+		const int y_start= std::max( static_cast<int>( std::floor( column_y_min - radius ) ), 0 );
+		const int y_end  = std::min( static_cast<int>( std::floor( column_y_max + radius ) ), int(MapData::c_map_size - 1u) );
+		for( int y= y_start; y <= y_end; y++ )
+			ProcessCell( x + y * int(MapData::c_map_size), func );
+	}
+
+	ProcessCell( c_outside_map_cell, func );
+}
+
+template<class Func>
+void MonstersIndex::ProcessCell( const unsigned int cell, const Func& func ) const
+{
+	for( const CellElement& element : cells_[ cell ] )
+		func( element.monster_id, *element.monster );
+}
+
+} // namespace PanzerChasm
@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cmath>
+
+#include "../assert.hpp"
+#include "../game_constants.hpp"
+#include "a_code.hpp"
+#include "collision_index.inl"
+#include "player.hpp"
+
+#include "navigation.hpp"
+
+namespace PanzerChasm
+{
+
+constexpr unsigned int Navigation::c_cells_count;
+constexpr unsigned short Navigation::c_unreachable_distance;
+constexpr unsigned char Navigation::c_open_x_plus;
+constexpr unsigned char Navigation::c_open_x_minus;
+constexpr unsigned char Navigation::c_open_y_plus;
+constexpr unsigned char Navigation::c_open_y_minus;
+constexpr unsigned char Navigation::c_occupied;
+
+static unsigned int GetCellForPosition( const m_Vec2& pos )
+{
+	const int x= static_cast<int>( std::floor( pos.x ) );
+	const int y= static_cast<int>( std::floor( pos.y ) );
+	if( x < 0 || x >= int(MapData::c_map_size) ||
+		y < 0 || y >= int(MapData::c_map_size) )
+		return ~0u;
+
+	return static_cast<unsigned int>( x + y * int(MapData::c_map_size) );
+}
+
+static m_Vec2 GetCellCenter( const unsigned int cell )
+{
+	return m_Vec2( float( cell % MapData::c_map_size ) + 0.5f, float( cell / MapData::c_map_size ) + 0.5f );
+}
+
+static bool SegmentsIntersect( const m_Vec2& a0, const m_Vec2& a1, const m_Vec2& b0, const m_Vec2& b1 )
+{
+	const m_Vec2 a_vec= a1 - a0;
+	const m_Vec2 b_vec= b1 - b0;
+
+	const float b0_side= mVec2Cross( b0 - a0, a_vec );
+	const float b1_side= mVec2Cross( b1 - a0, a_vec );
+	if( ( b0_side > 0.0f && b1_side > 0.0f ) || ( b0_side < 0.0f && b1_side < 0.0f ) )
+		return false;
+
+	const float a0_side= mVec2Cross( a0 - b0, b_vec );
+	const float a1_side= mVec2Cross( a1 - b0, b_vec );
+	if( ( a0_side > 0.0f && a1_side > 0.0f ) || ( a0_side < 0.0f && a1_side < 0.0f ) )
+		return false;
+
+	if( b0_side == 0.0f && b1_side == 0.0f )
+	{
+		// Collinear segments. Check bounding boxes overlapping.
+		return
+			std::min( a0.x, a1.x ) <= std::max( b0.x, b1.x ) && std::min( b0.x, b1.x ) <= std::max( a0.x, a1.x ) &&
+			std::min( a0.y, a1.y ) <= std::max( b0.y, b1.y ) && std::min( b0.y, b1.y ) <= std::max( a0.y, a1.y );
+	}
+
+	return true;
+}
+
+Navigation::Navigation( const MapData& map_data, const CollisionIndex& collision_index )
+	: map_data_(map_data)
+	, collision_index_(collision_index)
+	, dynamic_walls_( map_data.dynamic_walls.size() )
+	, models_( map_data.static_models.size() )
+	, cell_is_dirty_( c_cells_count, true )
+{
+	// Real state of dynamic walls and models is unknown here. Calculate passability of all cells at first update.
+	dirty_cells_.resize( c_cells_count );
+	for( unsigned int i= 0u; i < c_cells_count; i++ )
+		dirty_cells_[i]= static_cast<unsigned short>(i);
+
+	std::fill( passability_, passability_ + c_cells_count, 0u );
+}
+
+Navigation::~Navigation()
+{}
+
+void Navigation::UpdateDynamicWall(
+	const unsigned int wall_index,
+	const m_Vec2& vert_pos0, const m_Vec2& vert_pos1,
+	const float z,
+	const unsigned char texture_id )
+{
+	PC_ASSERT( wall_index < dynamic_walls_.size() );
+	DynamicWallState& wall= dynamic_walls_[ wall_index ];
+
+	// Same conditions, as in collisions with map. Raised walls do not block monsters.
+	const bool blocking=
+		!map_data_.walls_textures[ texture_id ].gso[0] &&
+		vert_pos0 != vert_pos1 &&
+		z < GameConstants::player_height;
+
+	if( blocking == wall.blocking && vert_pos0 == wall.vert_pos[0] && vert_pos1 == wall.vert_pos[1] )
+		return;
+
+	if( wall.blocking )
+		MarkCellsDirty(
+			m_Vec2( std::min( wall.vert_pos[0].x, wall.vert_pos[1].x ), std::min( wall.vert_pos[0].y, wall.vert_pos[1].y ) ),
+			m_Vec2( std::max( wall.vert_pos[0].x, wall.vert_pos[1].x ), std::max( wall.vert_pos[0].y, wall.vert_pos[1].y ) ) );
+	if( blocking )
+		MarkCellsDirty(
+			m_Vec2( std::min( vert_pos0.x, vert_pos1.x ), std::min( vert_pos0.y, vert_pos1.y ) ),
+			m_Vec2( std::max( vert_pos0.x, vert_pos1.x ), std::max( vert_pos0.y, vert_pos1.y ) ) );
+
+	wall.vert_pos[0]= vert_pos0;
+	wall.vert_pos[1]= vert_pos1;
+	wall.blocking= blocking;
+}
+
+void Navigation::UpdateModel( const unsigned int model_index, const m_Vec3& pos, const unsigned char model_id )
+{
+	PC_ASSERT( model_index < models_.size() );
+	ModelState& model= models_[ model_index ];
+
+	float radius= 0.0f;
+	bool blocking= false;
+	if( model_id < map_data_.models_description.size() )
+	{
+		const MapData::ModelDescription& model_description= map_data_.models_description[ model_id ];
+		const ACode a_code= static_cast<ACode>( model_description.ac );
+		radius= model_description.radius;
+
+		if( radius > 0.0f && !( a_code >= ACode::RedKey && a_code <= ACode::BlueKey ) )
+		{
+			// Low models may be stepped over, high models are above heads.
+			const Model& model_geometry= map_data_.models[ model_id ];
+			blocking=
+				model_geometry.z_max + pos.z > GameConstants::z_pull_distance &&
+				model_geometry.z_min + pos.z < GameConstants::player_height;
+		}
+	}
+
+	if( blocking == model.blocking && radius == model.radius && pos.xy() == model.pos )
+		return;
+
+	if( model.blocking )
+		MarkCellsDirty(
+			model.pos - m_Vec2( model.radius, model.radius ),
+			model.pos + m_Vec2( model.radius, model.radius ) );
+	if( blocking )
+		MarkCellsDirty(
+			pos.xy() - m_Vec2( radius, radius ),
+			pos.xy() + m_Vec2( radius, radius ) );
+
+	model.pos= pos.xy();
+	model.radius= radius;
+	model.blocking= blocking;
+}
+
+void Navigation::Update( const EntitiesContainer<PlayerPtr>& players )
+{
+	if( RecalculateDirtyCells() )
+		passability_revision_++;
+
+	for( PlayerField& field : players_fields_ )
+		field.updated= false;
+
+	for( const EntitiesContainer<PlayerPtr>::value_type& player_value : players )
+	{
+		PC_ASSERT( player_value.second != nullptr );
+
+		PlayerField* field= nullptr;
+		for( PlayerField& f : players_fields_ )
+		{
+			if( f.player_id == player_value.first )
+			{
+				field= &f;
+				break;
+			}
+		}
+
+		const unsigned int target_cell= GetCellForPosition( player_value.second->Position().xy() );
+		if( field == nullptr )
+		{
+			players_fields_.emplace_back();
+			field= &players_fields_.back();
+			field->player_id= player_value.first;
+			field->distances.resize( c_cells_count );
+		}
+		else if( field->target_cell == target_cell && field->passability_revision == passability_revision_ )
+		{
+			field->updated= true;
+			continue;
+		}
+
+		field->target_cell= target_cell;
+		field->passability_revision= passability_revision_;
+		field->updated= true;
+		BuildField( *field );
+	}
+
+	players_fields_.erase(
+		std::remove_if(
+			players_fields_.begin(), players_fields_.end(),
+			[]( const PlayerField& field ) { return !field.updated; } ),
+		players_fields_.end() );
+}
+
+bool Navigation::GetMoveDirection( const EntityId player_id, const m_Vec2& from, const m_Vec2& to, m_Vec2& out_direction ) const
+{
+	const PlayerField* field= nullptr;
+	for( const PlayerField& f : players_fields_ )
+	{
+		if( f.player_id == player_id )
+		{
+			field= &f;
+			break;
+		}
+	}
+	if( field == nullptr )
+		return false;
+
+	// Field leads to other place.
+	if( field->target_cell == ~0u || GetCellForPosition( to ) != field->target_cell )
+		return false;
+
+	const unsigned int cell= GetCellForPosition( from );
+	if( cell == ~0u || cell == field->target_cell )
+		return false;
+
+	const unsigned short distance= field->distances[ cell ];
+	if( distance == c_unreachable_distance )
+		return false;
+
+	// Select neighbor, nearest to target.
+	unsigned short best_distance= distance;
+	int best_dx= 0, best_dy= 0;
+	for( int dy= -1; dy <= 1; dy++ )
+	for( int dx= -1; dx <= 1; dx++ )
+	{
+		if( ( dx == 0 && dy == 0 ) || !CanStep( cell, dx, dy ) )
+			continue;
+
+		const unsigned short neighbor_distance= field->distances[ int(cell) + dx + dy * int(MapData::c_map_size) ];
+		if( neighbor_distance < best_distance )
+		{
+			best_distance= neighbor_distance;
+			best_dx= dx;
+			best_dy= dy;
+		}
+	}
+
+	if( best_distance == distance )
+		return false;
+
+	// Go directly to target, if step in direction of target is as good, as best step.
+	const m_Vec2 vec_to_target= to - from;
+	const float vec_to_target_length= vec_to_target.Length();
+	if( vec_to_target_length > 0.0f )
+	{
+		const m_Vec2 direct_step= vec_to_target / vec_to_target_length;
+		const int direct_dx= static_cast<int>( std::round( direct_step.x ) );
+		const int direct_dy= static_cast<int>( std::round( direct_step.y ) );
+		if( ( direct_dx != 0 || direct_dy != 0 ) &&
+			CanStep( cell, direct_dx, direct_dy ) &&
+			field->distances[ int(cell) + direct_dx + direct_dy * int(MapData::c_map_size) ] == best_distance )
+		{
+			out_direction= direct_step;
+			return true;
+		}
+	}
+
+	// Go to center of best neighbor cell, this keeps monsters away from corners.
+	const m_Vec2 vec_to_neighbor=
+		GetCellCenter( static_cast<unsigned int>( int(cell) + best_dx + best_dy * int(MapData::c_map_size) ) ) - from;
+	const float vec_to_neighbor_length= vec_to_neighbor.Length();
+	if( vec_to_neighbor_length <= 0.0f )
+		return false;
+
+	out_direction= vec_to_neighbor / vec_to_neighbor_length;
+	return true;
+}
+
+void Navigation::MarkCellsDirty( const m_Vec2& bb_min, const m_Vec2& bb_max )
+{
+	// Extend box by one cell, because passages between cells are calculated from cells centers.
+	const int x_start= std::max( static_cast<int>( std::floor( bb_min.x ) ) - 1, 0 );
+	const int x_end  = std::min( static_cast<int>( std::floor( bb_max.x ) ) + 1, int(MapData::c_map_size - 1u) );
+	const int y_start= std::max( static_cast<int>( std::floor( bb_min.y ) ) - 1, 0 );
+	const int y_end  = std::min( static_cast<int>( std::floor( bb_max.y ) ) + 1, int(MapData::c_map_size - 1u) );
+
+	for( int y= y_start; y <= y_end; y++ )
+	for( int x= x_start; x <= x_end; x++ )
+	{
+		const unsigned int cell= static_cast<unsigned int>( x + y * int(MapData::c_map_size) );
+		if( !cell_is_dirty_[ cell ] )
+		{
+			cell_is_dirty_[ cell ]= true;
+			dirty_cells_.push_back( static_cast<unsigned short>(cell) );
+		}
+	}
+}
+
+bool Navigation::RecalculateDirtyCells()
+{
+	const unsigned int c_map_size= MapData::c_map_size;
+
+	bool changed= false;
+	for( const unsigned short cell : dirty_cells_ )
+	{
+		const unsigned int x= cell % c_map_size;
+		const unsigned int y= cell / c_map_size;
+
+		unsigned char passability= 0u;
+		if( x + 1u < c_map_size && IsPassageOpen( x, y, x + 1u, y ) )
+			passability|= c_open_x_plus;
+		if( x > 0u && IsPassageOpen( x - 1u, y, x, y ) )
+			passability|= c_open_x_minus;
+		if( y + 1u < c_map_size && IsPassageOpen( x, y, x, y + 1u ) )
+			passability|= c_open_y_plus;
+		if( y > 0u && IsPassageOpen( x, y - 1u, x, y ) )
+			passability|= c_open_y_minus;
+		if( IsCellOccupied( x, y ) )
+			passability|= c_occupied;
+
+		if( passability != passability_[ cell ] )
+		{
+			passability_[ cell ]= passability;
+			changed= true;
+		}
+
+		// Keep passages symmetric - update opposite flags of neighbors.
+		const auto set_flag=
+		[&]( const unsigned int neighbor_cell, const unsigned char flag, const bool open )
+		{
+			unsigned char& neighbor_passability= passability_[ neighbor_cell ];
+			const unsigned char new_passability= open ? ( neighbor_passability | flag ) : ( neighbor_passability & ~flag );
+			if( new_passability != neighbor_passability )
+			{
+				neighbor_passability= new_passability;
+				changed= true;
+			}
+		};
+		if( x + 1u < c_map_size )
+			set_flag( cell + 1u, c_open_x_minus, ( passability & c_open_x_plus ) != 0u );
+		if( x > 0u )
+			set_flag( cell - 1u, c_open_x_plus, ( passability & c_open_x_minus ) != 0u );
+		if( y + 1u < c_map_size )
+			set_flag( cell + c_map_size, c_open_y_minus, ( passability & c_open_y_plus ) != 0u );
+		if( y > 0u )
+			set_flag( cell - c_map_size, c_open_y_plus, ( passability & c_open_y_minus ) != 0u );
+
+		cell_is_dirty_[ cell ]= false;
+	}
+
+	dirty_cells_.clear();
+	return changed;
+}
+
+bool Navigation::IsPassageOpen( const unsigned int x0, const unsigned int y0, const unsigned int x1, const unsigned int y1 ) const
+{
+	const m_Vec2 from( float(x0) + 0.5f, float(y0) + 0.5f );
+	const m_Vec2 to  ( float(x1) + 0.5f, float(y1) + 0.5f );
+
+	bool open= true;
+	collision_index_.ProcessElementsInRadius(
+		( from + to ) * 0.5f, 0.5f,
+		[&]( const MapData::IndexElement& element )
+		{
+			if( !open )
+				return;
+
+			if( element.type == MapData::IndexElement::StaticWall )
+			{
+				PC_ASSERT( element.index < map_data_.static_walls.size() );
+				const MapData::Wall& wall= map_data_.static_walls[ element.index ];
+				if( map_data_.walls_textures[ wall.texture_id ].gso[0] )
+					return;
+
+				if( SegmentsIntersect( from, to, wall.vert_pos[0], wall.vert_pos[1] ) )
+					open= false;
+			}
+			else if( element.type == MapData::IndexElement::DynamicWall )
+			{
+				PC_ASSERT( element.index < dynamic_walls_.size() );
+				const DynamicWallState& wall= dynamic_walls_[ element.index ];
+				if( wall.blocking && SegmentsIntersect( from, to, wall.vert_pos[0], wall.vert_pos[1] ) )
+					open= false;
+			}
+		} );
+
+	return open;
+}
+
+bool Navigation::IsCellOccupied( const unsigned int x, const unsigned int y ) const
+{
+	const m_Vec2 center( float(x) + 0.5f, float(y) + 0.5f );
+
+	bool occupied= false;
+	collision_index_.ProcessElementsInRadius(
+		center, 0.0f,
+		[&]( const MapData::IndexElement& element )
+		{
+			if( element.type != MapData::IndexElement::StaticModel )
+				return;
+
+			PC_ASSERT( element.index < models_.size() );
+			const ModelState& model= models_[ element.index ];
+			if( model.blocking && ( model.pos - center ).SquareLength() < model.radius * model.radius )
+				occupied= true;
+		} );
+
+	return occupied;
+}
+
+bool Navigation::CanStep( const unsigned int cell, const int dx, const int dy ) const
+{
+	const unsigned int c_map_size= MapData::c_map_size;
+	const unsigned int x= cell % c_map_size;
+	const unsigned int y= cell / c_map_size;
+
+	const auto can_step_straight=
+	[&]( const unsigned int from_cell, const int step_dx, const int step_dy ) -> bool
+	{
+		unsigned char flag;
+		unsigned int to_cell;
+		if( step_dx > 0 ) { flag= c_open_x_plus ; to_cell= from_cell + 1u; }
+		else if( step_dx < 0 ) { flag= c_open_x_minus; to_cell= from_cell - 1u; }
+		else if( step_dy > 0 ) { flag= c_open_y_plus ; to_cell= from_cell + c_map_size; }
+		else { flag= c_open_y_minus; to_cell= from_cell - c_map_size; }
+
+		// Passage flags are not set for passages outside map.
+		return ( passability_[ from_cell ] & flag ) != 0u && ( passability_[ to_cell ] & c_occupied ) == 0u;
+	};
+
+	if( dx != 0 && dy != 0 )
+	{
+		if( ( dx < 0 && x == 0u ) || ( dx > 0 && x + 1u >= c_map_size ) ||
+			( dy < 0 && y == 0u ) || ( dy > 0 && y + 1u >= c_map_size ) )
+			return false;
+
+		// Diagonal step is possible only if both ways around corner are free.
+		const unsigned int x_neighbor= static_cast<unsigned int>( int(cell) + dx );
+		const unsigned int y_neighbor= static_cast<unsigned int>( int(cell) + dy * int(c_map_size) );
+		return
+			can_step_straight( cell, dx, 0 ) && can_step_straight( x_neighbor, 0, dy ) &&
+			can_step_straight( cell, 0, dy ) && can_step_straight( y_neighbor, dx, 0 );
+	}
+
+	return can_step_straight( cell, dx, dy );
+}
+
+void Navigation::BuildField( PlayerField& field )
+{
+	std::fill( field.distances.begin(), field.distances.end(), c_unreachable_distance );
+	if( field.target_cell == ~0u )
+		return;
+
+	const unsigned int c_map_size= MapData::c_map_size;
+
+	// Breadth-first search from target cell. Target cell may be occupied - player can stand near model.
+	unsigned int queue_begin= 0u, queue_end= 0u;
+	field.distances[ field.target_cell ]= 0u;
+	bfs_queue_[ queue_end++ ]= static_cast<unsigned short>( field.target_cell );
+
+	while( queue_begin < queue_end )
+	{
+		const unsigned int cell= bfs_queue_[ queue_begin++ ];
+		const unsigned char passability= passability_[ cell ];
+		const unsigned short next_distance= static_cast<unsigned short>( field.distances[ cell ] + 1u );
+
+		const auto visit=
+		[&]( const unsigned char flag, const unsigned int neighbor_cell )
+		{
+			if( ( passability & flag ) == 0u ||
+				( passability_[ neighbor_cell ] & c_occupied ) != 0u ||
+				field.distances[ neighbor_cell ] != c_unreachable_distance )
+				return;
+
+			field.distances[ neighbor_cell ]= next_distance;
+			bfs_queue_[ queue_end++ ]= static_cast<unsigned short>( neighbor_cell );
+		};
+
+		visit( c_open_x_plus , cell + 1u );
+		visit( c_open_x_minus, cell - 1u );
+		visit( c_open_y_plus , cell + c_map_size );
+		visit( c_open_y_minus, cell - c_map_size );
+	}
+}
+
+} // namespace PanzerChasm
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+
+#include <vec.hpp>
+
+#include "../entities_container.hpp"
+#include "../map_loader.hpp"
+#include "fwd.hpp"
+
+namespace PanzerChasm
+{
+
+class CollisionIndex;
+
+// Navigation for monsters movement.
+// Map cells are nodes of walkability grid. Passage between neighbor cells is closed, if line between cells centers
+// crosses wall, not passable for player. Cell is occupied, if its center is covered by solid model.
+// For each player distance field ( BFS from player cell ) is built. All monsters, chasing same player, share one field.
+// Fields are rebuilt only if player changes cell, or if passability of some cells changes.
+class Navigation final
+{
+public:
+	Navigation( const MapData& map_data, const CollisionIndex& collision_index );
+	~Navigation();
+
+	// Call it, when wall or model is changed. Collision index must be already updated.
+	// Marks cells near old and new element position for passability recalculation, if element really changed.
+	void UpdateDynamicWall( unsigned int wall_index, const m_Vec2& vert_pos0, const m_Vec2& vert_pos1, float z, unsigned char texture_id );
+	void UpdateModel( unsigned int model_index, const m_Vec3& pos, unsigned char model_id );
+
+	// Recalculates passability of changed cells. Rebuilds fields of players, if needed, removes fields of despawned players.
+	void Update( const EntitiesContainer<PlayerPtr>& players );
+
+	// Returns direction for movement from "from" to "to" along shortest path to player.
+	// Returns false, if "to" is not in cell of player, or if path does not exist, or if "from" is in cell of player.
+	// Thread-safe.
+	bool GetMoveDirection( EntityId player_id, const m_Vec2& from, const m_Vec2& to, m_Vec2& out_direction ) const;
+
+private:
+	struct DynamicWallState
+	{
+		m_Vec2 vert_pos[2];
+		bool blocking= false;
+	};
+
+	struct ModelState
+	{
+		m_Vec2 pos;
+		float radius= 0.0f;
+		bool blocking= false;
+	};
+
+	struct PlayerField
+	{
+		EntityId player_id;
+		unsigned int target_cell;
+		unsigned int passability_revision;
+		bool updated; // Temporary flag for removing of fields of despawned players.
+
+		std::vector<unsigned short> distances; // Steps count to target cell.
+	};
+
+	static constexpr unsigned int c_cells_count= MapData::c_map_size * MapData::c_map_size;
+	static constexpr unsigned short c_unreachable_distance= 0xFFFFu;
+
+	// Cell passability flags.
+	static constexpr unsigned char c_open_x_plus = 1u << 0u;
+	static constexpr unsigned char c_open_x_minus= 1u << 1u;
+	static constexpr unsigned char c_open_y_plus = 1u << 2u;
+	static constexpr unsigned char c_open_y_minus= 1u << 3u;
+	static constexpr unsigned char c_occupied= 1u << 4u;
+
+private:
+	void MarkCellsDirty( const m_Vec2& bb_min, const m_Vec2& bb_max );
+	// Returns true, if passability of some cells changed.
+	bool RecalculateDirtyCells();
+	bool IsPassageOpen( unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1 ) const;
+	bool IsCellOccupied( unsigned int x, unsigned int y ) const;
+	bool CanStep( unsigned int cell, int dx, int dy ) const;
+	void BuildField( PlayerField& field );
+
+private:
+	const MapData& map_data_;
+	const CollisionIndex& collision_index_;
+
+	std::vector<DynamicWallState> dynamic_walls_;
+	std::vector<ModelState> models_;
+
+	// Changed cells. Passability of this cells must be recalculated.
+	std::vector<unsigned short> dirty_cells_;
+	std::vector<bool> cell_is_dirty_;
+
+	// Incremented, when passability changes.
+	unsigned int passability_revision_= 0u;
+
+	std::vector<PlayerField> players_fields_;
+
+	unsigned short bfs_queue_[ c_cells_count ]; // Temporary storage.
+	unsigned char passability_[ c_cells_count ];
+};
+
+} // namespace PanzerChasm
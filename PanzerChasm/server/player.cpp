@@ -423,6 +423,7 @@ void Player::BuildStateMessage( Messages::MonsterState& out_message ) const
 	out_message.is_fully_dead= IsFullyDead();
 	out_message.is_invisible= inviible_in_this_moment_;
 	out_message.color= GetColor();
+	out_message.snapshot_sequence= 0u;
 }
 
 void Player::SetRandomGenerator( const LongRandPtr& random_generator )
@@ -0,0 +1,68 @@
+#include <algorithm>
+
+#include "../game_constants.hpp"
+#include "visibility_matrix.hpp"
+
+#include "player_interest.hpp"
+
+namespace PanzerChasm
+{
+
+// Visible entities nearer, than this distance, are updated each snapshot. Farther visible entities are updated with
+// rate, inversely proportional to distance.
+static const float g_full_update_rate_distance= 24.0f;
+// Update priority of entities, hidden by static walls.
+static const float g_hidden_entities_priority= 1.0f / 8.0f;
+// Sound volume falls linearly with distance. On this distance loudest sounds have volume about 1/12.
+static const float g_max_audible_distance= 48.0f;
+
+static bool IsInsideWallsHeight( const m_Vec3& pos )
+{
+	return pos.z >= 0.0f && pos.z <= GameConstants::walls_height;
+}
+
+PlayerInterest::PlayerInterest()
+	: visibility_matrix_(nullptr)
+	, player_pos_( 0.0f, 0.0f, 0.0f )
+{}
+
+// If player is outside walls height range ( noclip, for example ), everything is relevant.
+PlayerInterest::PlayerInterest( const VisibilityMatrix& visibility_matrix, const m_Vec3& player_pos )
+	: visibility_matrix_( IsInsideWallsHeight( player_pos ) ? &visibility_matrix : nullptr )
+	, player_pos_( player_pos )
+{}
+
+PlayerInterest::~PlayerInterest()
+{}
+
+float PlayerInterest::GetUpdatePriority( const m_Vec3& pos ) const
+{
+	if( visibility_matrix_ == nullptr || !IsInsideWallsHeight( pos ) )
+		return 1.0f;
+
+	if( !visibility_matrix_->MayBeVisible( player_pos_.xy(), pos.xy() ) )
+		return g_hidden_entities_priority;
+
+	const float distance= ( pos.xy() - player_pos_.xy() ).Length();
+	if( distance <= g_full_update_rate_distance )
+		return 1.0f;
+
+	return std::max( g_full_update_rate_distance / distance, g_hidden_entities_priority );
+}
+
+bool PlayerInterest::MayBeVisible( const m_Vec3& pos ) const
+{
+	return
+		visibility_matrix_ == nullptr ||
+		!IsInsideWallsHeight( pos ) ||
+		visibility_matrix_->MayBeVisible( player_pos_.xy(), pos.xy() );
+}
+
+bool PlayerInterest::IsAudible( const m_Vec3& pos ) const
+{
+	return
+		visibility_matrix_ == nullptr ||
+		( pos.xy() - player_pos_.xy() ).SquareLength() <= g_max_audible_distance * g_max_audible_distance;
+}
+
+} // namespace PanzerChasm
@@ -0,0 +1,34 @@
+#pragma once
+#include <vec.hpp>
+
+namespace PanzerChasm
+{
+
+class VisibilityMatrix;
+
+// Relevance of map entities for one player. Used for reducing of update messages, sent to client of this player.
+// Near entities, which may be visible, have full update priority. Far and hidden entities have lower priority,
+// so, they are updated with lower rate, but not never.
+// Visibility matrix is valid only for points inside walls height range, so, points outside it are always relevant.
+class PlayerInterest final
+{
+public:
+	// Everything is relevant for this interest.
+	PlayerInterest();
+	PlayerInterest( const VisibilityMatrix& visibility_matrix, const m_Vec3& player_pos );
+	~PlayerInterest();
+
+	// Returns priority in range ( 0; 1 ]. Entity with priority p should be updated once per 1 / p snapshots.
+	float GetUpdatePriority( const m_Vec3& pos ) const;
+
+	// For one-time effects. Effects, which player can not see, are not sent.
+	bool MayBeVisible( const m_Vec3& pos ) const;
+	// For sounds. Sounds, which are too quiet for player, are not sent.
+	bool IsAudible( const m_Vec3& pos ) const;
+
+private:
+	const VisibilityMatrix* const visibility_matrix_;
+	const m_Vec3 player_pos_;
+};
+
+} // namespace PanzerChasm
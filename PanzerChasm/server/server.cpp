@@ -11,6 +11,11 @@
 namespace PanzerChasm
 {
 
+// Map loading progress for clients after each stage of map change. 255 is reserved for loading failure.
+static const unsigned char g_map_data_loaded_progress= 85u;
+static const unsigned char g_map_created_progress= 170u;
+static const unsigned char g_map_change_finished_progress= 254u;
+
 Server::ConnectedPlayer::ConnectedPlayer(
 	const IConnectionPtr& connection,
 	const GameResourcesConstPtr& game_resoruces,
@@ -33,6 +38,7 @@ Server::Server(
 	, text_message_callback_( std::bind( &Server::AddTextMessage, this, std::placeholders::_1 ) )
 	, last_tick_( Time::CurrentTime() )
 	, server_accumulated_time_( Time::FromSeconds(0) )
+	, map_change_thread_(1u)
 {
 	PC_ASSERT( game_resources_ != nullptr );
 	PC_ASSERT( map_loader_ != nullptr );
@@ -46,6 +52,7 @@ Server::Server(
 	commands->emplace( "keys", std::bind( &Server::GiveKeys, this ) );
 	commands->emplace( "chojin", std::bind( &Server::ToggleGodMode, this ) );
 	commands->emplace( "noclip", std::bind( &Server::ToggleNoclip, this ) );
+	commands->emplace( "sv_profile", std::bind( &TickProfiler::ProfileCommand, &tick_profiler_, std::placeholders::_1 ) );
 
 	commands_= std::move( commands );
 	commands_processor.RegisterCommands( commands_ );
@@ -64,6 +71,9 @@ void Server::Loop( bool paused )
 		return;
 	}
 
+	tick_profiler_.Loop();
+	const TickProfiler::ScopedTimer loop_timer( tick_profiler_, TickProfiler::Phase::ServerLoop );
+
 	// Accept new connections.
 	while( const IConnectionPtr connection= connections_listener_->GetNewConnection() )
 	{
@@ -160,17 +170,24 @@ void Server::Loop( bool paused )
 		current_player_= nullptr;
 	}
 
+	if( map_change_job_ != nullptr && map_change_job_->finished )
+		FinishMapChange();
+
 	// Do server logic
 	UpdateTimes();
 
-	// Make several map ticks.
-	for( unsigned int t= 0u; t < map_tick_count_; t++ )
+	// Make several map ticks. Do not tick old map, while new map is loading.
+	for( unsigned int t= 0u; t < map_tick_count_ && map_change_job_ == nullptr; t++ )
 	{
 		// Process map inner logic
 		if( map_ != nullptr )
-			map_->Tick( map_ticks_[t].end, map_ticks_[t].duration );
+		{
+			const TickProfiler::ScopedTimer timer( tick_profiler_, TickProfiler::Phase::MapTick );
+			map_->Tick( map_ticks_[t].end, map_ticks_[t].duration, tick_profiler_ );
+		}
 
 		// Process players position
+		const TickProfiler::ScopedTimer players_timer( tick_profiler_, TickProfiler::Phase::PlayersPositions );
 		for( const ConnectedPlayerPtr& connected_player : players_ )
 		{
 			if( map_ != nullptr && !connected_player->player->IsNoclip() )
@@ -185,36 +202,62 @@ void Server::Loop( bool paused )
 	Messages::ServerState server_state_message;
 	BuildServerStateMessage( server_state_message );
 
-	for( const ConnectedPlayerPtr& connected_player : players_ )
+	// Notify clients about map loading start and about each finished loading stage.
+	bool send_map_loading_progress= false;
+	Messages::MapLoadingProgress map_loading_progress_message;
+	if( map_change_job_ != nullptr )
 	{
-		MessagesSender& messages_sender= connected_player->connection_info.messages_sender;
+		map_loading_progress_message.progress= map_change_job_->progress;
+		send_map_loading_progress= int(map_loading_progress_message.progress) != map_change_progress_sent_;
+		map_change_progress_sent_= map_loading_progress_message.progress;
+	}
+
+	{
+		const TickProfiler::ScopedTimer send_timer( tick_profiler_, TickProfiler::Phase::SendUpdateMessages );
+
 		if( map_ != nullptr )
-			map_->SendUpdateMessages( messages_sender );
-
-		Messages::PlayerPosition position_msg;
-		Messages::PlayerState state_msg;
-		Messages::PlayerWeapon weapon_msg;
-		Messages::PlayerSpawn spawn_msg;
-		connected_player->player->BuildPositionMessage( position_msg );
-		connected_player->player->BuildStateMessage( state_msg );
-		state_msg.index= &connected_player - players_.data();
-		connected_player->player->BuildWeaponMessage( weapon_msg );
-
-		if( connected_player->player->BuildSpawnMessage( spawn_msg ) )
 		{
-			spawn_msg.player_monster_id= connected_player->player_monster_id;
-			messages_sender.SendUnreliableMessage( spawn_msg );
+			snapshot_sequence_++;
+			map_->UpdateSnapshot( snapshot_sequence_ );
 		}
 
-		for( const Messages::DynamicTextMessage& message : text_massages_ )
-			messages_sender.SendReliableMessage( message ); // TODO - maybe unreliable?
+		for( const ConnectedPlayerPtr& connected_player : players_ )
+		{
+			MessagesSender& messages_sender= connected_player->connection_info.messages_sender;
+			if( map_ != nullptr )
+				map_->SendUpdateMessages(
+					messages_sender,
+					connected_player->player_monster_id,
+					connected_player->snapshots_state );
+
+			Messages::PlayerPosition position_msg;
+			Messages::PlayerState state_msg;
+			Messages::PlayerWeapon weapon_msg;
+			Messages::PlayerSpawn spawn_msg;
+			connected_player->player->BuildPositionMessage( position_msg );
+			connected_player->player->BuildStateMessage( state_msg );
+			state_msg.index= &connected_player - players_.data();
+			connected_player->player->BuildWeaponMessage( weapon_msg );
+
+			if( connected_player->player->BuildSpawnMessage( spawn_msg ) )
+			{
+				spawn_msg.player_monster_id= connected_player->player_monster_id;
+				messages_sender.SendUnreliableMessage( spawn_msg );
+			}
 
-		messages_sender.SendUnreliableMessage( position_msg );
-		messages_sender.SendUnreliableMessage( state_msg );
-		messages_sender.SendUnreliableMessage( weapon_msg );
-		messages_sender.SendUnreliableMessage( server_state_message );
-		connected_player->player->SendInternalMessages( messages_sender );
-		messages_sender.Flush();
+			for( const Messages::DynamicTextMessage& message : text_massages_ )
+				messages_sender.SendReliableMessage( message ); // TODO - maybe unreliable?
+
+			if( send_map_loading_progress )
+				messages_sender.SendReliableMessage( map_loading_progress_message );
+
+			messages_sender.SendUnreliableMessage( position_msg );
+			messages_sender.SendUnreliableMessage( state_msg );
+			messages_sender.SendUnreliableMessage( weapon_msg );
+			messages_sender.SendUnreliableMessage( server_state_message );
+			connected_player->player->SendInternalMessages( messages_sender );
+			messages_sender.Flush();
+		}
 	}
 
 	if( map_ != nullptr )
@@ -222,16 +265,18 @@ void Server::Loop( bool paused )
 
 	text_massages_.clear();
 
-	// Change map, if needed at end of this loop
+	// Start map change, if needed at end of this loop
 	if( map_end_triggered_ )
 	{
 		map_end_triggered_= false;
 
 		if( map_ != nullptr &&
+			map_change_job_ == nullptr &&
 			current_map_data_ != nullptr &&
 			current_map_data_->number < 16 )
 		{
-			ChangeMap(
+			Log::Info( "Changing server map to ", current_map_data_->number + 1u );
+			StartMapChange(
 				current_map_data_->number + 1u,
 				map_ == nullptr ? Difficulty::Normal : map_->GetDifficulty(),
 				game_rules_,
@@ -264,48 +309,118 @@ bool Server::ChangeMap(
 	};
 
 	show_progress( 0.0f );
-	const MapDataConstPtr map_data= map_loader_->LoadMap( map_number );
 
-	if( map_data == nullptr )
+	StartMapChange( map_number, difficulty, game_rules, is_next_map_change );
+	map_change_thread_.WaitAll();
+
+	show_progress( 0.5f );
+
+	const bool changed= FinishMapChange();
+
+	show_progress( 1.0f );
+
+	return changed;
+}
+
+void Server::StartMapChange(
+	const unsigned int map_number,
+	const DifficultyType difficulty,
+	const GameRules game_rules,
+	const bool is_next_map_change )
+{
+	// Previous job may be still in progress. Just forget about it.
+	const MapChangeJobPtr job= std::make_shared<MapChangeJob>();
+	job->map_number= map_number;
+	job->difficulty= difficulty;
+	job->game_rules= game_rules;
+	job->is_next_map_change= is_next_map_change;
+	job->map_start_time= server_accumulated_time_;
+
+	map_change_job_= job;
+	map_change_progress_sent_= -1;
+
+	// Copy all needed data for job, because server may be destroyed earlier, than job finished.
+	const MapLoaderPtr map_loader= map_loader_;
+	const GameResourcesConstPtr game_resources= game_resources_;
+	const Map::MapEndCallback map_end_callback= map_end_callback_;
+	const Map::TextMessageCallback text_message_callback= text_message_callback_;
+
+	map_change_thread_.AddTask(
+		[job, map_loader, game_resources, map_end_callback, text_message_callback]
+		{
+			job->map_data= map_loader->LoadMap( job->map_number );
+			if( job->map_data == nullptr )
+			{
+				job->finished= true;
+				return;
+			}
+			job->progress= g_map_data_loaded_progress;
+
+			job->map.reset(
+				new Map(
+					job->difficulty,
+					job->game_rules,
+					job->map_data,
+					game_resources,
+					job->map_start_time,
+					map_end_callback,
+					text_message_callback ) );
+			job->progress= g_map_created_progress;
+
+			job->finished= true;
+		} );
+}
+
+bool Server::FinishMapChange()
+{
+	PC_ASSERT( map_change_job_ != nullptr && map_change_job_->finished );
+
+	const MapChangeJobPtr job= std::move( map_change_job_ );
+
+	if( job->map == nullptr )
 	{
-		Log::Warning( "Can not load map ", map_number );
+		Log::Warning( "Can not load map ", job->map_number );
+
+		Messages::MapLoadingProgress message;
+		message.progress= 255u;
+		for( const ConnectedPlayerPtr& connected_player : players_ )
+		{
+			connected_player->connection_info.messages_sender.SendReliableMessage( message );
+			connected_player->connection_info.messages_sender.Flush();
+		}
+
 		return false;
 	}
 
-	show_progress( 0.5f );
-	game_rules_= game_rules;
-	map_changed_from_previous_map_= is_next_map_change;
-	current_map_data_= map_data;
-	map_.reset(
-		new Map(
-			difficulty,
-			game_rules,
-			map_data,
-			game_resources_,
-			server_accumulated_time_,
-			map_end_callback_,
-			text_message_callback_ ) );
+	game_rules_= job->game_rules;
+	map_changed_from_previous_map_= job->is_next_map_change;
+	current_map_data_= job->map_data;
+	map_= std::move( job->map );
 
 	map_end_triggered_= false;
 	join_first_client_with_existing_player_= false;
 
 	for( const ConnectedPlayerPtr& connected_player : players_ )
 	{
+		connected_player->snapshots_state.Reset();
 		connected_player->player->OnMapChange();
 
 		connected_player->player_monster_id=
 			map_->SpawnPlayer( connected_player->player );
 	}
 
-	show_progress( 0.666f );
+	Messages::MapLoadingProgress map_loading_progress_message;
+	map_loading_progress_message.progress= g_map_change_finished_progress;
+
 	for( const ConnectedPlayerPtr& connected_player : players_ )
 	{
 		Messages::MapChange message;
 		message.map_number= current_map_data_->number;
-		message.need_play_cutscene= game_rules == GameRules::SinglePlayer && map_changed_from_previous_map_;
+		message.need_play_cutscene= game_rules_ == GameRules::SinglePlayer && map_changed_from_previous_map_;
 
 		MessagesSender& messages_sender= connected_player->connection_info.messages_sender;
 
+		messages_sender.SendReliableMessage( map_loading_progress_message );
 		messages_sender.SendReliableMessage( message );
 		map_->SendMessagesForNewlyConnectedPlayer( messages_sender );
 
@@ -317,7 +432,7 @@ bool Server::ChangeMap(
 		messages_sender.Flush();
 	}
 
-	show_progress( 1.0f );
+	PrefetchNextMap();
 
 	return true;
 }
@@ -326,6 +441,7 @@ void Server::StopMap()
 {
 	Log::Info( "Stopping server map" );
 
+	map_change_job_= nullptr;
 	current_map_data_= 0u;
 	map_= nullptr;
 }
@@ -373,6 +489,8 @@ bool Server::Load( const SaveLoadBuffer& buffer, unsigned int& buffer_pos )
 
 	Log::Info( "Changing server map to ", map_number );
 
+	map_change_job_= nullptr; // Cancel map change in progress.
+
 	const MapDataConstPtr map_data= map_loader_->LoadMap( map_number );
 	if( map_data == nullptr )
 	{
@@ -398,6 +516,8 @@ bool Server::Load( const SaveLoadBuffer& buffer, unsigned int& buffer_pos )
 	map_end_triggered_= false;
 	join_first_client_with_existing_player_= true;
 
+	PrefetchNextMap();
+
 	show_progress( 1.0f );
 
 	buffer_pos= load_stream.GetBufferPos();
@@ -447,7 +567,9 @@ void Server::operator()( const Messages::PlayerMove& message )
 			if( game_rules_ == GameRules::SinglePlayer )
 			{
 				// Just restart map in SinglePlayer.
-				ChangeMap( current_map_data_->number, map_->GetDifficulty(), game_rules_ );
+				// Restart asynchronously, like next map loading. Loop finishes map change and spawns player.
+				Log::Info( "Restarting server map ", current_map_data_->number );
+				StartMapChange( current_map_data_->number, map_->GetDifficulty(), game_rules_, false );
 				current_player_->player->SetFrags(0u);
 			}
 			else
@@ -470,6 +592,13 @@ void Server::operator()( const Messages::PlayerMove& message )
 		current_player_->player->UpdateMovement( message );
 }
 
+void Server::operator()( const Messages::SnapshotAck& message )
+{
+	PC_ASSERT( current_player_ != nullptr );
+
+	current_player_->snapshots_state.Acknowledge( message.sequence, message.previous_snapshots_mask );
+}
+
 void Server::operator()( const Messages::PlayerName& message )
 {
 	PC_ASSERT( current_player_ != nullptr );
@@ -568,6 +697,17 @@ void Server::BuildServerStateMessage( Messages::ServerState& message )
 	}
 }
 
+void Server::PrefetchNextMap()
+{
+	// Same condition, as in map end processing.
+	if( current_map_data_ == nullptr || current_map_data_->number >= 16u )
+		return;
+
+	const MapLoader::MapInfo next_map_info= map_loader_->GetNextMapInfo( current_map_data_->number );
+	if( next_map_info.number == current_map_data_->number + 1u )
+		map_loader_->PrefetchMap( next_map_info.number );
+}
+
 void Server::AddTextMessage( const char* const text )
 {
 	text_massages_.emplace_back();
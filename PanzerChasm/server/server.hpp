@@ -1,11 +1,14 @@
 #pragma once
+#include <atomic>
 
 #include "../commands_processor.hpp"
 #include "../connection_info.hpp"
+#include "../thread_pool.hpp"
 #include "../time.hpp"
 #include "i_connections_listener.hpp"
 #include "fwd.hpp"
 #include "map.hpp"
+#include "tick_profiler.hpp"
 
 namespace PanzerChasm
 {
@@ -24,6 +27,7 @@ public:
 	void Loop( bool paused );
 
 	// Returns true, if map successfully changed or restarted.
+	// Blocks until map is loaded. Calls loading callback, so, must not be called from "Loop".
 	bool ChangeMap( unsigned int map_number, DifficultyType difficulty, GameRules game_rules, bool is_next_map_change= false );
 	void StopMap();
 
@@ -36,6 +40,7 @@ public: // Messages handlers
 	void operator()( const Messages::MessageBase& message );
 	void operator()( const Messages::DummyNetMessage& ) {}
 	void operator()( const Messages::PlayerMove& message );
+	void operator()( const Messages::SnapshotAck& message );
 	void operator()( const Messages::PlayerName& message );
 
 private:
@@ -51,6 +56,7 @@ private:
 		EntityId player_monster_id;
 		std::string name;
 		bool entered_message_printed= false;
+		DeltaSnapshots::ClientState snapshots_state; // Reset it on map change.
 	};
 
 	typedef std::unique_ptr<ConnectedPlayer> ConnectedPlayerPtr;
@@ -62,10 +68,37 @@ private:
 	};
 	static constexpr unsigned int c_max_multiple_map_ticks= 6u;
 
+	// Map loading and map creation (with collision index building) job.
+	// Executed in separate thread, while server continues processing of messages.
+	struct MapChangeJob
+	{
+		unsigned int map_number;
+		DifficultyType difficulty;
+		GameRules game_rules;
+		bool is_next_map_change;
+		Time map_start_time= Time::FromSeconds(0);
+
+		std::atomic<unsigned char> progress{ 0u }; // Progress of finished loading stages, sent to clients.
+		std::atomic<bool> finished{ false };
+
+		// Results. Access them only after job finish.
+		MapDataConstPtr map_data;
+		std::unique_ptr<Map> map;
+	};
+
+	typedef std::shared_ptr<MapChangeJob> MapChangeJobPtr;
+
 private:
+	void StartMapChange( unsigned int map_number, DifficultyType difficulty, GameRules game_rules, bool is_next_map_change );
+	// Switches map to loaded in map change job. Returns false, if map loading failed.
+	bool FinishMapChange();
+
 	void UpdateTimes();
 	void BuildServerStateMessage( Messages::ServerState& message );
 
+	// Starts background loading of map, which is played after current map end.
+	void PrefetchNextMap();
+
 	void AddTextMessage( const char* text );
 
 	void GiveAmmo();
@@ -105,9 +138,20 @@ private:
 
 	std::vector<Messages::DynamicTextMessage> text_massages_;
 
+	// Sequence of last snapshot. Not reset on map change, so, acknowledgements of previous map snapshots are always old.
+	unsigned int snapshot_sequence_= 0u;
+
+	TickProfiler tick_profiler_;
+
+	MapChangeJobPtr map_change_job_;
+	int map_change_progress_sent_= -1;
+
 	// Cheats
 	bool noclip_= false;
 	bool god_mode_= false;
+
+	// Must be destroyed first, because it may execute map change job.
+	ThreadPool map_change_thread_;
 };
 
 } // PanzerChasm
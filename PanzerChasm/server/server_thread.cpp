@@ -0,0 +1,54 @@
+#include "server_thread.hpp"
+
+namespace PanzerChasm
+{
+
+ServerThread::ServerThread( Server& server, const unsigned int loops_per_second )
+	: server_(server)
+	, loop_duration_(
+		std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>( 1.0 / double(loops_per_second) ) ) )
+	, paused_(false)
+	, stop_(false)
+	, thread_( &ServerThread::ThreadFunc, this )
+{}
+
+ServerThread::~ServerThread()
+{
+	stop_= true;
+	thread_.join();
+}
+
+std::unique_lock<std::mutex> ServerThread::Lock()
+{
+	return std::unique_lock<std::mutex>( server_mutex_ );
+}
+
+void ServerThread::SetPaused( const bool paused )
+{
+	paused_= paused;
+}
+
+void ServerThread::ThreadFunc()
+{
+	std::chrono::steady_clock::time_point next_loop_time= std::chrono::steady_clock::now();
+
+	while( !stop_ )
+	{
+		{
+			std::unique_lock<std::mutex> lock( server_mutex_ );
+			server_.Loop( paused_ );
+		}
+
+		next_loop_time+= loop_duration_;
+
+		// Server is too slow. Do not try to catch up here - server makes multiple map ticks for long loops itself.
+		const std::chrono::steady_clock::time_point current_time= std::chrono::steady_clock::now();
+		if( next_loop_time < current_time )
+			next_loop_time= current_time;
+
+		std::this_thread::sleep_until( next_loop_time );
+	}
+}
+
+} // namespace PanzerChasm
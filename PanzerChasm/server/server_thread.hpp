@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "server.hpp"
+
+namespace PanzerChasm
+{
+
+// Runs server loop in separate thread, with fixed rate.
+// While thread exists, server may be accessed from other threads only under lock, see Lock.
+class ServerThread final
+{
+public:
+	ServerThread( Server& server, unsigned int loops_per_second );
+	~ServerThread();
+
+	ServerThread( const ServerThread& )= delete;
+	ServerThread& operator=( const ServerThread& )= delete;
+
+	std::unique_lock<std::mutex> Lock();
+
+	void SetPaused( bool paused );
+
+private:
+	void ThreadFunc();
+
+private:
+	Server& server_;
+	const std::chrono::steady_clock::duration loop_duration_;
+
+	std::mutex server_mutex_;
+	std::atomic<bool> paused_;
+	std::atomic<bool> stop_;
+
+	// Must be last, because thread uses other members.
+	std::thread thread_;
+};
+
+} // namespace PanzerChasm
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../assert.hpp"
+#include "../log.hpp"
+
+#include "tick_profiler.hpp"
+
+namespace PanzerChasm
+{
+
+constexpr unsigned int TickProfiler::c_window_size;
+
+TickProfiler::ScopedTimer::ScopedTimer( TickProfiler& profiler, const Phase phase )
+	: profiler_(profiler)
+	, phase_(phase)
+	, enabled_( profiler.IsEnabled() )
+{
+	if( enabled_ )
+		start_time_= std::chrono::steady_clock::now();
+}
+
+TickProfiler::ScopedTimer::~ScopedTimer()
+{
+	if( enabled_ )
+		profiler_.AddSample( phase_, std::chrono::steady_clock::now() - start_time_ );
+}
+
+TickProfiler::TickProfiler()
+	: last_csv_dump_time_( Time::CurrentTime() )
+{}
+
+TickProfiler::~TickProfiler()
+{}
+
+void TickProfiler::ProfileCommand( const CommandsArguments& args )
+{
+	if( args.empty() )
+	{
+		if( !enabled_ )
+			Log::Info( "Profiler is disabled. Use \"sv_profile on\" for enabling." );
+		else
+			PrintStats();
+		return;
+	}
+
+	const std::string& command= args.front();
+	if( command == "on" )
+	{
+		enabled_= true;
+		Log::Info( "Profiler enabled" );
+	}
+	else if( command == "off" )
+	{
+		enabled_= false;
+		csv_dump_interval_= Time::FromSeconds(0);
+		Log::Info( "Profiler disabled" );
+	}
+	else if( command == "reset" )
+	{
+		Reset();
+		Log::Info( "Profiler statistics reset" );
+	}
+	else if( command == "csv" )
+	{
+		if( args.size() >= 2u )
+		{
+			// Periodic dumps enable profiler.
+			const float interval_s= std::max( 0.0f, float( std::atof( args[1].c_str() ) ) );
+			csv_dump_interval_= Time::FromSeconds( double(interval_s) );
+			last_csv_dump_time_= Time::CurrentTime();
+			if( interval_s > 0.0f )
+			{
+				enabled_= true;
+				Log::Info( "Profiler CSV dump each ", interval_s, " s" );
+			}
+			else
+				Log::Info( "Profiler CSV dumps disabled" );
+		}
+		else
+			DumpCSV();
+	}
+	else
+		Log::Info( "Usage: sv_profile [on|off|reset|csv [dump_interval_s]]" );
+}
+
+bool TickProfiler::IsEnabled() const
+{
+	return enabled_;
+}
+
+void TickProfiler::AddSample( const Phase phase, const std::chrono::steady_clock::duration duration )
+{
+	PC_ASSERT( phase < Phase::NumPhases );
+	PhaseSamples& phase_samples= phases_samples_[ static_cast<unsigned int>(phase) ];
+
+	const float duration_us= std::chrono::duration<float, std::micro>( duration ).count();
+	if( phase_samples.samples.size() < c_window_size )
+		phase_samples.samples.push_back( duration_us );
+	else
+		phase_samples.samples[ phase_samples.next_sample_index ]= duration_us;
+
+	phase_samples.next_sample_index= ( phase_samples.next_sample_index + 1u ) % c_window_size;
+}
+
+void TickProfiler::Loop()
+{
+	if( !enabled_ || csv_dump_interval_ <= Time::FromSeconds(0) )
+		return;
+
+	const Time current_time= Time::CurrentTime();
+	if( current_time - last_csv_dump_time_ >= csv_dump_interval_ )
+	{
+		last_csv_dump_time_= current_time;
+		DumpCSV();
+	}
+}
+
+void TickProfiler::Reset()
+{
+	for( PhaseSamples& phase_samples : phases_samples_ )
+	{
+		phase_samples.samples.clear();
+		phase_samples.next_sample_index= 0u;
+	}
+}
+
+TickProfiler::PhaseStats TickProfiler::CalculateStats( const Phase phase ) const
+{
+	const std::vector<float>& samples= phases_samples_[ static_cast<unsigned int>(phase) ].samples;
+
+	PhaseStats stats;
+	stats.samples_count= samples.size();
+	stats.average_us= stats.p50_us= stats.p95_us= stats.p99_us= stats.max_us= 0.0;
+	if( samples.empty() )
+		return stats;
+
+	std::vector<float> sorted_samples= samples;
+	std::sort( sorted_samples.begin(), sorted_samples.end() );
+
+	double sum= 0.0;
+	for( const float sample : sorted_samples )
+		sum+= double(sample);
+
+	const auto percentile=
+	[&]( const unsigned int p ) -> double
+	{
+		return double( sorted_samples[ ( sorted_samples.size() - 1u ) * p / 100u ] );
+	};
+
+	stats.average_us= sum / double( sorted_samples.size() );
+	stats.p50_us= percentile( 50u );
+	stats.p95_us= percentile( 95u );
+	stats.p99_us= percentile( 99u );
+	stats.max_us= double( sorted_samples.back() );
+	return stats;
+}
+
+void TickProfiler::PrintStats() const
+{
+	Log::Info( "phase                samples   avg_us   p50_us   p95_us   p99_us   max_us" );
+	for( unsigned int p= 0u; p < static_cast<unsigned int>(Phase::NumPhases); p++ )
+	{
+		const Phase phase= static_cast<Phase>(p);
+		const PhaseStats stats= CalculateStats( phase );
+
+		char str[160];
+		std::snprintf(
+			str, sizeof(str), "%-20s %7u %8.1f %8.1f %8.1f %8.1f %8.1f",
+			GetPhaseName( phase ), stats.samples_count,
+			stats.average_us, stats.p50_us, stats.p95_us, stats.p99_us, stats.max_us );
+		Log::Info( str );
+	}
+}
+
+void TickProfiler::DumpCSV() const
+{
+	Log::Info( "profile_csv,phase,samples,avg_us,p50_us,p95_us,p99_us,max_us" );
+	for( unsigned int p= 0u; p < static_cast<unsigned int>(Phase::NumPhases); p++ )
+	{
+		const Phase phase= static_cast<Phase>(p);
+		const PhaseStats stats= CalculateStats( phase );
+
+		char str[160];
+		std::snprintf(
+			str, sizeof(str), "profile_csv,%s,%u,%.1f,%.1f,%.1f,%.1f,%.1f",
+			GetPhaseName( phase ), stats.samples_count,
+			stats.average_us, stats.p50_us, stats.p95_us, stats.p99_us, stats.max_us );
+		Log::Info( str );
+	}
+}
+
+const char* TickProfiler::GetPhaseName( const Phase phase )
+{
+	switch( phase )
+	{
+	case Phase::MapTick: return "map_tick";
+	case Phase::Procedures: return "procedures";
+	case Phase::MoveMapObjects: return "move_map_objects";
+	case Phase::Rockets: return "rockets";
+	case Phase::Mines: return "mines";
+	case Phase::Navigation: return "navigation";
+	case Phase::MonstersThink: return "monsters_think";
+	case Phase::MonstersTick: return "monsters_tick";
+	case Phase::MonstersCollisions: return "monsters_collisions";
+	case Phase::PlayersPositions: return "players_positions";
+	case Phase::SendUpdateMessages: return "send_update_messages";
+	case Phase::ServerLoop: return "server_loop";
+	case Phase::NumPhases: break;
+	};
+
+	PC_ASSERT(false);
+	return "";
+}
+
+} // namespace PanzerChasm
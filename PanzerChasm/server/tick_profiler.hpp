@@ -0,0 +1,99 @@
+#pragma once
+#include <chrono>
+#include <vector>
+
+#include "../commands_processor.hpp"
+#include "../time.hpp"
+
+namespace PanzerChasm
+{
+
+// Low-overhead profiler for server loop phases.
+// Stores durations of last samples of each phase in ring buffers and calculates statistics over this rolling window.
+// Disabled by default. When disabled, timers do not query clock.
+class TickProfiler final
+{
+public:
+	enum class Phase : unsigned int
+	{
+		MapTick,
+		Procedures,
+		MoveMapObjects,
+		Rockets,
+		Mines,
+		Navigation,
+		MonstersThink,
+		MonstersTick,
+		MonstersCollisions,
+		PlayersPositions,
+		SendUpdateMessages,
+		ServerLoop,
+		NumPhases,
+	};
+
+	class ScopedTimer final
+	{
+	public:
+		ScopedTimer( TickProfiler& profiler, Phase phase );
+		~ScopedTimer();
+
+		ScopedTimer( const ScopedTimer& )= delete;
+		ScopedTimer& operator=( const ScopedTimer& )= delete;
+
+	private:
+		TickProfiler& profiler_;
+		const Phase phase_;
+		const bool enabled_;
+		std::chrono::steady_clock::time_point start_time_;
+	};
+
+	TickProfiler();
+	~TickProfiler();
+
+	// Console command handler.
+	// Usage: sv_profile [on|off|reset|csv [dump_interval_s]]. Without arguments prints statistics.
+	void ProfileCommand( const CommandsArguments& args );
+
+	bool IsEnabled() const;
+	void AddSample( Phase phase, std::chrono::steady_clock::duration duration );
+
+	// Call it once per server loop. Makes periodic CSV dumps.
+	void Loop();
+
+private:
+	struct PhaseStats
+	{
+		unsigned int samples_count;
+		double average_us;
+		double p50_us;
+		double p95_us;
+		double p99_us;
+		double max_us;
+	};
+
+	// Samples of phase in microseconds.
+	struct PhaseSamples
+	{
+		std::vector<float> samples; // Ring buffer.
+		unsigned int next_sample_index= 0u;
+	};
+
+	static constexpr unsigned int c_window_size= 1024u;
+
+private:
+	void Reset();
+	PhaseStats CalculateStats( Phase phase ) const;
+	void PrintStats() const;
+	void DumpCSV() const;
+
+	static const char* GetPhaseName( Phase phase );
+
+private:
+	bool enabled_= false;
+	PhaseSamples phases_samples_[ static_cast<unsigned int>(Phase::NumPhases) ];
+
+	Time csv_dump_interval_= Time::FromSeconds(0);
+	Time last_csv_dump_time_; // Real time
+};
+
+} // namespace PanzerChasm
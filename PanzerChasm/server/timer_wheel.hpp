@@ -0,0 +1,201 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../assert.hpp"
+#include "../time.hpp"
+
+namespace PanzerChasm
+{
+
+// Hierarchical timer wheel.
+// Stores events with time and returns them, when time comes. Scheduling is O(1), advancing is O(1) per fired event
+// and per elapsed slot. Empty spans of time are skipped, so, long gaps between events are cheap.
+// Events are not removed - owner must check event actuality, when event fires.
+template<class T>
+class TimerWheel final
+{
+public:
+	TimerWheel();
+
+	void Schedule( Time time, T event );
+
+	// Calls func( const T& event ) for each event with time <= current_time.
+	// Events, scheduled from func, are processed not earlier, than in next Advance call.
+	template<class Func>
+	void Advance( Time current_time, const Func& func );
+
+	void Clear();
+
+private:
+	struct Entry
+	{
+		int64_t time; // In Time internal representation.
+		T event;
+	};
+
+	typedef std::vector<Entry> Slot;
+
+	// Slot size is 64 time units ( 6.4 ms ), so, levels cover 1.6 s, 7 min, 30 hours.
+	static constexpr unsigned int c_slot_size_log2= 6u;
+	static constexpr unsigned int c_slots_per_level_log2= 8u;
+	static constexpr unsigned int c_slots_per_level= 1u << c_slots_per_level_log2;
+	static constexpr unsigned int c_levels= 3u;
+
+private:
+	void Place( Entry entry );
+	void Cascade( Slot& slot, unsigned int level );
+	int64_t GetNextTick() const;
+
+private:
+	// Current position of wheel. All slots before this tick are processed.
+	int64_t current_tick_= 0;
+
+	Slot slots_[ c_levels ][ c_slots_per_level ];
+	unsigned int level_entries_count_[ c_levels ]= {};
+	Slot overflow_; // Events far in the future.
+
+	Slot processed_slot_; // Temporary storage.
+};
+
+template<class T>
+TimerWheel<T>::TimerWheel()
+{}
+
+template<class T>
+void TimerWheel<T>::Schedule( const Time time, T event )
+{
+	Entry entry;
+	entry.time= time.GetInternalRepresentation();
+	entry.event= std::move(event);
+	Place( std::move(entry) );
+}
+
+template<class T>
+template<class Func>
+void TimerWheel<T>::Advance( const Time current_time, const Func& func )
+{
+	const int64_t current_time_internal= current_time.GetInternalRepresentation();
+	const int64_t target_tick= current_time_internal >> c_slot_size_log2;
+
+	while(true)
+	{
+		Slot& slot= slots_[0][ current_tick_ & ( c_slots_per_level - 1u ) ];
+		if( !slot.empty() )
+		{
+			processed_slot_.swap( slot );
+			level_entries_count_[0]-= processed_slot_.size();
+
+			for( Entry& entry : processed_slot_ )
+			{
+				// Slot of target tick may contain events later, than current time.
+				if( entry.time <= current_time_internal )
+					func( static_cast<const T&>(entry.event) );
+				else
+				{
+					slot.push_back( std::move(entry) );
+					level_entries_count_[0]++;
+				}
+			}
+			processed_slot_.clear();
+		}
+
+		if( current_tick_ >= target_tick )
+			break;
+
+		const int64_t next_tick= GetNextTick();
+		if( next_tick > target_tick )
+		{
+			// No slot boundaries with nonempty slots before target.
+			current_tick_= target_tick;
+			break;
+		}
+		current_tick_= next_tick;
+
+		// Move events from upper levels down, when wheel reaches start of their span.
+		const int64_t level_1_mask= ( int64_t(1) << ( c_slots_per_level_log2 * 1u ) ) - 1;
+		const int64_t level_2_mask= ( int64_t(1) << ( c_slots_per_level_log2 * 2u ) ) - 1;
+		const int64_t overflow_mask= ( int64_t(1) << ( c_slots_per_level_log2 * 3u ) ) - 1;
+		if( ( current_tick_ & overflow_mask ) == 0 )
+			Cascade( overflow_, c_levels );
+		if( ( current_tick_ & level_2_mask ) == 0 )
+			Cascade( slots_[2][ ( current_tick_ >> ( c_slots_per_level_log2 * 2u ) ) & ( c_slots_per_level - 1u ) ], 2u );
+		if( ( current_tick_ & level_1_mask ) == 0 )
+			Cascade( slots_[1][ ( current_tick_ >> ( c_slots_per_level_log2 * 1u ) ) & ( c_slots_per_level - 1u ) ], 1u );
+	}
+}
+
+template<class T>
+void TimerWheel<T>::Clear()
+{
+	for( unsigned int level= 0u; level < c_levels; level++ )
+	{
+		for( Slot& slot : slots_[level] )
+			slot.clear();
+		level_entries_count_[level]= 0u;
+	}
+	overflow_.clear();
+}
+
+template<class T>
+void TimerWheel<T>::Place( Entry entry )
+{
+	// Events in the past are placed into current slot.
+	const int64_t tick= std::max( entry.time >> c_slot_size_log2, current_tick_ );
+
+	for( unsigned int level= 0u; level < c_levels; level++ )
+	{
+		const unsigned int span_shift= c_slots_per_level_log2 * ( level + 1u );
+		if( ( tick >> span_shift ) == ( current_tick_ >> span_shift ) )
+		{
+			const unsigned int slot_index= ( tick >> ( c_slots_per_level_log2 * level ) ) & ( c_slots_per_level - 1u );
+			slots_[level][ slot_index ].push_back( std::move(entry) );
+			level_entries_count_[level]++;
+			return;
+		}
+	}
+
+	overflow_.push_back( std::move(entry) );
+}
+
+template<class T>
+void TimerWheel<T>::Cascade( Slot& slot, const unsigned int level )
+{
+	if( slot.empty() )
+		return;
+
+	Slot entries;
+	entries.swap( slot );
+	if( level < c_levels )
+	{
+		PC_ASSERT( level_entries_count_[level] >= entries.size() );
+		level_entries_count_[level]-= entries.size();
+	}
+
+	for( Entry& entry : entries )
+		Place( std::move(entry) );
+}
+
+template<class T>
+int64_t TimerWheel<T>::GetNextTick() const
+{
+	// Skip spans of empty levels.
+	// Do not skip slot boundary, where nonempty upper level must be cascaded.
+	unsigned int skip_levels= 0u;
+	while( skip_levels < c_levels && level_entries_count_[ skip_levels ] == 0u )
+		skip_levels++;
+
+	if( skip_levels == c_levels && overflow_.empty() )
+		return std::numeric_limits<int64_t>::max();
+
+	if( skip_levels == 0u )
+		return current_tick_ + 1;
+
+	const int64_t span_mask= ( int64_t(1) << ( c_slots_per_level_log2 * skip_levels ) ) - 1;
+	return ( current_tick_ | span_mask ) + 1;
+}
+
+} // namespace PanzerChasm
@@ -0,0 +1,477 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "../assert.hpp"
+#include "../game_constants.hpp"
+#include "../thread_pool.hpp"
+#include "collision_index.inl"
+
+#include "visibility_matrix.hpp"
+
+namespace PanzerChasm
+{
+
+namespace
+{
+
+// Integer coordinates in map file units. Vertices of static walls are exact in these units, so, all geometry tests
+// for proving of cells invisibility are exact.
+typedef int64_t Coord;
+
+const Coord g_cell_size= 256; // Inverse of map coordinates scale.
+// Cells in matrix are shrinked by this value. So, static walls on cells borders do not touch cells.
+const Coord g_cell_border= 1;
+
+struct IntVec
+{
+	Coord x;
+	Coord y;
+};
+
+IntVec operator+( const IntVec& l, const IntVec& r )
+{
+	return IntVec{ l.x + r.x, l.y + r.y };
+}
+
+IntVec operator-( const IntVec& l, const IntVec& r )
+{
+	return IntVec{ l.x - r.x, l.y - r.y };
+}
+
+// Returns positive value, if point is left of line a-b, negative, if right, zero, if on line.
+int Orient( const IntVec& a, const IntVec& b, const IntVec& point )
+{
+	const Coord cross= ( b.x - a.x ) * ( point.y - a.y ) - ( b.y - a.y ) * ( point.x - a.x );
+	return ( cross > 0 ) - ( cross < 0 );
+}
+
+// Point must be on line a-b.
+bool PointOnSegment( const IntVec& a, const IntVec& b, const IntVec& point )
+{
+	return
+		point.x >= std::min( a.x, b.x ) && point.x <= std::max( a.x, b.x ) &&
+		point.y >= std::min( a.y, b.y ) && point.y <= std::max( a.y, b.y );
+}
+
+// Segments are closed.
+bool SegmentsIntersect( const IntVec& a0, const IntVec& a1, const IntVec& b0, const IntVec& b1 )
+{
+	const int o0= Orient( a0, a1, b0 );
+	const int o1= Orient( a0, a1, b1 );
+	const int o2= Orient( b0, b1, a0 );
+	const int o3= Orient( b0, b1, a1 );
+
+	if( o0 != o1 && o2 != o3 )
+		return true;
+
+	return
+		( o0 == 0 && PointOnSegment( a0, a1, b0 ) ) ||
+		( o1 == 0 && PointOnSegment( a0, a1, b1 ) ) ||
+		( o2 == 0 && PointOnSegment( b0, b1, a0 ) ) ||
+		( o3 == 0 && PointOnSegment( b0, b1, a1 ) );
+}
+
+// Segment and box are closed.
+bool SegmentIntersectsBox( const IntVec& a, const IntVec& b, const IntVec& box_min, const IntVec& box_max )
+{
+	if( std::max( a.x, b.x ) < box_min.x || std::min( a.x, b.x ) > box_max.x ||
+		std::max( a.y, b.y ) < box_min.y || std::min( a.y, b.y ) > box_max.y )
+		return false;
+
+	// Bounding boxes intersect. Segment intersects box, if box corners are not strictly on one side of segment line.
+	const int o0= Orient( a, b, box_min );
+	const int o1= Orient( a, b, box_max );
+	const int o2= Orient( a, b, IntVec{ box_min.x, box_max.y } );
+	const int o3= Orient( a, b, IntVec{ box_max.x, box_min.y } );
+	return !(
+		( o0 > 0 && o1 > 0 && o2 > 0 && o3 > 0 ) ||
+		( o0 < 0 && o1 < 0 && o2 < 0 && o3 < 0 ) );
+}
+
+// Returns true, if point is inside box, swept along vector "sweep".
+bool PointInSweptBox( const IntVec& point, const IntVec& box_min, const IntVec& box_max, const IntVec& sweep )
+{
+	// Find range of t in [0; 1], where box_min <= point - t * sweep <= box_max.
+	// Store bounds of range as fractions with positive denominators.
+	Coord low_num= 0, low_den= 1;
+	Coord high_num= 1, high_den= 1;
+
+	const Coord point_coords[2]= { point.x, point.y };
+	const Coord min_coords[2]= { box_min.x, box_min.y };
+	const Coord max_coords[2]= { box_max.x, box_max.y };
+	const Coord sweep_coords[2]= { sweep.x, sweep.y };
+	for( unsigned int i= 0u; i < 2u; i++ )
+	{
+		if( sweep_coords[i] == 0 )
+		{
+			if( point_coords[i] < min_coords[i] || point_coords[i] > max_coords[i] )
+				return false;
+			continue;
+		}
+
+		// t * sweep must be in range [ point - max; point - min ].
+		Coord range_low = point_coords[i] - max_coords[i];
+		Coord range_high= point_coords[i] - min_coords[i];
+		Coord den= sweep_coords[i];
+		if( den < 0 )
+		{
+			std::swap( range_low, range_high );
+			range_low = -range_low ;
+			range_high= -range_high;
+			den= -den;
+		}
+
+		if( range_low * low_den > low_num * den )
+		{
+			low_num= range_low;
+			low_den= den;
+		}
+		if( range_high * high_den < high_num * den )
+		{
+			high_num= range_high;
+			high_den= den;
+		}
+	}
+
+	return low_num * high_den <= high_num * low_den;
+}
+
+// Opaque static walls, connected via common vertices.
+struct StaticWallsGraph
+{
+	struct Wall
+	{
+		IntVec vertices[2];
+		unsigned int vertices_ids[2];
+	};
+
+	explicit StaticWallsGraph( const MapData& map_data );
+
+	std::vector<Wall> walls;
+	std::vector<unsigned int> static_wall_to_wall; // ~0u for not opaque walls.
+	std::vector< std::vector<unsigned int> > vertices_walls;
+};
+
+StaticWallsGraph::StaticWallsGraph( const MapData& map_data )
+{
+	std::unordered_map< uint64_t, unsigned int > vertices_ids;
+
+	static_wall_to_wall.resize( map_data.static_walls.size(), ~0u );
+	for( unsigned int i= 0u; i < map_data.static_walls.size(); i++ )
+	{
+		const MapData::Wall& map_wall= map_data.static_walls[i];
+		if( map_data.walls_textures[ map_wall.texture_id ].gso[1] )
+			continue;
+
+		static_wall_to_wall[i]= walls.size();
+		walls.emplace_back();
+		Wall& wall= walls.back();
+
+		for( unsigned int j= 0u; j < 2u; j++ )
+		{
+			// Map coordinates are exact in map file units.
+			wall.vertices[j].x= static_cast<Coord>( map_wall.vert_pos[j].x * float(g_cell_size) );
+			wall.vertices[j].y= static_cast<Coord>( map_wall.vert_pos[j].y * float(g_cell_size) );
+
+			const uint64_t key= ( uint64_t( uint32_t( wall.vertices[j].x ) ) << 32u ) | uint64_t( uint32_t( wall.vertices[j].y ) );
+			const auto it= vertices_ids.find( key );
+			if( it == vertices_ids.end() )
+			{
+				wall.vertices_ids[j]= vertices_walls.size();
+				vertices_ids.emplace( key, wall.vertices_ids[j] );
+				vertices_walls.emplace_back();
+			}
+			else
+				wall.vertices_ids[j]= it->second;
+
+			std::vector<unsigned int>& vertex_walls= vertices_walls[ wall.vertices_ids[j] ];
+			if( vertex_walls.empty() || vertex_walls.back() != walls.size() - 1u )
+				vertex_walls.push_back( walls.size() - 1u );
+		}
+	}
+}
+
+// Proves, that all lines between two cells are blocked by static walls.
+// Object must be used only in one thread.
+class CellsBlockingChecker final
+{
+public:
+	CellsBlockingChecker( const StaticWallsGraph& walls_graph, const CollisionIndex& collision_index );
+
+	// Returns true, if each line between shrinked cells crosses static walls.
+	// Returns false, if it is not proved.
+	bool IsBlocked( unsigned int cell0, unsigned int cell1 );
+
+private:
+	// Func must return true, if need abort.
+	template<class Func>
+	void ProcessWallsOnSegment( const IntVec& a, const IntVec& b, const Func& func ) const;
+
+private:
+	const StaticWallsGraph& walls_graph_;
+	const CollisionIndex& collision_index_;
+
+	// Walls marks for current check. Wall is marked, if it has mark of current check.
+	std::vector<unsigned int> visited_walls_;
+	unsigned int current_generation_= 0u;
+
+	std::vector<unsigned int> walls_stack_;
+};
+
+CellsBlockingChecker::CellsBlockingChecker( const StaticWallsGraph& walls_graph, const CollisionIndex& collision_index )
+	: walls_graph_(walls_graph), collision_index_(collision_index)
+	, visited_walls_( walls_graph.walls.size(), 0u )
+{}
+
+bool CellsBlockingChecker::IsBlocked( const unsigned int cell0, const unsigned int cell1 )
+{
+	// All lines between points of two cells are inside convex hull of cells. This hull is first cell, swept to second
+	// cell. Boundary of hull consists of boundaries of cells and two side edges, parallel to sweep vector.
+	// If connected set of walls touches both side edges and does not touch cells, it splits hull into two parts,
+	// one with first cell and one with second cell. So, any line between cells crosses walls.
+
+	const IntVec cell0_min{
+		Coord( cell0 % MapData::c_map_size ) * g_cell_size + g_cell_border,
+		Coord( cell0 / MapData::c_map_size ) * g_cell_size + g_cell_border };
+	const IntVec cell1_min{
+		Coord( cell1 % MapData::c_map_size ) * g_cell_size + g_cell_border,
+		Coord( cell1 / MapData::c_map_size ) * g_cell_size + g_cell_border };
+	const IntVec cells_size{ g_cell_size - 2 * g_cell_border, g_cell_size - 2 * g_cell_border };
+	const IntVec cell0_max= cell0_min + cells_size;
+	const IntVec cell1_max= cell1_min + cells_size;
+
+	const IntVec sweep= cell1_min - cell0_min;
+
+	// Side edges start at corners of first cell, extreme in direction, perpendicular to sweep vector.
+	const IntVec corners[4]=
+	{
+		cell0_min, cell0_max,
+		IntVec{ cell0_min.x, cell0_max.y }, IntVec{ cell0_max.x, cell0_min.y },
+	};
+	IntVec side_start[2]= { corners[0], corners[0] };
+	Coord side_dot[2];
+	side_dot[0]= side_dot[1]= sweep.x * corners[0].y - sweep.y * corners[0].x;
+	for( const IntVec& corner : corners )
+	{
+		const Coord dot= sweep.x * corner.y - sweep.y * corner.x;
+		if( dot > side_dot[0] )
+		{
+			side_dot[0]= dot;
+			side_start[0]= corner;
+		}
+		if( dot < side_dot[1] )
+		{
+			side_dot[1]= dot;
+			side_start[1]= corner;
+		}
+	}
+
+	current_generation_++;
+	if( current_generation_ == 0u )
+	{
+		std::fill( visited_walls_.begin(), visited_walls_.end(), 0u );
+		current_generation_= 1u;
+	}
+
+	const IntVec& end_side_start= side_start[1];
+	const IntVec end_side_end= side_start[1] + sweep;
+
+	const auto try_add_wall=
+	[&]( const unsigned int wall_index )
+	{
+		if( visited_walls_[ wall_index ] == current_generation_ )
+			return;
+		visited_walls_[ wall_index ]= current_generation_;
+
+		// Walls, touching cells, do not split hull.
+		const StaticWallsGraph::Wall& wall= walls_graph_.walls[ wall_index ];
+		if( SegmentIntersectsBox( wall.vertices[0], wall.vertices[1], cell0_min, cell0_max ) ||
+			SegmentIntersectsBox( wall.vertices[0], wall.vertices[1], cell1_min, cell1_max ) )
+			return;
+
+		walls_stack_.push_back( wall_index );
+	};
+
+	// Search connected walls, starting from each wall on first side edge, until wall on second side edge is found.
+	// Walls, visited from previous start walls, are not visited again - they are not connected with second side edge.
+	bool blocked= false;
+	ProcessWallsOnSegment(
+		side_start[0], side_start[0] + sweep,
+		[&]( const unsigned int start_wall_index ) -> bool
+		{
+			walls_stack_.clear();
+			try_add_wall( start_wall_index );
+
+			while( !walls_stack_.empty() )
+			{
+				const unsigned int wall_index= walls_stack_.back();
+				walls_stack_.pop_back();
+
+				const StaticWallsGraph::Wall& wall= walls_graph_.walls[ wall_index ];
+				if( SegmentsIntersect( wall.vertices[0], wall.vertices[1], end_side_start, end_side_end ) )
+				{
+					blocked= true;
+					return true;
+				}
+
+				// Part of wall inside hull is connected with other walls only via common vertices inside hull.
+				for( unsigned int i= 0u; i < 2u; i++ )
+				{
+					if( !PointInSweptBox( wall.vertices[i], cell0_min, cell0_max, sweep ) )
+						continue;
+
+					for( const unsigned int neighbor_wall_index : walls_graph_.vertices_walls[ wall.vertices_ids[i] ] )
+						try_add_wall( neighbor_wall_index );
+				}
+			}
+
+			return false;
+		} );
+
+	return blocked;
+}
+
+template<class Func>
+void CellsBlockingChecker::ProcessWallsOnSegment( const IntVec& a, const IntVec& b, const Func& func ) const
+{
+	const m_Vec3 from(
+		float(a.x) / float(g_cell_size),
+		float(a.y) / float(g_cell_size),
+		GameConstants::walls_height * 0.5f );
+	const m_Vec3 to(
+		float(b.x) / float(g_cell_size),
+		float(b.y) / float(g_cell_size),
+		from.z );
+
+	m_Vec3 dir= to - from;
+	const float length= dir.Length();
+	dir/= length;
+
+	// Collision index used only for fetching of walls near segment, exact check performed here.
+	collision_index_.RayCast(
+		from, dir,
+		[&]( const MapData::IndexElement& element ) -> bool
+		{
+			if( element.type != MapData::IndexElement::StaticWall )
+				return false;
+
+			const unsigned int wall_index= walls_graph_.static_wall_to_wall[ element.index ];
+			if( wall_index == ~0u )
+				return false;
+
+			const StaticWallsGraph::Wall& wall= walls_graph_.walls[ wall_index ];
+			return
+				SegmentsIntersect( a, b, wall.vertices[0], wall.vertices[1] ) &&
+				func( wall_index );
+		},
+		length + 1.0f );
+}
+
+unsigned int GetCellForPosition( const m_Vec2& pos )
+{
+	const float x= std::floor( pos.x );
+	const float y= std::floor( pos.y );
+	if( x < 0.0f || x >= float(MapData::c_map_size) ||
+		y < 0.0f || y >= float(MapData::c_map_size) )
+		return ~0u;
+
+	// Matrix covers only shrinked cells. Subtraction here is exact.
+	const float border= float(g_cell_border) / float(g_cell_size);
+	const float dx= pos.x - x;
+	const float dy= pos.y - y;
+	if( dx < border || dx > 1.0f - border ||
+		dy < border || dy > 1.0f - border )
+		return ~0u;
+
+	return static_cast<unsigned int>( x ) + static_cast<unsigned int>( y ) * MapData::c_map_size;
+}
+
+} // namespace
+
+constexpr unsigned int VisibilityMatrix::c_cells_count;
+constexpr unsigned int VisibilityMatrix::c_bits_size;
+
+VisibilityMatrix::VisibilityMatrix( const MapDataConstPtr& map_data )
+{
+	PC_ASSERT( map_data != nullptr );
+
+	const unsigned int c_map_size= MapData::c_map_size;
+
+	// Collision index used only for fetching of walls near segments.
+	const CollisionIndex collision_index( map_data );
+	const StaticWallsGraph walls_graph( *map_data );
+
+	bits_.resize( c_bits_size, 0u );
+
+	// Check visibility from given cell to all cells with greater number.
+	const auto process_cell=
+	[&]( const unsigned int cell, CellsBlockingChecker& blocking_checker )
+	{
+		RowBits* const cell_bits= bits_.data() + cell * c_map_size;
+		cell_bits[ cell / c_map_size ]|= RowBits(1u) << ( cell % c_map_size );
+
+		for( unsigned int other_cell= cell + 1u; other_cell < c_cells_count; other_cell++ )
+		{
+			if( !blocking_checker.IsBlocked( cell, other_cell ) )
+				cell_bits[ other_cell / c_map_size ]|= RowBits(1u) << ( other_cell % c_map_size );
+		}
+	};
+
+	{ // Check cells in parallel. Each task writes only rows of own cells.
+		ThreadPool thread_pool;
+		for( unsigned int task= 0u; task < c_map_size; task++ )
+		{
+			thread_pool.AddTask(
+				[&process_cell, &walls_graph, &collision_index, task]
+				{
+					CellsBlockingChecker blocking_checker( walls_graph, collision_index );
+
+					// Interleave cells, because for cells with greater numbers there are less pairs.
+					for( unsigned int cell= task; cell < c_cells_count; cell+= c_map_size )
+						process_cell( cell, blocking_checker );
+				} );
+		}
+		thread_pool.WaitAll();
+	}
+
+	// Visibility is symmetric. Copy results for pairs, which were checked in one direction.
+	for( unsigned int cell= 0u; cell < c_cells_count; cell++ )
+	{
+		const RowBits cell_bit= RowBits(1u) << ( cell % c_map_size );
+		const unsigned int cell_row= cell / c_map_size;
+
+		for( unsigned int other_cell= cell + 1u; other_cell < c_cells_count; other_cell++ )
+		{
+			if( ( bits_[ cell * c_map_size + other_cell / c_map_size ] & ( RowBits(1u) << ( other_cell % c_map_size ) ) ) != 0u )
+				bits_[ other_cell * c_map_size + cell_row ]|= cell_bit;
+		}
+	}
+}
+
+VisibilityMatrix::VisibilityMatrix( std::vector<RowBits> bits )
+	: bits_( std::move(bits) )
+{
+	PC_ASSERT( bits_.size() == c_bits_size );
+}
+
+VisibilityMatrix::~VisibilityMatrix()
+{}
+
+const std::vector<VisibilityMatrix::RowBits>& VisibilityMatrix::GetBits() const
+{
+	return bits_;
+}
+
+bool VisibilityMatrix::MayBeVisible( const m_Vec2& from, const m_Vec2& to ) const
+{
+	const unsigned int from_cell= GetCellForPosition( from );
+	const unsigned int to_cell= GetCellForPosition( to );
+	if( from_cell == ~0u || to_cell == ~0u )
+		return true;
+
+	const RowBits row= bits_[ from_cell * MapData::c_map_size + to_cell / MapData::c_map_size ];
+	return ( row & ( RowBits(1u) << ( to_cell % MapData::c_map_size ) ) ) != 0u;
+}
+
+} // namespace PanzerChasm
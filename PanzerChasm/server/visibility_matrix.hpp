@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../map_loader.hpp"
+
+namespace PanzerChasm
+{
+
+// Precalculated cell-to-cell visibility ( potentially visible set ) for static walls.
+// If cells are not visible, any line between any points of this cells is blocked by static walls.
+// Dynamic walls and models are ignored, they can only block more lines, so, result stays conservative.
+// Cells are marked as not visible only if it is proved, that chain of static walls, connected via common vertices,
+// crosses all lines between cells. Points near cells borders are not covered by matrix, for them it returns "visible".
+class VisibilityMatrix final
+{
+public:
+	typedef uint64_t RowBits;
+	static_assert( sizeof(RowBits) * 8u == MapData::c_map_size, "Row must contain bit for each cell of map row" );
+
+	static constexpr unsigned int c_cells_count= MapData::c_map_size * MapData::c_map_size;
+	static constexpr unsigned int c_bits_size= c_cells_count * MapData::c_map_size;
+
+public:
+	// Calculates matrix. Calculation is slow, so, map loader calculates matrix only once and stores it in map cache.
+	// Map data must be fully loaded.
+	explicit VisibilityMatrix( const MapDataConstPtr& map_data );
+	// Restores matrix from bits of previously calculated matrix.
+	explicit VisibilityMatrix( std::vector<RowBits> bits );
+	~VisibilityMatrix();
+
+	const std::vector<RowBits>& GetBits() const;
+
+	// Returns true, if positions may be visible.
+	// Returns true for positions outside map.
+	bool MayBeVisible( const m_Vec2& from, const m_Vec2& to ) const;
+
+private:
+	// For each cell - one row bits for each map row.
+	// Bit for cell( x, y ) visibility from cell c stored in bits_[ c * c_map_size + y ], bit x.
+	std::vector<RowBits> bits_;
+};
+
+} // namespace PanzerChasm
@@ -7,6 +7,12 @@ namespace SettingsKeys
 {
 
 const char always_run[]= "sv_always_run";
+const char server_loops_per_second[]= "sv_loops_per_second";
+const char server_map[]= "sv_map";
+const char server_difficulty[]= "sv_difficulty";
+const char server_cooperative[]= "sv_cooperative";
+const char server_tcp_port[]= "sv_port";
+const char server_udp_base_port[]= "sv_udp_base_port";
 const char crosshair[]= "cl_crosshair";
 const char reverse_mouse[]= "in_reverse_mouse";
 const char weapon_reset[]= "cl_weapon_reset";
@@ -23,7 +23,7 @@ struct Channel
 	unsigned int position_samples;
 	bool looped;
 
-	ISoundData* src_sound_data= nullptr;
+	const ISoundData* src_sound_data= nullptr;
 };
 
 typedef std::array<Channel, Channel::c_max_channels> Channels;
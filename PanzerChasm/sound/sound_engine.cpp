@@ -29,6 +29,7 @@ SoundEngine::SoundEngine(
 	const GameResourcesConstPtr& game_resources )
 	: game_resources_( game_resources )
 	, settings_( settings )
+	, sounds_cache_( game_resources->vfs )
 	, objects_sounds_processor_( game_resources )
 {
 	PC_ASSERT( game_resources_ != nullptr );
@@ -44,7 +45,7 @@ SoundEngine::SoundEngine(
 		if( sound.file_name[0] == '\0' )
 			continue;
 
-		sounds_[s]= LoadSound( sound.file_name, *game_resources_->vfs );
+		sounds_[s]= sounds_cache_.GetSound( sound.file_name );
 
 		if( sounds_[s] != nullptr )
 		{
@@ -61,7 +62,7 @@ SoundEngine::SoundEngine(
 		for( unsigned int j= 0; j < model.sounds.size() && j < c_max_monster_sounds; j++ )
 		{
 			ISoundDataConstPtr& sound= sounds_[ first_monster_sound + j ];
-			sound= LoadRawMonsterSound( model.sounds[j] );
+			sound= sounds_cache_.GetRawMonsterSound( model.sounds[j] );
 
 			if( sound != nullptr )
 			{
@@ -72,7 +73,9 @@ SoundEngine::SoundEngine(
 	}
 
 	Log::Info( "End loading sounds" );
-	Log::Info( "Total ", total_sounds_loaded, " sounds. Sound data size: ", sound_data_size / 1024u, "kb" );
+	Log::Info(
+		"Total ", total_sounds_loaded, " sounds (", sounds_cache_.GetLoadsCount(), " unique).",
+		" Sound data size: ", sound_data_size / 1024u, "kb" );
 }
 
 SoundEngine::~SoundEngine()
@@ -164,31 +167,31 @@ void SoundEngine::SetMap( const MapDataConstPtr& map_data )
 		{
 			Log::Info( "Loading sounds for map" );
 
-			// TODO reuse old sounds
+			const unsigned int loads_count_before= sounds_cache_.GetLoadsCount();
+
+			// Old sounds are replaced after new sounds taken, so, sounds, same for old and new map, are reused.
 			for( unsigned int s= 0u; s < MapData::c_max_map_sounds; s++ )
 			{
-				ISoundDataConstPtr& sound= sounds_[ c_first_map_sound + s ];
-				sound= nullptr; // remove old
-
 				const GameResources::SoundDescription& sound_description= map_data->map_sounds[s];
-				if( sound_description.file_name[0] == '\0' )
-					continue;
-
-				sound= LoadSound( sound_description.file_name, *game_resources_->vfs );
+				sounds_[ c_first_map_sound + s ]=
+					sound_description.file_name[0] == '\0'
+						? nullptr
+						: sounds_cache_.GetSound( sound_description.file_name );
 			}
 
 			for( unsigned int s= 0u; s < MapData::c_max_map_ambients; s++ )
 			{
-				ISoundDataConstPtr& sound= sounds_[ c_first_map_ambient_sound + s ];
-				sound= nullptr; // remove old
-
 				const GameResources::SoundDescription& sound_description= map_data->ambients[s];
-				if( sound_description.file_name[0] == '\0' )
-					continue;
-
-				sound= LoadSound( sound_description.file_name, *game_resources_->vfs );
+				sounds_[ c_first_map_ambient_sound + s ]=
+					sound_description.file_name[0] == '\0'
+						? nullptr
+						: sounds_cache_.GetSound( sound_description.file_name );
 			}
+
+			Log::Info( "Map sounds loaded: ", sounds_cache_.GetLoadsCount() - loads_count_before );
 		}
+
+		sounds_cache_.RemoveUnusedSounds();
 	}
 
 	ambient_sound_processor_.SetMap( map_data );
@@ -91,6 +91,7 @@ private:
 
 	MapDataConstPtr current_map_data_;
 
+	SoundsCache sounds_cache_;
 	std::array<
 		ISoundDataConstPtr,
 		GameResources::c_max_global_sounds +
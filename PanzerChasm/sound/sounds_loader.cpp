@@ -1,3 +1,4 @@
+#include <cctype>
 #include <cstring>
 
 #include <SDL_audio.h>
@@ -27,10 +28,22 @@ const char* ExtractExtension( const char* const file_path )
 	return file_path + pos + 1u;
 }
 
+// FNV-1a
+uint64_t CalculateContentHash( const Vfs::FileContent& content )
+{
+	uint64_t hash= 14695981039346656037ull;
+	for( const unsigned char c : content )
+	{
+		hash^= c;
+		hash*= 1099511628211ull;
+	}
+	return hash;
+}
+
 class RawPCMSoundData final : public ISoundData
 {
 public:
-	RawPCMSoundData( Vfs::FileContent data )
+	RawPCMSoundData( Vfs::FileView data )
 	{
 		pcm_data_= std::move( data );
 
@@ -43,7 +56,7 @@ public:
 	virtual ~RawPCMSoundData() override {}
 
 private:
-	Vfs::FileContent pcm_data_;
+	Vfs::FileView pcm_data_;
 };
 
 class RawMonsterSoundData final : public ISoundData
@@ -69,7 +82,7 @@ private:
 class WavSoundData final : public ISoundData
 {
 public:
-	WavSoundData( const Vfs::FileContent& data )
+	WavSoundData( const Vfs::FileView& data )
 	{
 		bool ok= false;
 
@@ -137,7 +150,7 @@ private:
 
 ISoundDataConstPtr LoadSound( const char* file_path, Vfs& vfs )
 {
-	Vfs::FileContent file_content= vfs.ReadFile( file_path );
+	Vfs::FileView file_content= vfs.ReadFileView( file_path );
 	if( file_content.empty() )
 	{
 		Log::Warning( "Can not load \"", file_path, "\"" );
@@ -165,6 +178,90 @@ ISoundDataConstPtr LoadRawMonsterSound( const Vfs::FileContent& raw_sound_data )
 	return ISoundDataConstPtr( new RawMonsterSoundData( raw_sound_data ) );
 }
 
+SoundsCache::SoundsCache( const VfsPtr& vfs )
+	: vfs_(vfs)
+{
+	PC_ASSERT( vfs_ != nullptr );
+}
+
+SoundsCache::~SoundsCache()
+{}
+
+ISoundDataConstPtr SoundsCache::GetSound( const char* const file_path )
+{
+	std::string key= file_path;
+	for( char& c : key )
+		c= static_cast<char>( std::toupper( static_cast<unsigned char>(c) ) );
+
+	const auto it= file_sounds_.find( key );
+	if( it != file_sounds_.end() )
+		return it->second;
+
+	// Remember also failed loads, for preventing of repeated loading.
+	ISoundDataConstPtr sound= LoadSound( file_path, *vfs_ );
+	loads_count_++;
+
+	file_sounds_.emplace( std::move(key), sound );
+	return sound;
+}
+
+ISoundDataConstPtr SoundsCache::GetRawMonsterSound( const Vfs::FileContent& raw_sound_data )
+{
+	if( raw_sound_data.empty() )
+		return nullptr;
+
+	const uint64_t hash= CalculateContentHash( raw_sound_data );
+
+	const auto range= raw_sounds_.equal_range( hash );
+	for( auto it= range.first; it != range.second; ++it )
+	{
+		const ISoundData& sound= *it->second;
+		if( sound.GetDataSize() == raw_sound_data.size() &&
+			std::memcmp( sound.data_, raw_sound_data.data(), raw_sound_data.size() ) == 0 )
+			return it->second;
+	}
+
+	ISoundDataConstPtr sound= LoadRawMonsterSound( raw_sound_data );
+	loads_count_++;
+
+	raw_sounds_.emplace( hash, sound );
+	return sound;
+}
+
+unsigned int SoundsCache::RemoveUnusedSounds()
+{
+	unsigned int removed= 0u;
+
+	for( auto it= file_sounds_.begin(); it != file_sounds_.end(); )
+	{
+		if( it->second.use_count() <= 1 )
+		{
+			it= file_sounds_.erase( it );
+			removed++;
+		}
+		else
+			++it;
+	}
+
+	for( auto it= raw_sounds_.begin(); it != raw_sounds_.end(); )
+	{
+		if( it->second.use_count() <= 1 )
+		{
+			it= raw_sounds_.erase( it );
+			removed++;
+		}
+		else
+			++it;
+	}
+
+	return removed;
+}
+
+unsigned int SoundsCache::GetLoadsCount() const
+{
+	return loads_count_;
+}
+
 } // namespace Sound
 
 } // namespace PanzerChasm
@@ -1,6 +1,10 @@
 #pragma once
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
+#include "../fwd.hpp"
 #include "../vfs.hpp"
 
 namespace PanzerChasm
@@ -39,12 +43,40 @@ public:
 	unsigned int sample_count_;
 };
 
-typedef std::unique_ptr<ISoundData> ISoundDataConstPtr;
+typedef std::shared_ptr<const ISoundData> ISoundDataConstPtr;
 
 
 ISoundDataConstPtr LoadSound( const char* file_path, Vfs& vfs );
 ISoundDataConstPtr LoadRawMonsterSound( const Vfs::FileContent& raw_sound_data );
 
+// Storage for loaded sounds. Same sound is loaded only once and shared between all users.
+// Sounds from files are identified by file path, raw monster sounds - by content.
+class SoundsCache final
+{
+public:
+	explicit SoundsCache( const VfsPtr& vfs );
+	~SoundsCache();
+
+	ISoundDataConstPtr GetSound( const char* file_path );
+	ISoundDataConstPtr GetRawMonsterSound( const Vfs::FileContent& raw_sound_data );
+
+	// Removes sounds, which are used only by cache. Returns number of removed sounds.
+	unsigned int RemoveUnusedSounds();
+
+	// Number of sounds, actually loaded by cache.
+	unsigned int GetLoadsCount() const;
+
+private:
+	const VfsPtr vfs_;
+
+	// Key - file path in upper case.
+	std::unordered_map< std::string, ISoundDataConstPtr > file_sounds_;
+	// Key - content hash. Content is compared with sound data, because hashes may collide.
+	std::unordered_multimap< uint64_t, ISoundDataConstPtr > raw_sounds_;
+
+	unsigned int loads_count_= 0u;
+};
+
 } // namespace Sound
 
 } // namespace PanzerChasm
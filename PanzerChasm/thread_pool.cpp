@@ -0,0 +1,82 @@
+#include "assert.hpp"
+
+#include "thread_pool.hpp"
+
+namespace PanzerChasm
+{
+
+ThreadPool::ThreadPool( unsigned int threads_count )
+{
+	if( threads_count == 0u )
+		threads_count= std::thread::hardware_concurrency();
+	if( threads_count == 0u ) // Can not detect.
+		threads_count= 1u;
+
+	threads_.reserve( threads_count );
+	for( unsigned int i= 0u; i < threads_count; i++ )
+		threads_.emplace_back( [this]{ WorkerLoop(); } );
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock( mutex_ );
+		stop_= true;
+	}
+	tasks_condition_.notify_all();
+
+	for( std::thread& thread : threads_ )
+		thread.join();
+}
+
+unsigned int ThreadPool::GetThreadsCount() const
+{
+	return threads_.size();
+}
+
+void ThreadPool::AddTask( Task task )
+{
+	PC_ASSERT( task != nullptr );
+
+	{
+		std::unique_lock<std::mutex> lock( mutex_ );
+		tasks_.push( std::move(task) );
+	}
+	tasks_condition_.notify_one();
+}
+
+void ThreadPool::WaitAll()
+{
+	std::unique_lock<std::mutex> lock( mutex_ );
+	done_condition_.wait( lock, [this]{ return tasks_.empty() && tasks_in_progress_ == 0u; } );
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while(true)
+	{
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock( mutex_ );
+			tasks_condition_.wait( lock, [this]{ return stop_ || !tasks_.empty(); } );
+
+			if( tasks_.empty() ) // Stop requested and all tasks done.
+				return;
+
+			task= std::move( tasks_.front() );
+			tasks_.pop();
+			tasks_in_progress_++;
+		}
+
+		task();
+
+		{
+			std::unique_lock<std::mutex> lock( mutex_ );
+			tasks_in_progress_--;
+			if( tasks_.empty() && tasks_in_progress_ == 0u )
+				done_condition_.notify_all();
+		}
+	}
+}
+
+} // namespace PanzerChasm
@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace PanzerChasm
+{
+
+// Simple pool of worker threads.
+// Tasks are executed in arbitrary order, so tasks must not depend on each other.
+class ThreadPool final
+{
+public:
+	typedef std::function<void()> Task;
+
+	// If threads count is zero, number of hardware threads is used.
+	explicit ThreadPool( unsigned int threads_count= 0u );
+	~ThreadPool();
+
+	ThreadPool( const ThreadPool& )= delete;
+	ThreadPool& operator=( const ThreadPool& )= delete;
+
+	unsigned int GetThreadsCount() const;
+
+	void AddTask( Task task );
+
+	// Blocks until all added tasks are finished.
+	void WaitAll();
+
+private:
+	void WorkerLoop();
+
+private:
+	std::vector<std::thread> threads_;
+
+	std::mutex mutex_;
+	std::condition_variable tasks_condition_;
+	std::condition_variable done_condition_;
+
+	std::queue<Task> tasks_;
+	unsigned int tasks_in_progress_= 0u;
+	bool stop_= false;
+};
+
+} // namespace PanzerChasm
@@ -21,18 +21,23 @@ struct FileInfoPacked
 };
 #pragma pack(pop)
 
-// Own replacement for nonstandard strncasecmp
-static bool StringEquals( const char* const s0, const char* const s1, const unsigned int max_length )
+namespace
 {
-	unsigned int i= 0;
-	while( s0[i] != '\0' && s1[i] != '\0' && i < max_length )
+
+const unsigned int g_empty_hash_table_cell= ~0u;
+
+} // namespace
+
+// FNV-1a hash. Name must be in upper case.
+static unsigned int NameHash( const char* const name, const unsigned int max_length )
+{
+	unsigned int hash= 2166136261u;
+	for( unsigned int i= 0u; i < max_length && name[i] != '\0'; i++ )
 	{
-		if( std::tolower( s0[i] ) != std::tolower( s1[i] ) )
-			return false;
-		i++;
+		hash^= static_cast<unsigned char>( name[i] );
+		hash*= 16777619u;
 	}
-
-	return i == max_length || s0[i] == s1[i];
+	return hash;
 }
 
 static const char* ExtractFileName( const char* const file_path )
@@ -51,6 +56,20 @@ static const char* ExtractFileName( const char* const file_path )
 	return file_name_pos;
 }
 
+// Converts path to upper case and replaces back slashes with "/".
+static std::string NormalizeAddonFilePath( const char* const file_path )
+{
+	std::string result= file_path;
+	for( char& c : result )
+	{
+		if( c == '\\' )
+			c= '/';
+		else
+			c= static_cast<char>( std::toupper( static_cast<unsigned char>(c) ) );
+	}
+	return result;
+}
+
 static std::string PrepareAddonPath( const char* const addon_path )
 {
 	if( addon_path == nullptr )
@@ -65,53 +84,108 @@ static std::string PrepareAddonPath( const char* const addon_path )
 	return result;
 }
 
+Vfs::FileView::FileView()
+	: data_(nullptr), size_(0u)
+{}
+
+Vfs::FileView::FileView(
+	const unsigned char* const data, const unsigned int size,
+	std::shared_ptr<const void> storage )
+	: data_(data), size_(size), storage_(std::move(storage))
+{}
+
+Vfs::FileView::FileView( const FileContent& content )
+	: data_(content.data()), size_(content.size())
+{}
+
 Vfs::Vfs(
 	const char* archive_file_name,
 	const char* const addon_path )
-	: archive_file_( std::fopen( archive_file_name, "rb" ) )
+	: archive_file_( new MemoryMappedFile( archive_file_name ) )
 	, addon_path_( PrepareAddonPath( addon_path ) )
 {
-	if( archive_file_ == nullptr )
+	if( !archive_file_->IsValid() )
 	{
 		Log::FatalError( "Could not open file \"", archive_file_name, "\"" );
 		return;
 	}
 
-	char header[4];
-	FileRead( archive_file_, header, sizeof(header) );
-	if( std::strncmp( header, "CSid", sizeof(header) ) != 0 )
+	RescanAddon();
+
+	const unsigned char* const archive_data= archive_file_->Data();
+	const unsigned int archive_size= archive_file_->Size();
+
+	const unsigned int c_header_size= 4u + sizeof(unsigned short);
+	if( archive_size < c_header_size ||
+		std::strncmp( reinterpret_cast<const char*>(archive_data), "CSid", 4u ) != 0 )
 	{
 		Log::FatalError( "File \"", archive_file_name, "\" is not \"Chasm: The Rift\" archive" );
 		return;
 	}
 
 	unsigned short files_in_archive_count;
-	FileRead( archive_file_, &files_in_archive_count, sizeof(files_in_archive_count) );
+	std::memcpy( &files_in_archive_count, archive_data + 4u, sizeof(files_in_archive_count) );
+
+	if( c_header_size + files_in_archive_count * sizeof(FileInfoPacked) > archive_size )
+	{
+		Log::FatalError( "File \"", archive_file_name, "\" is broken" );
+		return;
+	}
 
-	std::vector<FileInfoPacked> files_info_packed( files_in_archive_count );
-	FileRead( archive_file_, files_info_packed.data(), files_info_packed.size() * sizeof(FileInfoPacked ) );
+	const FileInfoPacked* const files_info_packed= reinterpret_cast<const FileInfoPacked*>( archive_data + c_header_size );
 
 	virtual_files_.reserve( files_in_archive_count );
 
-	for( const FileInfoPacked& file_info_packed : files_info_packed )
+	for( unsigned int i= 0u; i < files_in_archive_count; i++ )
 	{
-		virtual_files_.emplace_back();
-		VirtualFile& file= virtual_files_.back();
+		const FileInfoPacked& file_info_packed= files_info_packed[i];
 
-		std::memcpy( file.name, file_info_packed.name, file_info_packed.name_length );
-		if( file_info_packed.name_length < sizeof(file.name) )
-			file.name[ file_info_packed.name_length ]= '\0';
+		VirtualFile file;
+
+		std::memset( file.name, 0, sizeof(file.name) );
+		const unsigned int name_length=
+			file_info_packed.name_length < c_max_file_name_length ? file_info_packed.name_length : c_max_file_name_length;
+		for( unsigned int c= 0u; c < name_length; c++ )
+			file.name[c]= static_cast<char>( std::toupper( static_cast<unsigned char>( file_info_packed.name[c] ) ) );
 
 		std::memcpy( &file.size  , &file_info_packed.size  , sizeof(unsigned int) );
 		std::memcpy( &file.offset, &file_info_packed.offset, sizeof(unsigned int) );
+
+		if( file.offset > archive_size || file.size > archive_size - file.offset )
+		{
+			Log::Warning( "File \"", std::string( file.name, name_length ), "\" is out of archive bounds" );
+			continue;
+		}
+
+		virtual_files_.push_back( file );
+	}
+
+	// Build hash table with load factor not greater, than 0.5.
+	unsigned int hash_table_size= 1u;
+	while( hash_table_size < virtual_files_.size() * 2u )
+		hash_table_size<<= 1u;
+
+	files_hash_table_.resize( hash_table_size, g_empty_hash_table_cell );
+	const unsigned int hash_mask= hash_table_size - 1u;
+
+	for( unsigned int i= 0u; i < virtual_files_.size(); i++ )
+	{
+		unsigned int cell= NameHash( virtual_files_[i].name, c_max_file_name_length ) & hash_mask;
+		while( files_hash_table_[cell] != g_empty_hash_table_cell )
+		{
+			// Keep first file for duplicated names, like linear search do.
+			if( std::memcmp( virtual_files_[ files_hash_table_[cell] ].name, virtual_files_[i].name, c_max_file_name_length ) == 0 )
+				break;
+			cell= ( cell + 1u ) & hash_mask;
+		}
+
+		if( files_hash_table_[cell] == g_empty_hash_table_cell )
+			files_hash_table_[cell]= i;
 	}
 }
 
 Vfs::~Vfs()
-{
-	if( archive_file_ != nullptr )
-		std::fclose( archive_file_ );
-}
+{}
 
 Vfs::FileContent Vfs::ReadFile( const char* const file_path ) const
 {
@@ -122,41 +196,133 @@ Vfs::FileContent Vfs::ReadFile( const char* const file_path ) const
 
 void Vfs::ReadFile( const char* const file_path, FileContent& out_file_content ) const
 {
-	// Try read from real file system.
-	if( !addon_path_.empty() )
+	if( ReadAddonFile( file_path, out_file_content ) )
+		return;
+
+	const VirtualFile* const file= FindFile( ExtractFileName( file_path ) );
+	if( file == nullptr )
 	{
-		const std::string fs_file_path= addon_path_ + file_path;
-		std::FILE* const fs_file= std::fopen( fs_file_path.c_str(), "rb" );
-		if( fs_file != nullptr )
+		out_file_content.clear();
+		return;
+	}
+
+	const unsigned char* const data= archive_file_->Data() + file->offset;
+	out_file_content.assign( data, data + file->size );
+}
+
+Vfs::FileView Vfs::ReadFileView( const char* const file_path ) const
+{
+	// Allocate storage for addon file content only if file exists in addon.
+	const std::string addon_file_path= FindAddonFile( file_path );
+	if( !addon_file_path.empty() )
+	{
+		const std::shared_ptr<FileContent> addon_file_content= std::make_shared<FileContent>();
+		if( ReadFileSystemFile( addon_file_path, *addon_file_content ) )
+			return FileView( addon_file_content->data(), addon_file_content->size(), addon_file_content );
+	}
+
+	const VirtualFile* const file= FindFile( ExtractFileName( file_path ) );
+	if( file == nullptr )
+		return FileView();
+
+	return FileView( archive_file_->Data() + file->offset, file->size, archive_file_ );
+}
+
+void Vfs::RescanAddon()
+{
+	if( addon_path_.empty() )
+		return;
+
+	const std::shared_ptr<AddonFilesIndex> index= std::make_shared<AddonFilesIndex>();
+
+	ForEachFileInDirectory(
+		addon_path_.c_str(),
+		[&]( const std::string& relative_file_path )
 		{
-			std::fseek( fs_file, 0, SEEK_END );
-			const unsigned int file_size= std::ftell( fs_file );
-			std::fseek( fs_file, 0, SEEK_SET );
+			// If there are files with names, different only in case, use first.
+			index->emplace( NormalizeAddonFilePath( relative_file_path.c_str() ), addon_path_ + relative_file_path );
+		} );
 
-			out_file_content.resize( file_size );
-			FileRead( fs_file, out_file_content.data(), file_size );
+	Log::Info( "Addon \"", addon_path_, "\" contains ", index->size(), " files" );
 
-			std::fclose( fs_file );
-			return;
-		}
+	std::lock_guard<std::mutex> lock( addon_files_index_mutex_ );
+	addon_files_index_= index;
+}
+
+std::string Vfs::FindAddonFile( const char* const file_path ) const
+{
+	if( addon_path_.empty() )
+		return std::string();
+
+	std::shared_ptr<const AddonFilesIndex> index;
+	{
+		std::lock_guard<std::mutex> lock( addon_files_index_mutex_ );
+		index= addon_files_index_;
 	}
+	if( index == nullptr )
+		return std::string();
 
-	const char* const file_name= ExtractFileName( file_path );
+	const auto it= index->find( NormalizeAddonFilePath( file_path ) );
+	if( it == index->end() )
+		return std::string();
 
-	// TODO - sort virtual_files_ and use binary search
-	for( const VirtualFile& file : virtual_files_ )
+	return it->second;
+}
+
+bool Vfs::ReadAddonFile( const char* const file_path, FileContent& out_file_content ) const
+{
+	// Try read from real file system, only if file exists in addon.
+	const std::string addon_file_path= FindAddonFile( file_path );
+	if( addon_file_path.empty() )
+		return false;
+
+	return ReadFileSystemFile( addon_file_path, out_file_content );
+}
+
+bool Vfs::ReadFileSystemFile( const std::string& fs_file_path, FileContent& out_file_content )
+{
+	std::FILE* const fs_file= std::fopen( fs_file_path.c_str(), "rb" );
+	if( fs_file == nullptr )
+		return false;
+
+	std::fseek( fs_file, 0, SEEK_END );
+	const unsigned int file_size= std::ftell( fs_file );
+	std::fseek( fs_file, 0, SEEK_SET );
+
+	out_file_content.resize( file_size );
+	FileRead( fs_file, out_file_content.data(), file_size );
+
+	std::fclose( fs_file );
+	return true;
+}
+
+const Vfs::VirtualFile* Vfs::FindFile( const char* const file_name ) const
+{
+	char name[ c_max_file_name_length ];
+	std::memset( name, 0, sizeof(name) );
+
+	unsigned int name_length= 0u;
+	while( file_name[ name_length ] != '\0' )
 	{
-		if( !StringEquals( file.name, file_name, 12 ) )
-			continue;
+		if( name_length == c_max_file_name_length )
+			return nullptr; // Too long name - archive can not contain such file.
 
-		out_file_content.resize( file.size );
-		std::fseek( archive_file_, file.offset, SEEK_SET );
-		FileRead( archive_file_, out_file_content.data(), out_file_content.size() );
+		name[ name_length ]= static_cast<char>( std::toupper( static_cast<unsigned char>( file_name[ name_length ] ) ) );
+		name_length++;
+	}
 
-		return;
+	const unsigned int hash_mask= files_hash_table_.size() - 1u;
+	unsigned int cell= NameHash( name, c_max_file_name_length ) & hash_mask;
+	while( files_hash_table_[cell] != g_empty_hash_table_cell )
+	{
+		const VirtualFile& file= virtual_files_[ files_hash_table_[cell] ];
+		if( std::memcmp( file.name, name, c_max_file_name_length ) == 0 )
+			return &file;
+
+		cell= ( cell + 1u ) & hash_mask;
 	}
 
-	out_file_content.clear();
+	return nullptr;
 }
 
 } // namespace PanzerChasm
@@ -1,8 +1,16 @@
 #pragma once
 #include <cstdio>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+namespace ChasmReverse
+{
+class MemoryMappedFile;
+}
+
 namespace PanzerChasm
 {
 
@@ -12,27 +20,78 @@ class Vfs final
 public:
 	typedef std::vector<unsigned char> FileContent;
 
+	// Read-only view of file data, without copying.
+	// Keeps backing storage (archive mapping or content of addon file) alive.
+	// Has container-like interface, like FileContent.
+	class FileView final
+	{
+	public:
+		FileView();
+		FileView( const unsigned char* data, unsigned int size, std::shared_ptr<const void> storage );
+		// Makes view of content, but not own it. Content must outlive the view.
+		explicit FileView( const FileContent& content );
+
+		const unsigned char* data() const { return data_; }
+		unsigned int size() const { return size_; }
+		bool empty() const { return size_ == 0u; }
+
+	private:
+		const unsigned char* data_;
+		unsigned int size_;
+		std::shared_ptr<const void> storage_;
+	};
+
 	explicit Vfs( const char* archive_file_name, const char* addon_path= nullptr );
 	~Vfs();
 
 	FileContent ReadFile( const char* file_path ) const;
 	void ReadFile( const char* file_path, FileContent& out_file_content ) const;
 
+	// Returns empty view, if file not found.
+	FileView ReadFileView( const char* file_path ) const;
+
+	// Addon directory is scanned at construction. Call this, if files in addon directory were added or removed.
+	void RescanAddon();
+
 private:
+	static constexpr unsigned int c_max_file_name_length= 12u;
+
 	struct VirtualFile
 	{
-		char name[12]; // null terminated for names with length (1-11)
+		char name[ c_max_file_name_length ]; // Upper case, padded with zeros.
 		unsigned int offset;
 		unsigned int size;
 	};
 
 	typedef std::vector<VirtualFile> VirtualFiles;
 
+	// Key - path inside addon in upper case, with "/" as separator. Value - path in file system.
+	typedef std::unordered_map< std::string, std::string > AddonFilesIndex;
+
+private:
+	// Returns path in file system, if file exists in addon. Returns empty string otherwise.
+	std::string FindAddonFile( const char* file_path ) const;
+	// Returns false, if addon file not found.
+	bool ReadAddonFile( const char* file_path, FileContent& out_file_content ) const;
+	// Returns false, if file can not be opened.
+	static bool ReadFileSystemFile( const std::string& fs_file_path, FileContent& out_file_content );
+
+	// Returns nullptr, if file not found.
+	const VirtualFile* FindFile( const char* file_name ) const;
+
 private:
-	std::FILE* const archive_file_;
+	const std::shared_ptr<const ChasmReverse::MemoryMappedFile> archive_file_;
 	const std::string addon_path_;
 
+	// Index may be replaced by rescan, while other threads read files.
+	mutable std::mutex addon_files_index_mutex_;
+	std::shared_ptr<const AddonFilesIndex> addon_files_index_;
+
 	VirtualFiles virtual_files_;
+
+	// Open addressing hash table. Contains indeces of virtual files.
+	// Size is power of two.
+	std::vector<unsigned int> files_hash_table_;
 };
 
 } // namespace PanzerChasm